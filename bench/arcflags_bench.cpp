@@ -0,0 +1,111 @@
+// Arc-flag routing with live traffic on a synthetic grid city: how many
+// queries the flags still prune as roads slow down, their latency against
+// plain Dijkstra, and a check that every answer matches Dijkstra's.
+//
+// Build: g++ -std=c++17 -O2 -pthread -o arcflags_bench bench/arcflags_bench.cpp
+// Run:   ./arcflags_bench [gridSide] [pairs] [regions]
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include "../src/arcflags.h"
+#include "bench_util.h"
+
+using namespace std;
+
+// Run every pair with arc flags and with Dijkstra and report one line
+void measure(const string& label, const Graph& graph, const ArcFlags& flags, const vector<pair<int, int>>& pairs)
+{
+    Graph::SearchWorkspace ws;
+    int pruned = 0, wrong = 0;
+    double flagMs = 0, plainMs = 0;
+
+    for (auto [source, dest] : pairs)
+    {
+        bool used;
+        auto t0 = chrono::steady_clock::now();
+        double withFlags = flags.shortestPath(graph, source, dest, ws, &used).second;
+        auto t1 = chrono::steady_clock::now();
+        double plain = graph.shortestPath(source, dest, ws).second;
+        auto t2 = chrono::steady_clock::now();
+
+        pruned += used;
+        flagMs += chrono::duration<double, milli>(t1 - t0).count();
+        plainMs += chrono::duration<double, milli>(t2 - t1).count();
+
+        if (fabs(withFlags - plain) > 1e-9 * max(1.0, plain))
+        {
+            wrong++;
+        }
+    }
+
+    cout << "  " << left << setw(18) << label << ": " << 100.0 * pruned / pairs.size() << "% pruned, arc flags "
+         << flagMs * 1000 / pairs.size() << " us, Dijkstra " << plainMs * 1000 / pairs.size()
+         << " us per query, " << wrong << " wrong" << endl;
+}
+
+int main(int argc, char** argv)
+{
+    int side = argc > 1 ? atoi(argv[1]) : 150;
+    int pairCount = argc > 2 ? atoi(argv[2]) : 300;
+    int regions = argc > 3 ? atoi(argv[3]) : 32;
+
+    mt19937 rng(42);
+    Graph graph;
+    graph.setLogging(false);
+    buildGrid(graph, side, rng);
+
+    ArcFlags flags;
+    flags.build(graph, regions, max(1u, thread::hardware_concurrency()));
+    graph.setTrafficListener([&](int u, int v)
+    {
+        flags.trafficChanged(graph, u, v);
+    });
+
+    vector<pair<int, int>> pairs(pairCount);
+
+    for (auto& p : pairs)
+    {
+        p = {(int)(rng() % (side * side)), (int)(rng() % (side * side))};
+    }
+
+    int roads = 2 * side * (side - 1);
+    cout << "Grid " << side << "x" << side << " (" << roads << " roads), " << flags.regionCount()
+         << " regions, " << pairCount << " pairs" << endl;
+
+    measure("no traffic", graph, flags, pairs);
+
+    // Congestion: roads slowed 1.5x to 3x, a growing share of them
+    uniform_real_distribution<double> slowdown(1.5, 3.0);
+    vector<pair<int, int>> slowed;
+
+    for (double share : {0.001, 0.01, 0.05})
+    {
+        while ((double)slowed.size() < share * roads)
+        {
+            auto road = randomRoad(side, rng);
+            graph.updateTraffic(road.first, road.second, slowdown(rng));
+            slowed.push_back(road);
+        }
+        measure(to_string(slowed.size()) + " roads slowed", graph, flags, pairs);
+    }
+
+    // One road faster than its base time: no region is safe to prune
+    auto faster = randomRoad(side, rng);
+    graph.updateTraffic(faster.first, faster.second, 0.5);
+    measure("+ one road faster", graph, flags, pairs);
+
+    // Back to base time, edge by edge: pruning comes back without a rebuild
+    graph.updateTraffic(faster.first, faster.second, 1.0);
+
+    for (auto [from, to] : slowed)
+    {
+        graph.updateTraffic(from, to, 1.0);
+    }
+    measure("traffic cleared", graph, flags, pairs);
+
+    return 0;
+}
@@ -0,0 +1,93 @@
+// Weighted A* on a synthetic grid city against exact Dijkstra: nodes
+// reached and latency per query for a few epsilon values, the worst ratio
+// of A*'s travel time to the optimum, and a check that it stays within the
+// promised (1 + epsilon).
+//
+// Build: g++ -std=c++17 -O2 -pthread -o astar_bench bench/astar_bench.cpp
+// Run:   ./astar_bench [gridSide] [pairs]
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include "../src/astar.h"
+#include "bench_util.h"
+
+using namespace std;
+
+// Junctions the last search in ws gave a distance to
+int reached(const Graph::SearchWorkspace& ws)
+{
+    return count(ws.stamp.begin(), ws.stamp.end(), ws.round);
+}
+
+int main(int argc, char** argv)
+{
+    int side = argc > 1 ? atoi(argv[1]) : 150;
+    int pairCount = argc > 2 ? atoi(argv[2]) : 300;
+
+    mt19937 rng(42);
+    Graph graph;
+    graph.setLogging(false);
+    buildGrid(graph, side, rng);
+
+    vector<pair<int, int>> pairs(pairCount);
+
+    for (auto& p : pairs)
+    {
+        p = {(int)(rng() % (side * side)), (int)(rng() % (side * side))};
+    }
+
+    // Exact answers and the Dijkstra baseline
+    Graph::SearchWorkspace ws;
+    vector<double> optimum;
+    long plainReached = 0;
+    auto t0 = chrono::steady_clock::now();
+
+    for (auto [source, dest] : pairs)
+    {
+        optimum.push_back(graph.shortestPath(source, dest, ws).second);
+        plainReached += reached(ws);
+    }
+
+    double plainUs = chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count() / pairCount;
+
+    cout << "Grid " << side << "x" << side << ", " << pairCount << " pairs" << endl;
+    cout << "  " << left << setw(12) << "Dijkstra" << ": " << plainReached / pairCount << " nodes reached, "
+         << plainUs << " us per query" << endl;
+
+    WeightedAStar router;
+
+    for (double epsilon : {0.0, 0.1, 0.25, 0.5, 1.0})
+    {
+        long nodes = 0;
+        double us = 0, worst = 1;
+        int broken = 0;
+
+        for (int i = 0; i < pairCount; i++)
+        {
+            auto start = chrono::steady_clock::now();
+            double time = router.shortestPath(graph, pairs[i].first, pairs[i].second, epsilon, ws).second;
+            us += chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+
+            // source == dest returns before touching the workspace
+            nodes += pairs[i].first == pairs[i].second ? 1 : reached(ws);
+
+            if (optimum[i] > 0)
+            {
+                worst = max(worst, time / optimum[i]);
+            }
+            if (time > optimum[i] * (1 + epsilon) + 1e-9 * max(1.0, optimum[i]))
+            {
+                broken++;
+            }
+        }
+
+        cout << "  " << left << setw(12) << ("epsilon " + to_string(epsilon).substr(0, 4)) << ": "
+             << nodes / pairCount << " nodes reached, " << us / pairCount << " us per query, worst ratio "
+             << worst << ", " << broken << " over the bound" << endl;
+    }
+
+    return 0;
+}
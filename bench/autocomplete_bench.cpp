@@ -0,0 +1,91 @@
+// Type-ahead: adaptive radix tree vs the BTree prefix search, top 10
+// completions per query.
+//
+// Build: g++ -std=c++17 -O2 -o autocomplete_bench bench/autocomplete_bench.cpp
+// Run:   ./autocomplete_bench [names] [queries]
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include "../src/btree.h"
+#include "../src/radixtree.h"
+#include "bench_util.h"
+
+using namespace std;
+
+int main(int argc, char** argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    int queryCount = argc > 2 ? atoi(argv[2]) : 100000;
+    const int LIMIT = 10;
+
+    mt19937 rng(42);
+    vector<string> names = makeNames(count, rng);
+
+    // Prefixes of real names, 1 to 12 bytes: short ones match huge ranges
+    vector<string> queries(queryCount);
+
+    for (auto& q : queries)
+    {
+        const string& name = names[rng() % count];
+        q = name.substr(0, 1 + rng() % min<size_t>(12, name.size()));
+    }
+
+    cout << count << " names, " << queryCount << " prefix queries, top " << LIMIT << endl;
+
+    auto start = chrono::steady_clock::now();
+    AdaptiveRadixTree art;
+
+    for (int i = 0; i < count; i++)
+    {
+        art.insert(names[i], i);
+    }
+    double artBuild = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    vector<pair<string, int>> entries;
+
+    for (int i = 0; i < count; i++)
+    {
+        entries.push_back({names[i], i});
+    }
+
+    start = chrono::steady_clock::now();
+    BTree btree;
+    btree.setLogging(false);
+    btree.bulkLoad(move(entries));
+    double btreeBuild = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    cout << "  build    art " << artBuild << " ms, btree (bulk) " << btreeBuild << " ms" << endl;
+    cout << "  memory   art " << art.memoryBytes() / (1 << 20) << " MB, btree "
+         << btree.memoryBytes() / (1 << 20) << " MB" << endl;
+
+    vector<double> artMicros, btreeMicros;
+    long checksum = 0;
+
+    for (auto& q : queries)
+    {
+        auto t0 = chrono::steady_clock::now();
+        int found = 0;
+
+        art.complete(q, "", [&](const string&, const vector<uint32_t>& values)
+        {
+            checksum += values[0];
+            return ++found < LIMIT;
+        });
+
+        auto t1 = chrono::steady_clock::now();
+        BTree::PrefixPage page = btree.searchByPrefix(q, LIMIT, "");
+        auto t2 = chrono::steady_clock::now();
+
+        checksum += page.matches.size();
+        artMicros.push_back(chrono::duration<double, micro>(t1 - t0).count());
+        btreeMicros.push_back(chrono::duration<double, micro>(t2 - t1).count());
+    }
+
+    report("art  ", artMicros);
+    report("btree", btreeMicros);
+    cout << "  (checksum " << checksum << ")" << endl;
+
+    return 0;
+}
@@ -0,0 +1,82 @@
+// Batch routing throughput on a synthetic grid city.
+//
+// Build: g++ -std=c++17 -O2 -pthread -o batch_path_bench bench/batch_path_bench.cpp
+// Run:   ./batch_path_bench [gridSide] [pairs]
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include "../src/graph.h"
+#include "../src/workerpool.h"
+#include "bench_util.h"
+
+using namespace std;
+
+int main(int argc, char** argv)
+{
+    int side = argc > 1 ? atoi(argv[1]) : 200;
+    int pairCount = argc > 2 ? atoi(argv[2]) : 2000;
+
+    mt19937 rng(42);
+    Graph graph;
+    graph.setLogging(false);
+    buildGrid(graph, side, rng);
+
+    uniform_int_distribution<int> node(0, side * side - 1);
+    vector<pair<int, int>> pairs(pairCount);
+
+    for (auto& p : pairs)
+    {
+        p = {node(rng), node(rng)};
+    }
+
+    cout << "Grid " << side << "x" << side << ", " << pairCount << " pairs" << endl;
+
+    unsigned maxThreads = max(1u, thread::hardware_concurrency());
+    double baseline = 0;
+
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        WorkerPool pool(threads);
+        vector<Graph::SearchWorkspace> workspaces(threads);
+        vector<double> results(pairCount);
+        atomic<int> remaining(pairCount);
+        const int chunk = 32;
+
+        auto start = chrono::steady_clock::now();
+
+        for (int begin = 0; begin < pairCount; begin += chunk)
+        {
+            int end = min(pairCount, begin + chunk);
+
+            pool.submit([&, begin, end](size_t worker)
+            {
+                for (int i = begin; i < end; i++)
+                {
+                    results[i] = graph.shortestPath(pairs[i].first, pairs[i].second, workspaces[worker]).second;
+                }
+                remaining -= end - begin;
+            });
+        }
+
+        while (remaining > 0)
+        {
+            this_thread::yield();
+        }
+
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        double rate = pairCount / seconds;
+
+        if (threads == 1)
+        {
+            baseline = rate;
+        }
+
+        cout << "  threads=" << threads
+             << "  pairs/s=" << (long long)rate
+             << "  speedup=" << rate / baseline << "x" << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,108 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "../src/graph.h"
+using namespace std;
+
+// Fixtures and reporting shared by the benches in this directory
+
+// Junction- and road-like names: a shared area word, a road word and a
+// unique number, shuffled
+inline vector<string> makeNames(int count, mt19937& rng)
+{
+    static const char* areas[] = {"Gulberg", "Model Town", "Johar Town", "DHA Phase", "Township",
+                                  "Iqbal Town", "Garden Town", "Faisal Town", "Cantt", "Samanabad"};
+    static const char* kinds[] = {"Chowk", "Road", "Underpass", "Interchange", "Market", "Block"};
+
+    vector<string> names;
+    names.reserve(count);
+
+    for (int i = 0; i < count; i++)
+    {
+        names.push_back(string(areas[rng() % 10]) + " " + kinds[rng() % 6] + " " + to_string(i));
+    }
+    shuffle(names.begin(), names.end(), rng);
+    return names;
+}
+
+// Names for word search: a few very common words, a long tail of rarer
+// ones, and a number shared by many names
+inline vector<string> makeWordyNames(int count, mt19937& rng)
+{
+    static const char* areas[] = {"Gulberg", "Model Town", "Johar Town", "DHA Phase", "Township",
+                                  "Iqbal Town", "Garden Town", "Faisal Town", "Cantt", "Samanabad"};
+    static const char* kinds[] = {"Chowk", "Road", "Underpass", "Interchange", "Market", "Block"};
+    static const char* syllables[] = {"ka", "li", "ber", "ty", "mal", "sha", "din", "ja", "il", "fe",
+                                      "roz", "pur", "ra", "vi", "kot", "lak", "pat", "bagh", "an", "mo"};
+
+    vector<string> names;
+    names.reserve(count);
+
+    for (int i = 0; i < count; i++)
+    {
+        string word = string(syllables[rng() % 20]) + syllables[rng() % 20] + syllables[rng() % 20];
+        names.push_back(string(areas[rng() % 10]) + " " + word + " " + kinds[rng() % 6] + " " + to_string(i % 5000));
+    }
+    return names;
+}
+
+inline double msSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// Grid city with slightly randomized travel times so paths are not all
+// ties; every arterial-th row and column (if any) is three times faster
+inline void buildGrid(Graph& graph, int side, mt19937& rng, int arterial = 0)
+{
+    uniform_real_distribution<double> time(1.0, 3.0);
+
+    for (int r = 0; r < side; r++)
+    {
+        for (int c = 0; c < side; c++)
+        {
+            int id = r * side + c;
+            graph.setLocation(id, 31.4 + r * 0.001, 74.2 + c * 0.001);
+
+            if (c + 1 < side)
+            {
+                graph.addEdge(id, id + 1, 0.5, time(rng) / (arterial && r % arterial == 0 ? 3 : 1));
+            }
+
+            if (r + 1 < side)
+            {
+                graph.addEdge(id, id + side, 0.5, time(rng) / (arterial && c % arterial == 0 ? 3 : 1));
+            }
+        }
+    }
+}
+
+// A random road of buildGrid()'s grid as (from, to)
+inline pair<int, int> randomRoad(int side, mt19937& rng)
+{
+    int r = rng() % side;
+    int c = rng() % (side - 1);
+
+    if (rng() % 2)
+    {
+        return {r * side + c, r * side + c + 1};
+    }
+    return {c * side + r, (c + 1) * side + r};
+}
+
+// p50 / p99 / max of per-query latencies in microseconds
+inline void report(const char* label, vector<double> micros)
+{
+    sort(micros.begin(), micros.end());
+    cout << "  " << label << ": p50 " << micros[micros.size() / 2]
+         << " us, p99 " << micros[micros.size() * 99 / 100]
+         << " us, max " << micros.back() << " us" << endl;
+}
+
+#endif
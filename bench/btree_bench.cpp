@@ -0,0 +1,118 @@
+// Name index: B+tree BTree vs std::map<string, int> (the previous BTree).
+//
+// Build: g++ -std=c++17 -O2 -o btree_bench bench/btree_bench.cpp
+// Run:   ./btree_bench [names] [lookups]
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <random>
+#include "../src/btree.h"
+#include "bench_util.h"
+
+using namespace std;
+
+int main(int argc, char** argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    int lookups = argc > 2 ? atoi(argv[2]) : 1000000;
+
+    mt19937 rng(42);
+    vector<string> names = makeNames(count, rng);
+    vector<string> queries(lookups);
+
+    for (auto& q : queries)
+    {
+        q = names[rng() % count];
+    }
+
+    cout << count << " names, " << lookups << " lookups" << endl;
+    long checksum = 0;
+
+    // --- std::map ---
+    auto start = chrono::steady_clock::now();
+    map<string, int> tree;
+
+    for (int i = 0; i < count; i++)
+    {
+        tree[names[i]] = i;
+    }
+    double mapInsert = msSince(start);
+
+    start = chrono::steady_clock::now();
+    for (auto& q : queries)
+    {
+        auto it = tree.find(q);
+        checksum += it == tree.end() ? -1 : it->second;
+    }
+    double mapSearch = msSince(start);
+
+    start = chrono::steady_clock::now();
+    for (auto& [name, id] : tree)
+    {
+        checksum += name.size() + id;
+    }
+    double mapScan = msSince(start);
+
+    // --- B+tree, one insert at a time ---
+    start = chrono::steady_clock::now();
+    BTree btree;
+    btree.setLogging(false);
+
+    for (int i = 0; i < count; i++)
+    {
+        btree.insert(names[i], i);
+    }
+    double btreeInsert = msSince(start);
+
+    // --- B+tree, bulk load (sorting included) ---
+    vector<pair<string, int>> entries;
+    entries.reserve(count);
+
+    for (int i = 0; i < count; i++)
+    {
+        entries.push_back({names[i], i});
+    }
+
+    start = chrono::steady_clock::now();
+    BTree bulk;
+    bulk.setLogging(false);
+    bulk.bulkLoad(move(entries));
+    double bulkLoad = msSince(start);
+
+    start = chrono::steady_clock::now();
+    for (auto& q : queries)
+    {
+        checksum += bulk.search(q);
+    }
+    double btreeSearch = msSince(start);
+
+    start = chrono::steady_clock::now();
+    bulk.scanFrom("", [&](const string& name, int id)
+    {
+        checksum += name.size() + id;
+        return true;
+    });
+    double btreeScan = msSince(start);
+
+    // Rough std::map footprint: one node (links, colour, key, value) plus
+    // the string's heap buffer when it does not fit inline
+    size_t mapBytes = 0;
+    for (auto& [name, id] : tree)
+    {
+        mapBytes += 32 + sizeof(string) + sizeof(int) + 4 + (name.size() > 15 ? name.size() + 1 : 0);
+    }
+
+    cout << "  insert   std::map " << mapInsert << " ms, btree " << btreeInsert
+         << " ms, btree bulk load " << bulkLoad << " ms" << endl;
+    cout << "  search   std::map " << mapSearch * 1e6 / lookups << " ns/op, btree "
+         << btreeSearch * 1e6 / lookups << " ns/op" << endl;
+    cout << "  scan     std::map " << mapScan << " ms, btree " << btreeScan << " ms" << endl;
+    cout << "  memory   std::map ~" << mapBytes / (1 << 20) << " MB, btree "
+         << bulk.memoryBytes() / (1 << 20) << " MB (bulk), "
+         << btree.memoryBytes() / (1 << 20) << " MB (inserted)" << endl;
+    cout << "  (checksum " << checksum << ")" << endl;
+
+    return 0;
+}
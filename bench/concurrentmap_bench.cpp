@@ -0,0 +1,141 @@
+// Junction lookups under concurrent updates: ConcurrentJunctionMap vs
+// HashTable behind a shared_mutex.
+//
+// Build: g++ -std=c++17 -O2 -pthread -o concurrentmap_bench bench/concurrentmap_bench.cpp
+// Run:   ./concurrentmap_bench [junctions] [readers] [secondsPerPhase]
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+#include "../src/concurrentmap.h"
+#include "../src/hashtable.h"
+
+using namespace std;
+
+// Readers look up random IDs for `seconds`; if `writing`, one more thread
+// renames random junctions as fast as it can. Returns {reads/s, writes/s}.
+template <typename Read, typename Write>
+pair<double, double> phase(int count, int readers, double seconds, bool writing, Read read, Write write)
+{
+    atomic<bool> stop{false};
+    atomic<long> reads{0};
+    atomic<long> writes{0};
+    vector<thread> threads;
+
+    for (int r = 0; r < readers; r++)
+    {
+        threads.emplace_back([&, r]
+        {
+            mt19937 rng(r + 1);
+            uniform_int_distribution<int> id(0, count - 1);
+            long done = 0;
+            long checksum = 0;
+
+            while (!stop.load(memory_order_relaxed))
+            {
+                for (int i = 0; i < 256; i++)
+                {
+                    checksum += read(id(rng));
+                }
+                done += 256;
+            }
+
+            reads += done + (checksum == -1);
+        });
+    }
+
+    if (writing)
+    {
+        threads.emplace_back([&]
+        {
+            mt19937 rng(99);
+            uniform_int_distribution<int> id(0, count - 1);
+            long done = 0;
+
+            while (!stop.load(memory_order_relaxed))
+            {
+                write(id(rng), done);
+                done++;
+            }
+
+            writes += done;
+        });
+    }
+
+    this_thread::sleep_for(chrono::duration<double>(seconds));
+    stop = true;
+
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    return {reads / seconds, writes / seconds};
+}
+
+int main(int argc, char** argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 100000;
+    int readers = argc > 2 ? atoi(argv[2]) : max(1u, thread::hardware_concurrency());
+    double seconds = argc > 3 ? atof(argv[3]) : 2.0;
+
+    cout << count << " junctions, " << readers << " reader threads, "
+         << seconds << " s per phase" << endl;
+
+    StringPool names;
+    ConcurrentJunctionMap map(names);
+    HashTable table;
+    shared_mutex tableLock;
+    table.setLogging(false);
+
+    for (int id = 0; id < count; id++)
+    {
+        Junction j(id, "Junction " + to_string(id), 31.5, 74.3);
+        map.insert(j);
+        table.insert(j);
+    }
+
+    auto mapRead = [&](int id)
+    {
+        JunctionHandle j = map.find(id);
+        return j ? (long)j->name.size() : 0L;
+    };
+
+    auto mapWrite = [&](int id, long n)
+    {
+        map.insert(Junction(id, "Renamed " + to_string(n % count), 31.5, 74.3));  // names are interned for good
+    };
+
+    auto tableRead = [&](int id)
+    {
+        shared_lock<shared_mutex> guard(tableLock);
+        Junction* j = table.search(id);
+        return j ? (long)j->name.size() : 0L;
+    };
+
+    auto tableWrite = [&](int id, long n)
+    {
+        unique_lock<shared_mutex> guard(tableLock);
+        table.insert(Junction(id, "Renamed " + to_string(n), 31.5, 74.3));
+    };
+
+    auto report = [](const char* label, pair<double, double> quiet, pair<double, double> busy)
+    {
+        cout << "  " << label << ": " << quiet.first / 1e6 << " M reads/s idle, "
+             << busy.first / 1e6 << " M reads/s with " << busy.second / 1e3
+             << " k writes/s (" << 100.0 * busy.first / quiet.first << "%)" << endl;
+    };
+
+    report("concurrent map     ",
+           phase(count, readers, seconds, false, mapRead, mapWrite),
+           phase(count, readers, seconds, true, mapRead, mapWrite));
+
+    report("hashtable + rwlock ",
+           phase(count, readers, seconds, false, tableRead, tableWrite),
+           phase(count, readers, seconds, true, tableRead, tableWrite));
+
+    return 0;
+}
@@ -0,0 +1,120 @@
+// Typo-tolerant search latency: trigram candidates + Myers verification.
+//
+// Build: g++ -std=c++17 -O2 -o fuzzy_bench bench/fuzzy_bench.cpp
+// Run:   ./fuzzy_bench [names] [queries]
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include "../src/fuzzyindex.h"
+
+using namespace std;
+
+// Two invented place words and a road kind, e.g. "Kelabor Mistan Chowk".
+// Words are 2-3 consonant-vowel(-consonant) syllables from a 40k vocabulary.
+vector<string> makeNames(int count, mt19937& rng)
+{
+    static const char consonants[] = "bdfghjklmnprstvwyz";
+    static const char vowels[] = "aeiou";
+    static const char* kinds[] = {"Chowk", "Road", "Underpass", "Interchange", "Market", "Block"};
+
+    vector<string> words(40000);
+
+    for (auto& w : words)
+    {
+        int syllables = 2 + rng() % 2;
+
+        for (int i = 0; i < syllables; i++)
+        {
+            w += consonants[rng() % 18];
+            w += vowels[rng() % 5];
+
+            if (rng() % 2)
+            {
+                w += consonants[rng() % 18];
+            }
+        }
+        w[0] = toupper(w[0]);
+    }
+
+    vector<string> names(count);
+
+    for (auto& name : names)
+    {
+        name = words[rng() % words.size()] + " " + words[rng() % words.size()] + " " + kinds[rng() % 6];
+    }
+    return names;
+}
+
+// One random substitution, insertion, deletion or transposition (a
+// transposition is two edits, so two typos may exceed the edit budget)
+string typo(string s, mt19937& rng)
+{
+    size_t i = rng() % s.size();
+
+    switch (rng() % 4)
+    {
+        case 0: s[i] = 'a' + rng() % 26; break;
+        case 1: s.insert(s.begin() + i, 'a' + rng() % 26); break;
+        case 2: s.erase(s.begin() + i); break;
+        default: if (i + 1 < s.size()) swap(s[i], s[i + 1]); break;
+    }
+    return s;
+}
+
+int main(int argc, char** argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    int queryCount = argc > 2 ? atoi(argv[2]) : 20000;
+
+    mt19937 rng(7);
+    vector<string> names = makeNames(count, rng);
+
+    auto start = chrono::steady_clock::now();
+    FuzzyIndex index;
+
+    for (int i = 0; i < count; i++)
+    {
+        index.add(names[i], i);
+    }
+    double build = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << count << " names: built in " << build << " s, "
+         << index.memoryBytes() / (1 << 20) << " MB" << endl;
+
+    for (int typos = 0; typos <= 2; typos++)
+    {
+        vector<double> micros;
+        long found = 0, hits = 0;
+
+        for (int q = 0; q < queryCount; q++)
+        {
+            const string& target = names[rng() % count];
+            string query = target;
+
+            for (int t = 0; t < typos; t++)
+            {
+                query = typo(query, rng);
+            }
+
+            auto t0 = chrono::steady_clock::now();
+            vector<FuzzyIndex::Match> matches = index.search(query, FuzzyIndex::editBudget(query), 10);
+            micros.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count());
+
+            hits += matches.size();
+            found += any_of(matches.begin(), matches.end(), [&](const FuzzyIndex::Match& m)
+            {
+                return names[m.value] == target;
+            });
+        }
+
+        sort(micros.begin(), micros.end());
+        cout << "  " << typos << " typo(s): p50 " << micros[micros.size() / 2]
+             << " us, p99 " << micros[micros.size() * 99 / 100]
+             << " us, max " << micros.back() << " us; target found "
+             << 100.0 * found / queryCount << "%, " << (double)hits / queryCount << " hits/query" << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,151 @@
+// Junction lookup: Swiss-table HashTable vs the old fixed-size chaining table.
+//
+// Build: g++ -std=c++17 -O2 -o hashtable_bench bench/hashtable_bench.cpp
+// Run:   ./hashtable_bench [junctions] [lookups]
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <list>
+#include <random>
+#include "../src/hashtable.h"
+
+using namespace std;
+
+// The previous src/hashtable.h table (100 buckets of std::list), with its
+// per-call cout removed so only the data structure is measured
+class ChainingHashTable
+{
+
+private:
+    static const int TABLE_SIZE = 100;
+    vector<list<Junction>> table;
+    int elementCount;
+
+    int hashFunction(int key)
+    {
+        return key % TABLE_SIZE;
+    }
+
+public:
+    ChainingHashTable() : table(TABLE_SIZE), elementCount(0) {}
+
+    void setLogging(bool) {}
+
+    void insert(const Junction& junction)
+    {
+        int index = hashFunction(junction.id);
+
+        for (auto& j : table[index])
+        {
+            if (j.id == junction.id)
+            {
+                j = junction;
+                return;
+            }
+        }
+
+        table[index].push_back(junction);
+        elementCount++;
+    }
+
+    Junction* search(int id)
+    {
+        int index = hashFunction(id);
+
+        for (auto& j : table[index])
+        {
+            if (j.id == id)
+            {
+                return &j;
+            }
+        }
+
+        return nullptr;
+    }
+
+    int size() const
+    {
+        return elementCount;
+    }
+};
+
+template <typename Table>
+void run(const char* label, const vector<int>& ids, const vector<int>& queries)
+{
+    auto start = chrono::steady_clock::now();
+    Table table;
+    table.setLogging(false);
+
+    for (int id : ids)
+    {
+        table.insert(Junction(id, "J", 31.5, 74.3));
+    }
+
+    auto built = chrono::steady_clock::now();
+    long found = 0;
+
+    for (int id : queries)
+    {
+        found += table.search(id) != nullptr;
+    }
+
+    auto done = chrono::steady_clock::now();
+    double insertMs = chrono::duration<double, milli>(built - start).count();
+    double lookupNs = chrono::duration<double, nano>(done - built).count() / queries.size();
+
+    cout << "  " << label << ": insert " << insertMs << " ms, lookup "
+         << lookupNs << " ns/op (" << found << " hits)" << endl;
+}
+
+int main(int argc, char** argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 100000;
+    int lookups = argc > 2 ? atoi(argv[2]) : 1000000;
+
+    mt19937 rng(42);
+    vector<int> ids(count);
+
+    for (int i = 0; i < count; i++)
+    {
+        ids[i] = i * 7 + 1;
+    }
+    shuffle(ids.begin(), ids.end(), rng);
+
+    // Half hits, half misses
+    uniform_int_distribution<int> pick(0, count - 1);
+    vector<int> queries(lookups);
+
+    for (int i = 0; i < lookups; i++)
+    {
+        queries[i] = i % 2 ? ids[pick(rng)] : ids[pick(rng)] + 3;
+    }
+
+    cout << count << " junctions, " << lookups << " lookups" << endl;
+
+    // Every probe of the chained table walks ~count/100 list nodes, so its
+    // build is quadratic; keep its share of the run bounded
+    if (count <= 200000)
+    {
+        vector<int> chainedQueries(queries.begin(), queries.begin() + min<size_t>(lookups, 20000000 / max(1, count / 100)));
+        run<ChainingHashTable>("chaining (100 buckets)", ids, chainedQueries);
+    }
+    else
+    {
+        cout << "  chaining (100 buckets): skipped above 200000 junctions" << endl;
+    }
+
+    run<BasicHashTable<>>("swiss table", ids, queries);
+
+    // Pluggable hash: plain identity, to show what the default mixer buys
+    struct IdentityHash
+    {
+        uint64_t operator()(int id) const
+        {
+            return (uint64_t)id << 7 | (id & 0x7f);
+        }
+    };
+    run<BasicHashTable<IdentityHash>>("swiss table, identity hash", ids, queries);
+
+    return 0;
+}
@@ -0,0 +1,169 @@
+// GET /api/junctions requests per second: reading and re-serializing
+// data/junctions.json per request (as before) vs a prepared Payload,
+// plain, gzip, br and revalidated with If-None-Match (304), and vs
+// compressing the same body again on every request. Server and clients
+// run in this process over loopback.
+//
+// Build: g++ -std=c++17 -O2 -pthread -DHAVE_ZLIB -DHAVE_BROTLI -o junctions_bench bench/junctions_bench.cpp -lz -lbrotlienc
+// Run:   ./junctions_bench [junctions] [clients] [secondsPerPhase]
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include "../include/httplib.h"
+#include "../include/json.hpp"
+#include "../src/payload.h"
+
+using namespace std;
+using json = nlohmann::json;
+
+// Requests per second from `clients` keep-alive connections for `seconds`
+double phase(int port, const string& path, const httplib::Headers& headers, int clients, double seconds,
+             int expectedStatus)
+{
+    atomic<bool> stop{false};
+    atomic<long> done{0};
+    atomic<long> failed{0};
+    vector<thread> threads;
+
+    for (int t = 0; t < clients; t++)
+    {
+        threads.emplace_back([&]
+        {
+            httplib::Client client("127.0.0.1", port);
+            client.set_keep_alive(true);
+            client.set_decompress(false);
+
+            while (!stop.load(memory_order_relaxed))
+            {
+                auto res = client.Get(path, headers);
+
+                if (!res || res->status != expectedStatus)
+                {
+                    failed++;
+                }
+                done++;
+            }
+        });
+    }
+
+    this_thread::sleep_for(chrono::duration<double>(seconds));
+    stop = true;
+
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    if (failed)
+    {
+        cout << "  (" << failed << " unexpected responses)" << endl;
+    }
+    return done / seconds;
+}
+
+int main(int argc, char** argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 10000;
+    int clients = argc > 2 ? atoi(argv[2]) : 4;
+    double seconds = argc > 3 ? atof(argv[3]) : 2.0;
+    string file = "/tmp/junctions_bench.json";
+
+    mt19937 rng(42);
+    json junctions = json::array();
+
+    for (int id = 1; id <= count; id++)
+    {
+        junctions.push_back({
+            {"id", id},
+            {"name", "Junction " + to_string(id)},
+            {"lat", 31.4 + (rng() % 100000) / 500000.0},
+            {"lng", 74.2 + (rng() % 100000) / 500000.0}
+        });
+    }
+    ofstream(file) << json{{"junctions", junctions}}.dump(2);
+
+    auto payload = make_shared<const Payload>(json{{"junctions", junctions}}.dump());
+    mutex payloadLock;
+
+    httplib::Server server;
+
+    server.Get("/reparse", [&](const httplib::Request&, httplib::Response& res)
+    {
+        json response;
+        response["junctions"] = json::array();
+        ifstream in(file);
+        json data;
+        in >> data;
+        response["junctions"] = data["junctions"];
+        res.set_content(response.dump(), "application/json");
+    });
+
+    server.Get("/prepared", [&](const httplib::Request& req, httplib::Response& res)
+    {
+        shared_ptr<const Payload> current;
+        {
+            lock_guard<mutex> guard(payloadLock);
+            current = payload;
+        }
+
+        Encoding encoding = current->encodingFor(req.get_header_value("Accept-Encoding"));
+        res.set_header("ETag", current->etag(encoding));
+
+        if (Payload::matches(req.get_header_value("If-None-Match"), current->etag(encoding)))
+        {
+            res.status = 304;
+            return;
+        }
+
+        if (encoding != Encoding::IDENTITY)
+        {
+            res.set_header("Content-Encoding", Compression::name(encoding));
+        }
+        res.set_content(current->body(encoding), "application/json");
+    });
+
+    server.Get("/compress", [&](const httplib::Request& req, httplib::Response& res)
+    {
+        Encoding encoding = Compression::negotiate(req.get_header_value("Accept-Encoding"));
+        res.set_header("Content-Encoding", Compression::name(encoding));
+        res.set_content(Compression::compress(payload->body(), encoding), "application/json");
+    });
+
+    int port = server.bind_to_any_port("127.0.0.1");
+    thread serving([&] { server.listen_after_bind(); });
+    server.wait_until_ready();
+
+    cout << count << " junctions: " << payload->body().size() / 1024 << " KB plain, "
+         << payload->body(Encoding::GZIP).size() / 1024 << " KB gzip, "
+         << payload->body(Encoding::BROTLI).size() / 1024 << " KB br; " << clients << " clients, " << seconds
+         << " s per phase" << endl;
+
+    httplib::Headers none;
+    httplib::Headers gzip = {{"Accept-Encoding", "gzip"}};
+    httplib::Headers br = {{"Accept-Encoding", "br"}};
+    httplib::Headers revalidate = {{"If-None-Match", payload->etag()}};
+
+    cout << "  reparse per request: " << phase(port, "/reparse", none, clients, seconds, 200) << " req/s" << endl;
+    cout << "  prepared, plain:     " << phase(port, "/prepared", none, clients, seconds, 200) << " req/s" << endl;
+
+    if (Compression::available(Encoding::GZIP))
+    {
+        cout << "  prepared, gzip:      " << phase(port, "/prepared", gzip, clients, seconds, 200) << " req/s" << endl;
+        cout << "  gzip per request:    " << phase(port, "/compress", gzip, clients, seconds, 200) << " req/s" << endl;
+    }
+    if (Compression::available(Encoding::BROTLI))
+    {
+        cout << "  prepared, br:        " << phase(port, "/prepared", br, clients, seconds, 200) << " req/s" << endl;
+        cout << "  br per request:      " << phase(port, "/compress", br, clients, seconds, 200) << " req/s" << endl;
+    }
+    cout << "  prepared, 304:       " << phase(port, "/prepared", revalidate, clients, seconds, 304) << " req/s" << endl;
+
+    server.stop();
+    serving.join();
+    return 0;
+}
@@ -0,0 +1,216 @@
+// Import of a large junction and road file into the name holders the
+// server keeps as plain strings elsewhere: the junction map (junctionMeta),
+// the live name skip list (liveNames) and the road records. "Interned"
+// holds views and handles into one StringPool; "std::string per holder"
+// holds what they held before, a string in each junction record, in each
+// skip list node and in each road segment. Both use the same record
+// shapes, so the difference is the names alone; a last run builds the
+// server's own structures (with their locking and snapshots). Counts heap
+// allocations and live heap bytes by replacing the global operator new.
+// (The search indexes keep their own compressed or folded key layouts and
+// are the same either way, so they are left out.)
+//
+// Build: g++ -std=c++17 -O2 -pthread -o load_bench bench/load_bench.cpp
+// Run:   ./load_bench [junctions] [roadSegments]
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include "../src/concurrentmap.h"
+#include "../src/skiplist.h"
+#include "../src/stringpool.h"
+
+using namespace std;
+
+static size_t allocations = 0;
+static size_t liveBytes = 0;
+
+// Each block carries its size in front, so deletes can be counted too
+void* operator new(size_t size)
+{
+    size_t* p = (size_t*)malloc(size + 16);
+
+    if (!p)
+    {
+        throw bad_alloc();
+    }
+    allocations++;
+    liveBytes += size;
+    *p = size;
+    return (char*)p + 16;
+}
+
+void operator delete(void* p) noexcept
+{
+    if (p)
+    {
+        size_t* block = (size_t*)((char*)p - 16);
+        liveBytes -= *block;
+        free(block);
+    }
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    operator delete(p);
+}
+
+// A skip list node as it was, with its own copy of the key, and as it is
+struct StringNode
+{
+    string key;
+    atomic<int> value;
+    int height;
+    void* next[2];
+};
+
+struct PooledNode
+{
+    string_view key;
+    atomic<int> value;
+    int height;
+    void* next[2];
+};
+
+struct Segment
+{
+    int from, to;
+    string name;
+};
+
+struct PooledSegment
+{
+    int from, to;
+    uint32_t name;
+};
+
+int main(int argc, char** argv)
+{
+    int junctions = argc > 1 ? atoi(argv[1]) : 200000;
+    int segments = argc > 2 ? atoi(argv[2]) : 1000000;
+
+    static const char* areas[] = {"Gulberg", "Model Town", "Johar Town", "DHA Phase", "Township",
+                                  "Iqbal Town", "Garden Town", "Faisal Town", "Cantt", "Samanabad"};
+    static const char* kinds[] = {"Chowk", "Underpass", "Interchange", "Market", "Roundabout"};
+
+    // The import as parsed: every record carries its own name. Junction
+    // names repeat now and then; a road's name repeats on every segment.
+    mt19937 rng(42);
+    vector<string> junctionNames, roadNames;
+
+    for (int i = 0; i < junctions; i++)
+    {
+        junctionNames.push_back(string(areas[rng() % 10]) + " " + kinds[rng() % 5] + " " + to_string(rng() % (junctions / 2)));
+    }
+
+    int roads = max(1, segments / 50);
+
+    for (int i = 0; i < segments; i++)
+    {
+        int road = rng() % roads;
+        roadNames.push_back(string(areas[road % 10]) + " Main Boulevard " + to_string(road));
+    }
+
+    // An empty name (a junction with "name": "") may come first
+    {
+        StringPool pool;
+        uint32_t empty = pool.intern("");
+
+        if (!pool.view(empty).empty() || pool.intern("") != empty || pool.view(pool.intern("x")) != "x")
+        {
+            cout << "StringPool: empty string mishandled" << endl;
+            return 1;
+        }
+    }
+
+    cout << junctions << " junctions, " << segments << " road segments on " << roads << " roads" << endl;
+
+    // Numbers since `start`, taken while what was built is still alive
+    auto report = [&](const char* label, size_t allocationsBefore, size_t bytesBefore,
+                      chrono::steady_clock::time_point start)
+    {
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << "  " << label << ": " << ms << " ms, " << allocations - allocationsBefore << " allocations, "
+             << (liveBytes - bytesBefore) / (1 << 20) << " MB live" << endl;
+    };
+
+    size_t checksum = 0;
+
+    {
+        size_t allocationsBefore = allocations, bytesBefore = liveBytes;
+        auto start = chrono::steady_clock::now();
+        vector<shared_ptr<const Junction>> records;
+        vector<unique_ptr<StringNode>> nodes;
+        vector<Segment> roadRecords;
+
+        for (int i = 0; i < junctions; i++)
+        {
+            records.push_back(make_shared<const Junction>(i, junctionNames[i], 31.5, 74.3));
+            nodes.push_back(unique_ptr<StringNode>(new StringNode{junctionNames[i], {i}, 1, {}}));
+        }
+
+        for (int i = 0; i < segments; i++)
+        {
+            roadRecords.push_back({i, i + 1, roadNames[i]});
+        }
+
+        report("std::string per holder", allocationsBefore, bytesBefore, start);
+        checksum += records.back()->name.size() + nodes.back()->key.size() + roadRecords.back().name.size();
+    }
+
+    {
+        size_t allocationsBefore = allocations, bytesBefore = liveBytes;
+        auto start = chrono::steady_clock::now();
+        StringPool pool;
+        vector<shared_ptr<const JunctionRecord>> records;
+        vector<unique_ptr<PooledNode>> nodes;
+        vector<PooledSegment> roadRecords;
+
+        for (int i = 0; i < junctions; i++)
+        {
+            string_view name = pool.view(pool.intern(junctionNames[i]));
+            records.push_back(make_shared<const JunctionRecord>(JunctionRecord{i, name, 31.5, 74.3}));
+            nodes.push_back(unique_ptr<PooledNode>(new PooledNode{name, {i}, 1, {}}));
+        }
+
+        for (int i = 0; i < segments; i++)
+        {
+            roadRecords.push_back({i, i + 1, pool.intern(roadNames[i])});
+        }
+
+        report("interned (StringPool) ", allocationsBefore, bytesBefore, start);
+        cout << "    " << pool.size() << " distinct names, " << pool.bytes() / 1024 << " KB of characters" << endl;
+        checksum += records.back()->name.size() + nodes.back()->key.size() + pool.view(roadRecords.back().name).size();
+    }
+
+    {
+        size_t allocationsBefore = allocations, bytesBefore = liveBytes;
+        auto start = chrono::steady_clock::now();
+        StringPool pool;
+        ConcurrentJunctionMap records(pool);
+        ConcurrentSkipList names(pool);
+        vector<PooledSegment> roadRecords;
+
+        for (int i = 0; i < junctions; i++)
+        {
+            records.insert(Junction(i, junctionNames[i], 31.5, 74.3));
+            names.assign(junctionNames[i], i);
+        }
+
+        for (int i = 0; i < segments; i++)
+        {
+            roadRecords.push_back({i, i + 1, pool.intern(roadNames[i])});
+        }
+
+        report("server structures     ", allocationsBefore, bytesBefore, start);
+        checksum += records.find(junctions - 1)->name.size() + pool.view(roadRecords.back().name).size();
+    }
+
+    cout << "  (checksum " << checksum << ")" << endl;
+    return 0;
+}
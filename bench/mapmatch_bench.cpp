@@ -0,0 +1,147 @@
+// Map-matching throughput and accuracy on synthetic GPS traces.
+//
+// Build: g++ -std=c++17 -O2 -o mapmatch_bench bench/mapmatch_bench.cpp
+// Run:   ./mapmatch_bench [gridSide] [traces] [pointsPerTrace]
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include "../src/mapmatcher.h"
+
+using namespace std;
+
+const double SPACING_DEG = 0.002;     // ~200 m between junctions
+const double SAMPLE_KM = 0.04;        // one GPS fix every 40 m
+const double NOISE_KM = 0.01;         // 10 m GPS noise
+
+struct TracePoint
+{
+    GpsPoint gps;
+    int from;       // true road, dense indices with from < to
+    int to;
+};
+
+// Random drive along the grid, sampled at fixed spacing with Gaussian noise
+vector<TracePoint> makeTrace(const Graph& graph, int points, mt19937& rng)
+{
+    uniform_int_distribution<int> startNode(0, graph.nodeCount() - 1);
+    normal_distribution<double> noise(0.0, NOISE_KM);
+    LocalProjection projection(graph.latitude(0));
+    vector<TracePoint> trace;
+
+    int previous = -1;
+    int current = startNode(rng);
+    double carry = 0;   // km already travelled past the last sample
+
+    while ((int)trace.size() < points)
+    {
+        const auto& out = graph.edges(current);
+        int next;
+
+        do
+        {
+            next = out[uniform_int_distribution<int>(0, out.size() - 1)(rng)].to;
+        } while (next == previous && out.size() > 1);
+
+        double lat1 = graph.latitude(current), lng1 = graph.longitude(current);
+        double lat2 = graph.latitude(next), lng2 = graph.longitude(next);
+        double length = haversineKm(lat1, lng1, lat2, lng2);
+
+        for (double at = SAMPLE_KM - carry; at < length && (int)trace.size() < points; at += SAMPLE_KM)
+        {
+            double f = at / length;
+            double lat = lat1 + f * (lat2 - lat1) + noise(rng) / projection.kmPerDegLat;
+            double lng = lng1 + f * (lng2 - lng1) + noise(rng) / projection.kmPerDegLng;
+            trace.push_back({{lat, lng}, min(current, next), max(current, next)});
+            carry = length - at;
+        }
+
+        previous = current;
+        current = next;
+    }
+
+    return trace;
+}
+
+int main(int argc, char** argv)
+{
+    int side = argc > 1 ? atoi(argv[1]) : 200;
+    int traces = argc > 2 ? atoi(argv[2]) : 50;
+    int pointsPerTrace = argc > 3 ? atoi(argv[3]) : 2000;
+
+    mt19937 rng(7);
+    Graph graph;
+    graph.setLogging(false);
+
+    for (int r = 0; r < side; r++)
+    {
+        for (int c = 0; c < side; c++)
+        {
+            graph.setLocation(r * side + c, 31.4 + r * SPACING_DEG, 74.2 + c * SPACING_DEG);
+        }
+    }
+
+    for (int r = 0; r < side; r++)
+    {
+        for (int c = 0; c < side; c++)
+        {
+            int id = r * side + c;
+
+            if (c + 1 < side)
+            {
+                graph.addEdge(id, id + 1, haversineKm(graph.latitude(id), graph.longitude(id),
+                              graph.latitude(id + 1), graph.longitude(id + 1)), 1.0);
+            }
+
+            if (r + 1 < side)
+            {
+                graph.addEdge(id, id + side, haversineKm(graph.latitude(id), graph.longitude(id),
+                              graph.latitude(id + side), graph.longitude(id + side)), 1.0);
+            }
+        }
+    }
+
+    SegmentIndex roads;
+    roads.build(graph);
+
+    vector<vector<TracePoint>> all;
+
+    for (int i = 0; i < traces; i++)
+    {
+        all.push_back(makeTrace(graph, pointsPerTrace, rng));
+    }
+
+    long long total = 0, matched = 0, correct = 0;
+    auto start = chrono::steady_clock::now();
+
+    for (const auto& trace : all)
+    {
+        MapMatcher matcher(graph, roads);
+
+        auto score = [&](const vector<MatchedPoint>& decided)
+        {
+            for (const auto& m : decided)
+            {
+                const TracePoint& truth = trace[m.sequence];
+                matched += m.matched;
+                correct += m.matched && m.position.from == truth.from && m.position.to == truth.to;
+            }
+        };
+
+        for (const auto& p : trace)
+        {
+            score(matcher.push(p.gps));
+        }
+        score(matcher.flush());
+        total += trace.size();
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "Grid " << side << "x" << side << ", " << traces << " traces, " << total << " points" << endl;
+    cout << "  points/s = " << (long long)(total / seconds) << endl;
+    cout << "  matched  = " << 100.0 * matched / total << "%" << endl;
+    cout << "  correct  = " << 100.0 * correct / total << "% of points on the true road" << endl;
+
+    return 0;
+}
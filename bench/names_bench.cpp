@@ -0,0 +1,102 @@
+// Startup and lookups: the mmap'd NameFST vs building the BTree in memory.
+//
+// Build: g++ -std=c++17 -O2 -o names_bench bench/names_bench.cpp
+// Run:   ./names_bench [names] [lookups] [file]
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include "../src/btree.h"
+#include "../src/namefst.h"
+#include "bench_util.h"
+
+using namespace std;
+
+int main(int argc, char** argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    int lookups = argc > 2 ? atoi(argv[2]) : 1000000;
+    string path = argc > 3 ? argv[3] : "/tmp/names_bench.fst";
+
+    mt19937 rng(42);
+    vector<string> names = makeNames(count, rng);
+    vector<pair<string, uint32_t>> entries;
+
+    for (int i = 0; i < count; i++)
+    {
+        entries.push_back({names[i], (uint32_t)i});
+    }
+
+    auto start = chrono::steady_clock::now();
+    NameFST::build(entries, path);
+    double buildMs = msSince(start);
+
+    start = chrono::steady_clock::now();
+    NameFST fst;
+    fst.load(path);
+    double mapMs = msSince(start);
+
+    vector<pair<string, int>> pairs;
+
+    for (int i = 0; i < count; i++)
+    {
+        pairs.push_back({names[i], i});
+    }
+
+    start = chrono::steady_clock::now();
+    BTree btree;
+    btree.setLogging(false);
+    btree.bulkLoad(move(pairs));
+    double btreeMs = msSince(start);
+
+    cout << count << " names (" << count << " lookups, half of them misses)" << endl;
+    cout << "  startup  fst map " << mapMs << " ms (offline build " << buildMs << " ms), btree bulk load "
+         << btreeMs << " ms" << endl;
+    cout << "  size     fst " << fst.mappedBytes() / (1 << 20) << " MB on disk / page cache, btree "
+         << btree.memoryBytes() / (1 << 20) << " MB heap" << endl;
+
+    vector<string> queries(lookups);
+
+    for (auto& q : queries)
+    {
+        q = names[rng() % count];
+
+        if (rng() % 2)
+        {
+            q += "x";
+        }
+    }
+
+    long checksum = 0;
+    start = chrono::steady_clock::now();
+
+    for (auto& q : queries)
+    {
+        uint32_t id;
+        checksum += fst.find(q, id) ? id : 0;
+    }
+    double fstNs = msSince(start) * 1e6 / lookups;
+
+    start = chrono::steady_clock::now();
+
+    for (auto& q : queries)
+    {
+        int id = btree.search(q);
+        checksum -= id >= 0 ? id : 0;
+    }
+    double btreeNs = msSince(start) * 1e6 / lookups;
+
+    cout << "  lookup   fst " << fstNs << " ns, btree " << btreeNs << " ns" << endl;
+
+    start = chrono::steady_clock::now();
+    int listed = 0;
+    fst.prefix("Gulberg Road 12", "", [&](const string&, uint32_t)
+    {
+        return ++listed < 100;
+    });
+    cout << "  prefix   first 100 of \"Gulberg Road 12\" in " << msSince(start) * 1000 << " us" << endl;
+    cout << "  (checksum " << checksum << ", 0 when both agree)" << endl;
+
+    return 0;
+}
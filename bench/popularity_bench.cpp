@@ -0,0 +1,134 @@
+// Popular-first type-ahead: PopularityTrie::topK vs enumerating the whole
+// prefix range in the radix tree and keeping the k best scores.
+//
+// Build: g++ -std=c++17 -O2 -pthread -o popularity_bench bench/popularity_bench.cpp
+// Run:   ./popularity_bench [names] [queries] [threads]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <thread>
+#include "../src/popularitytrie.h"
+#include "../src/radixtree.h"
+#include "bench_util.h"
+
+using namespace std;
+
+int main(int argc, char** argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    int queryCount = argc > 2 ? atoi(argv[2]) : 2000;
+    int threads = argc > 3 ? atoi(argv[3]) : 4;
+    const size_t LIMIT = 10;
+
+    mt19937 rng(42);
+    vector<string> names = makeNames(count, rng);
+
+    PopularityTrie trie;
+    AdaptiveRadixTree art;
+
+    auto start = chrono::steady_clock::now();
+
+    for (int i = 0; i < count; i++)
+    {
+        trie.insert(names[i], i);
+    }
+    double trieBuild = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    for (int i = 0; i < count; i++)
+    {
+        art.insert(names[i], i);
+    }
+
+    // Zipf-like traffic: place i is routed about 1/(i+1) as often as place 0
+    const int BUMPS = 4000000;
+    vector<uint32_t> traffic(BUMPS);
+    vector<double> weights(count);
+
+    for (int i = 0; i < count; i++)
+    {
+        weights[i] = 1.0 / (i + 1);
+    }
+    discrete_distribution<int> zipf(weights.begin(), weights.end());
+
+    for (auto& t : traffic)
+    {
+        t = zipf(rng);
+    }
+
+    // Concurrent bumps, as /api/path handlers would issue them
+    start = chrono::steady_clock::now();
+    vector<thread> workers;
+
+    for (int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]
+        {
+            for (int i = t; i < BUMPS; i += threads)
+            {
+                trie.bump(traffic[i]);
+            }
+        });
+    }
+
+    for (auto& w : workers)
+    {
+        w.join();
+    }
+    double bumpMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    cout << count << " names, " << BUMPS << " bumps on " << threads << " threads, "
+         << queryCount << " prefix queries, top " << LIMIT << endl;
+    cout << "  build " << trieBuild << " ms, bumps " << BUMPS / bumpMs / 1000 << " M/s" << endl;
+
+    // Prefixes of real names, 1 to 12 bytes: short ones match huge ranges
+    vector<string> queries(queryCount);
+
+    for (auto& q : queries)
+    {
+        const string& name = names[rng() % count];
+        q = name.substr(0, 1 + rng() % min<size_t>(12, name.size()));
+    }
+
+    vector<double> trieMicros, scanMicros;
+    long mismatches = 0;
+
+    for (auto& q : queries)
+    {
+        auto t0 = chrono::steady_clock::now();
+        auto top = trie.topK(q, LIMIT);
+        auto t1 = chrono::steady_clock::now();
+
+        vector<uint64_t> scores;
+
+        art.complete(q, "", [&](const string&, const vector<uint32_t>& values)
+        {
+            for (uint32_t v : values)
+            {
+                scores.push_back(trie.score(v));
+            }
+            return true;
+        });
+
+        size_t keep = min(LIMIT, scores.size());
+        partial_sort(scores.begin(), scores.begin() + keep, scores.end(), greater<uint64_t>());
+        auto t2 = chrono::steady_clock::now();
+
+        // Ties may pick different places, but the score sequence must agree
+        for (size_t i = 0; i < keep; i++)
+        {
+            mismatches += i >= top.size() || top[i].second != scores[i];
+        }
+
+        trieMicros.push_back(chrono::duration<double, micro>(t1 - t0).count());
+        scanMicros.push_back(chrono::duration<double, micro>(t2 - t1).count());
+    }
+
+    report("topK       ", trieMicros);
+    report("scan + sort", scanMicros);
+    cout << "  (" << mismatches << " mismatched scores)" << endl;
+
+    return 0;
+}
@@ -0,0 +1,133 @@
+// Name lookups mixed with inserts: ConcurrentSkipList vs BTree behind a
+// shared_mutex, at several read/insert ratios.
+//
+// Build: g++ -std=c++17 -O2 -pthread -o skiplist_bench bench/skiplist_bench.cpp
+// Run:   ./skiplist_bench [names] [threads] [secondsPerPhase]
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+#include "../src/btree.h"
+#include "../src/skiplist.h"
+
+using namespace std;
+
+// Every thread runs lookups of preloaded names, and with `insertPercent`
+// probability inserts a fresh name instead, for `seconds`. Returns
+// {lookups/s, inserts/s}.
+template <typename Read, typename Write>
+pair<double, double> phase(int count, int threadCount, double seconds, int insertPercent, Read read, Write write)
+{
+    atomic<bool> stop{false};
+    atomic<long> reads{0};
+    atomic<long> writes{0};
+    vector<thread> threads;
+
+    for (int t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([&, t]
+        {
+            mt19937 rng(t + 1);
+            uniform_int_distribution<int> id(0, count - 1);
+            long lookups = 0, inserts = 0;
+            long checksum = 0;
+            static atomic<long> fresh{0};
+
+            while (!stop.load(memory_order_relaxed))
+            {
+                for (int i = 0; i < 256; i++)
+                {
+                    if ((int)(rng() % 100) < insertPercent)
+                    {
+                        write("New Junction " + to_string(fresh.fetch_add(1, memory_order_relaxed)));
+                        inserts++;
+                    }
+                    else
+                    {
+                        checksum += read("Junction " + to_string(id(rng)));
+                        lookups++;
+                    }
+                }
+            }
+
+            reads += lookups + (checksum == -1);
+            writes += inserts;
+        });
+    }
+
+    this_thread::sleep_for(chrono::duration<double>(seconds));
+    stop = true;
+
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    return {reads / seconds, writes / seconds};
+}
+
+int main(int argc, char** argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 100000;
+    int threads = argc > 2 ? atoi(argv[2]) : max(1u, thread::hardware_concurrency());
+    double seconds = argc > 3 ? atof(argv[3]) : 2.0;
+
+    cout << count << " names, " << threads << " threads, " << seconds << " s per phase" << endl;
+
+    for (int insertPercent : {0, 5, 50})
+    {
+        StringPool pool;
+        ConcurrentSkipList list(pool);
+        BTree btree;
+        shared_mutex btreeLock;
+        btree.setLogging(false);
+
+        vector<pair<string, int>> names;
+
+        for (int id = 0; id < count; id++)
+        {
+            list.insert("Junction " + to_string(id), id);
+            names.push_back({"Junction " + to_string(id), id});
+        }
+        btree.bulkLoad(move(names));
+
+        atomic<int> nextId{count};
+
+        auto listRead = [&](const string& name)
+        {
+            return (long)list.find(name);
+        };
+
+        auto listWrite = [&](const string& name)
+        {
+            list.insert(name, nextId++);
+        };
+
+        auto btreeRead = [&](const string& name)
+        {
+            shared_lock<shared_mutex> guard(btreeLock);
+            return (long)btree.search(name);
+        };
+
+        auto btreeWrite = [&](const string& name)
+        {
+            unique_lock<shared_mutex> guard(btreeLock);
+            btree.insert(name, nextId++);
+        };
+
+        auto report = [&](const char* label, pair<double, double> rates)
+        {
+            cout << "  " << insertPercent << "% inserts, " << label << ": " << rates.first / 1e6
+                 << " M lookups/s, " << rates.second / 1e3 << " k inserts/s" << endl;
+        };
+
+        report("skip list     ", phase(count, threads, seconds, insertPercent, listRead, listWrite));
+        report("btree + rwlock", phase(count, threads, seconds, insertPercent, btreeRead, btreeWrite));
+    }
+
+    return 0;
+}
@@ -0,0 +1,158 @@
+// SegmentIndex snapping on a synthetic city of about a million roads: build
+// time, latency of nearest-road lookups (as the routing endpoints snap
+// coordinates) and of small radius queries (as the map matcher asks for
+// candidates), and a brute-force check of the snapped distance on a sample.
+//
+// Build: g++ -std=c++17 -O2 -o snap_bench bench/snap_bench.cpp
+// Run:   ./snap_bench [gridSide] [queries] [checked]
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include "../src/segmentindex.h"
+
+using namespace std;
+
+const double SPACING_DEG = 0.001;     // ~100 m between junctions
+const double SNAP_KM = 1.0;           // as the server's SNAP_RADIUS_KM
+
+// Grid whose junctions are moved a little, so roads are not all axis-aligned
+void buildCity(Graph& graph, int side, mt19937& rng)
+{
+    uniform_real_distribution<double> jitter(-0.3 * SPACING_DEG, 0.3 * SPACING_DEG);
+
+    for (int r = 0; r < side; r++)
+    {
+        for (int c = 0; c < side; c++)
+        {
+            int id = r * side + c;
+            graph.setLocation(id, 31.4 + r * SPACING_DEG + jitter(rng), 74.2 + c * SPACING_DEG + jitter(rng));
+
+            if (c + 1 < side)
+            {
+                graph.addEdge(id, id + 1, 0.1, 1.0);
+            }
+
+            if (r + 1 < side)
+            {
+                graph.addEdge(id, id + side, 0.1, 1.0);
+            }
+        }
+    }
+}
+
+// Distance from (lat, lng) to the nearest road, trying every road, in the
+// same projection and float arithmetic the index uses
+double bruteForce(const Graph& graph, const LocalProjection& projection, double lat, double lng)
+{
+    float x = projection.x(lng);
+    float y = projection.y(lat);
+    float best = numeric_limits<float>::infinity();
+
+    for (int u = 0; u < graph.nodeCount(); u++)
+    {
+        float x1 = projection.x(graph.longitude(u));
+        float y1 = projection.y(graph.latitude(u));
+
+        for (const auto& edge : graph.edges(u))
+        {
+            if (edge.to < u)
+            {
+                continue;
+            }
+
+            float vx = (float)projection.x(graph.longitude(edge.to)) - x1;
+            float vy = (float)projection.y(graph.latitude(edge.to)) - y1;
+            float length2 = vx * vx + vy * vy;
+            float t = length2 > 0 ? ((x - x1) * vx + (y - y1) * vy) / length2 : 0;
+            t = min(1.0f, max(0.0f, t));
+
+            float dx = x1 + t * vx - x;
+            float dy = y1 + t * vy - y;
+            best = min(best, dx * dx + dy * dy);
+        }
+    }
+
+    return best <= SNAP_KM * SNAP_KM ? sqrt((double)best) : -1;
+}
+
+int main(int argc, char** argv)
+{
+    int side = argc > 1 ? atoi(argv[1]) : 700;
+    int queryCount = argc > 2 ? atoi(argv[2]) : 100000;
+    int checked = argc > 3 ? atoi(argv[3]) : 100;
+
+    mt19937 rng(42);
+    Graph graph;
+    graph.setLogging(false);
+    buildCity(graph, side, rng);
+
+    SegmentIndex index;
+    auto t0 = chrono::steady_clock::now();
+    index.build(graph);
+    double buildMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+
+    cout << graph.nodeCount() << " junctions, " << 2 * side * (side - 1) << " roads, built in " << buildMs
+         << " ms, " << queryCount << " queries, " << checked << " checked by brute force" << endl;
+
+    // Points over the city and a little beyond its edge
+    uniform_real_distribution<double> lat(31.4 - 0.002, 31.4 + side * SPACING_DEG + 0.002);
+    uniform_real_distribution<double> lng(74.2 - 0.002, 74.2 + side * SPACING_DEG + 0.002);
+    vector<pair<double, double>> queries(queryCount);
+
+    for (auto& q : queries)
+    {
+        q = {lat(rng), lng(rng)};
+    }
+
+    SnapPoint snap;
+    int snapped = 0;
+    auto t1 = chrono::steady_clock::now();
+
+    for (auto [qLat, qLng] : queries)
+    {
+        snapped += index.nearest(qLat, qLng, SNAP_KM, snap);
+    }
+
+    double nearestUs = chrono::duration<double, micro>(chrono::steady_clock::now() - t1).count() / queryCount;
+    size_t candidates = 0;
+    auto t2 = chrono::steady_clock::now();
+
+    for (auto [qLat, qLng] : queries)
+    {
+        candidates += index.withinRadius(qLat, qLng, 0.05).size();
+    }
+
+    double radiusUs = chrono::duration<double, micro>(chrono::steady_clock::now() - t2).count() / queryCount;
+
+    // Same mean latitude as the index's projection
+    double latSum = 0;
+
+    for (int v = 0; v < graph.nodeCount(); v++)
+    {
+        latSum += graph.latitude(v);
+    }
+
+    LocalProjection projection(latSum / graph.nodeCount());
+    int wrong = 0;
+
+    for (int i = 0; i < checked && i < queryCount; i++)
+    {
+        auto [qLat, qLng] = queries[i];
+        double expected = bruteForce(graph, projection, qLat, qLng);
+        double got = index.nearest(qLat, qLng, SNAP_KM, snap) ? snap.distanceKm : -1;
+
+        if (fabs(got - expected) > 1e-6)
+        {
+            wrong++;
+        }
+    }
+
+    cout << "  nearest road:   " << nearestUs << " us per query, " << 100.0 * snapped / queryCount
+         << "% snapped, " << wrong << " wrong" << endl;
+    cout << "  roads in 50 m:  " << radiusUs << " us per query, " << (double)candidates / queryCount
+         << " roads mean" << endl;
+
+    return 0;
+}
@@ -0,0 +1,142 @@
+// SpatialIndex lookups on a million-junction city: build time, latency of
+// k-nearest and capped radius queries, and a brute-force check of every
+// answer (ids and distances) on a sample of the queries.
+//
+// Build: g++ -std=c++17 -O2 -o spatial_bench bench/spatial_bench.cpp
+// Run:   ./spatial_bench [junctions] [queries] [checked]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include "../src/spatialindex.h"
+
+using namespace std;
+
+// Answers match when distances agree in order (ids may swap on ties)
+bool same(const vector<SpatialHit>& got, const vector<pair<double, int>>& expected)
+{
+    if (got.size() != expected.size())
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < got.size(); i++)
+    {
+        if (fabs(got[i].distanceKm - expected[i].first) > 1e-3)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    int queryCount = argc > 2 ? atoi(argv[2]) : 100000;
+    int checked = argc > 3 ? atoi(argv[3]) : 200;
+
+    // Junctions spread over about 40 x 40 km
+    mt19937 rng(42);
+    uniform_real_distribution<double> lat(31.3, 31.66), lng(74.1, 74.52);
+    vector<int> ids(count);
+    vector<double> lats(count), lngs(count);
+
+    for (int i = 0; i < count; i++)
+    {
+        ids[i] = i + 1;
+        lats[i] = lat(rng);
+        lngs[i] = lng(rng);
+    }
+
+    SpatialIndex index;
+    auto t0 = chrono::steady_clock::now();
+    index.build(ids, lats, lngs);
+    double buildMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+
+    cout << count << " junctions, built in " << buildMs << " ms, " << queryCount << " queries per line, "
+         << checked << " checked by brute force" << endl;
+
+    vector<pair<double, double>> queries(queryCount);
+
+    for (auto& q : queries)
+    {
+        q = {lat(rng), lng(rng)};
+    }
+
+    // Brute force over the same projection and float coordinates the index
+    // uses, so points right on a radius fall on the same side
+    double latSum = 0;
+
+    for (double v : lats)
+    {
+        latSum += v;
+    }
+
+    LocalProjection projection(latSum / count);
+
+    auto bruteForce = [&](double qLat, double qLng, int k, double radiusKm)
+    {
+        vector<pair<double, int>> all;
+        float x = projection.x(qLng), y = projection.y(qLat);
+        float radius = radiusKm * radiusKm;
+
+        for (int i = 0; i < count; i++)
+        {
+            float dx = (float)projection.x(lngs[i]) - x;
+            float dy = (float)projection.y(lats[i]) - y;
+            float d = dx * dx + dy * dy;
+
+            if (d <= radius)
+            {
+                all.push_back({sqrt((double)d), ids[i]});
+            }
+        }
+
+        size_t keep = min(all.size(), (size_t)k);
+        partial_sort(all.begin(), all.begin() + keep, all.end());
+        all.resize(keep);
+        return all;
+    };
+
+    struct Case
+    {
+        string label;
+        int k;
+        double radiusKm;
+    };
+
+    for (const Case& c : {Case{"k = 1", 1, INFINITY}, Case{"k = 10", 10, INFINITY},
+                          Case{"k = 100", 100, INFINITY}, Case{"0.05 km, cap 100", 100, 0.05},
+                          Case{"1 km, cap 100", 100, 1.0}})
+    {
+        size_t found = 0;
+        auto start = chrono::steady_clock::now();
+
+        for (auto [qLat, qLng] : queries)
+        {
+            found += index.nearest(qLat, qLng, c.k, c.radiusKm).size();
+        }
+
+        double us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / queryCount;
+        int wrong = 0;
+
+        for (int i = 0; i < checked && i < queryCount; i++)
+        {
+            auto [qLat, qLng] = queries[i];
+
+            if (!same(index.nearest(qLat, qLng, c.k, c.radiusKm), bruteForce(qLat, qLng, c.k, c.radiusKm)))
+            {
+                wrong++;
+            }
+        }
+
+        cout << "  " << left << setw(18) << c.label << ": " << us << " us per query, "
+             << (double)found / queryCount << " hits mean, " << wrong << " wrong" << endl;
+    }
+
+    return 0;
+}
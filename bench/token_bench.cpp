@@ -0,0 +1,132 @@
+// Multi-word search: TokenIndex (compressed lists, galloping / SSE2 AND)
+// vs plain vector posting lists intersected with std::set_intersection,
+// for all matches and for the first page of 10.
+//
+// Build: g++ -std=c++17 -O2 -pthread -o token_bench bench/token_bench.cpp
+// Run:   ./token_bench [names] [queries] [threads]
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <unordered_map>
+#include "../src/tokenindex.h"
+#include "bench_util.h"
+
+using namespace std;
+
+int main(int argc, char** argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 1000000;
+    int queryCount = argc > 2 ? atoi(argv[2]) : 20000;
+    int threads = argc > 3 ? atoi(argv[3]) : 4;
+
+    mt19937 rng(42);
+    vector<string> names = makeWordyNames(count, rng);
+    vector<pair<string, uint32_t>> entries;
+
+    for (int i = 0; i < count; i++)
+    {
+        entries.push_back({names[i], (uint32_t)i});
+    }
+
+    auto start = chrono::steady_clock::now();
+    TokenIndex serial;
+
+    for (auto& [name, value] : entries)
+    {
+        serial.add(name, value);
+    }
+    double serialMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+    TokenIndex index;
+    index.build(entries, threads);
+    double parallelMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    unordered_map<string, vector<uint32_t>> plain;
+    size_t plainBytes = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        vector<string> tokens = TokenIndex::tokensOf(names[i]);
+        sort(tokens.begin(), tokens.end());
+        tokens.erase(unique(tokens.begin(), tokens.end()), tokens.end());
+
+        for (auto& token : tokens)
+        {
+            plain[token].push_back(i);
+            plainBytes += 4;
+        }
+    }
+
+    // Two or three words of a real name, shuffled and upper-cased at random
+    vector<vector<string>> queries(queryCount);
+
+    for (auto& q : queries)
+    {
+        vector<string> tokens = TokenIndex::tokensOf(names[rng() % count]);
+        shuffle(tokens.begin(), tokens.end(), rng);
+        tokens.resize(2 + rng() % 2);
+        q = tokens;
+    }
+
+    cout << count << " names, " << index.memoryBytes() / (1 << 20) << " MB (plain lists "
+         << plainBytes / (1 << 20) << " MB of doc IDs), " << queryCount << " queries of 2-3 words" << endl;
+    cout << "  build    add() " << serialMs << " ms, build() on " << threads << " threads "
+         << parallelMs << " ms" << endl;
+
+    vector<double> indexMicros, firstMicros, plainMicros;
+    long checksum = 0, mismatches = 0;
+
+    for (auto& q : queries)
+    {
+        string text;
+
+        for (auto& token : q)
+        {
+            text += (text.empty() ? "" : " ") + token;
+        }
+        text[0] = toupper(text[0]);
+
+        auto t0 = chrono::steady_clock::now();
+        vector<uint32_t> found = index.search(text, SIZE_MAX);
+        auto t1 = chrono::steady_clock::now();
+
+        vector<const vector<uint32_t>*> lists;
+
+        for (auto& token : q)
+        {
+            lists.push_back(&plain[token]);
+        }
+        sort(lists.begin(), lists.end(), [](auto a, auto b) { return a->size() < b->size(); });
+
+        vector<uint32_t> result = *lists[0], next;
+
+        for (size_t i = 1; i < lists.size(); i++)
+        {
+            next.clear();
+            set_intersection(result.begin(), result.end(), lists[i]->begin(), lists[i]->end(), back_inserter(next));
+            result.swap(next);
+        }
+        auto t2 = chrono::steady_clock::now();
+
+        // What the search endpoint asks for: one page of matches
+        checksum += index.search(text, 10).size();
+        auto t3 = chrono::steady_clock::now();
+
+        checksum += found.size();
+        mismatches += found != result;
+        indexMicros.push_back(chrono::duration<double, micro>(t1 - t0).count());
+        plainMicros.push_back(chrono::duration<double, micro>(t2 - t1).count());
+        firstMicros.push_back(chrono::duration<double, micro>(t3 - t2).count());
+    }
+
+    report("token index", indexMicros);
+    report("first 10   ", firstMicros);
+    report("plain lists", plainMicros);
+    cout << "  (checksum " << checksum << ", " << mismatches << " mismatches)" << endl;
+
+    return 0;
+}
@@ -0,0 +1,170 @@
+// Transit-node routing on a synthetic grid city, with and without faster
+// arterial roads: how many junctions end up transit nodes (against every
+// cell-border junction), the table size, access nodes per junction, query
+// latency against plain Dijkstra, and a check that every table answer
+// matches Dijkstra's, also with a growing share of roads slowed.
+//
+// Build: g++ -std=c++17 -O2 -pthread -o transit_bench bench/transit_bench.cpp
+// Run:   ./transit_bench [gridSide] [pairs] [cells]
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include "../src/transitnodes.h"
+#include "bench_util.h"
+
+using namespace std;
+
+// Run every pair through the table and Dijkstra and report one line, once
+// the traffic changes so far are marked
+void measure(const string& label, const Graph& graph, const TransitNodeRouting& transit,
+             const vector<pair<int, int>>& pairs)
+{
+    auto marking = chrono::steady_clock::now();
+
+    while (transit.pendingChanges() > 0)
+    {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+
+    double markingMs = chrono::duration<double, milli>(chrono::steady_clock::now() - marking).count();
+    Graph::SearchWorkspace ws;
+    int answered = 0, wrong = 0;
+    double tableUs = 0, plainUs = 0;
+
+    for (auto [source, dest] : pairs)
+    {
+        double fromTable;
+        auto t0 = chrono::steady_clock::now();
+        bool used = transit.query(graph, source, dest, fromTable);
+        auto t1 = chrono::steady_clock::now();
+        double plain = graph.shortestPath(source, dest, ws).second;
+        auto t2 = chrono::steady_clock::now();
+
+        plainUs += chrono::duration<double, micro>(t2 - t1).count();
+
+        if (used)
+        {
+            answered++;
+            tableUs += chrono::duration<double, micro>(t1 - t0).count();
+
+            if (fabs(fromTable - plain) > 1e-4 * max(1.0, plain))
+            {
+                wrong++;
+            }
+        }
+    }
+
+    cout << "  " << left << setw(18) << label << ": " << 100.0 * answered / pairs.size() << "% from the table, "
+         << tableUs / max(1, answered) << " us per table answer, Dijkstra " << plainUs / pairs.size() << " us, "
+         << wrong << " wrong, " << markingMs << " ms marking before" << endl;
+}
+
+void run(int side, int arterial, int pairCount, int cellCount)
+{
+    mt19937 rng(42);
+    Graph graph;
+    graph.setLogging(false);
+    buildGrid(graph, side, rng, arterial);
+
+    // The old selection: every junction with a road into another cell
+    Partition cells;
+    cells.build(graph, cellCount);
+    int border = 0;
+
+    for (int u = 0; u < graph.nodeCount(); u++)
+    {
+        for (const auto& edge : graph.edges(u))
+        {
+            if (cells.region(edge.to) != cells.region(u))
+            {
+                border++;
+                break;
+            }
+        }
+    }
+
+    string path = "/tmp/transit_bench.tnr";
+    auto t0 = chrono::steady_clock::now();
+    TransitNodeRouting::build(graph, cellCount, max(1u, thread::hardware_concurrency()), path);
+    auto t1 = chrono::steady_clock::now();
+
+    TransitNodeRouting transit;
+    transit.load(path, graph);
+    graph.setTrafficListener([&](int u, int v)
+    {
+        transit.trafficChanged(graph, u, v);
+    });
+
+    long accessTotal = 0;
+    int accessMax = 0;
+
+    for (int u = 0; u < graph.nodeCount(); u++)
+    {
+        for (bool forward : {true, false})
+        {
+            accessTotal += transit.accessCount(u, forward);
+            accessMax = max(accessMax, transit.accessCount(u, forward));
+        }
+    }
+
+    cout << "Grid " << side << "x" << side << (arterial ? ", arterial every " + to_string(arterial) + " rows/columns" : "")
+         << ", " << cellCount << " cells: " << transit.transitCount() << " transit nodes (" << border
+         << " border junctions), table " << transit.tableBytes() / 1024 << " KB, access nodes "
+         << (double)accessTotal / (2 * graph.nodeCount()) << " mean, " << accessMax << " max, built in "
+         << chrono::duration<double>(t1 - t0).count() << " s" << endl;
+
+    // Far pairs only: near ones are always left to the local engine
+    vector<pair<int, int>> pairs;
+
+    while ((int)pairs.size() < pairCount)
+    {
+        int s = rng() % (side * side);
+        int t = rng() % (side * side);
+
+        if (!transit.isLocal(graph, s, t))
+        {
+            pairs.push_back({s, t});
+        }
+    }
+
+    measure("no traffic", graph, transit, pairs);
+
+    uniform_real_distribution<double> slowdown(1.5, 3.0);
+    int roads = 2 * side * (side - 1);
+    int slowed = 0;
+    double updateUs = 0;
+
+    for (double share : {0.001, 0.01})
+    {
+        while (slowed < share * roads)
+        {
+            auto road = randomRoad(side, rng);
+            auto start = chrono::steady_clock::now();
+            graph.updateTraffic(road.first, road.second, slowdown(rng));
+            updateUs += chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+            slowed++;
+        }
+        measure(to_string(slowed) + " roads slowed", graph, transit, pairs);
+    }
+
+    // The part a server spends under its write lock
+    cout << "  traffic update    : " << updateUs / slowed << " us each, listener included" << endl;
+
+    graph.resetAllTraffic();
+    measure("traffic reset", graph, transit, pairs);
+}
+
+int main(int argc, char** argv)
+{
+    int side = argc > 1 ? atoi(argv[1]) : 100;
+    int pairCount = argc > 2 ? atoi(argv[2]) : 300;
+    int cellCount = argc > 3 ? atoi(argv[3]) : 16;
+
+    run(side, 0, pairCount, cellCount);
+    run(side, 10, pairCount, cellCount);
+    return 0;
+}
@@ -1,10 +1,36 @@
 #include "include/httplib.h"
 #include "include/json.hpp"
+#include "src/arcflags.h"
+#include "src/astar.h"
 #include "src/btree.h"
+#include "src/concurrentmap.h"
+#include "src/fuzzyindex.h"
 #include "src/graph.h"
-#include "src/hashtable.h"
+#include "src/junctionstore.h"
+#include "src/stringpool.h"
+#include "src/mapmatcher.h"
+#include "src/perfecthash.h"
+#include "src/popularitytrie.h"
+#include "src/tokenindex.h"
+#include "src/namefst.h"
+#include "src/compression.h"
+#include "src/payload.h"
+#include "src/skiplist.h"
+#include "src/radixtree.h"
+#include "src/segmentindex.h"
+#include "src/spatialindex.h"
+#include "src/tilecache.h"
+#include "src/transitnodes.h"
+#include "src/workerpool.h"
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
 
 using json = nlohmann::json;
 using namespace httplib;
@@ -12,7 +38,120 @@ using namespace httplib;
 // Global data structures
 BTree btree;
 Graph graph;
-HashTable hashtable;
+StringPool namePool;                  // junction and road names, each stored once
+ConcurrentJunctionMap junctionMeta(namePool);  // names etc., updatable while serving
+JunctionStore junctionStore;
+ArcFlags arcFlags;
+TransitNodeRouting transitNodes;
+WeightedAStar approximateRouter;
+SpatialIndex junctionIndex;
+SegmentIndex roadIndex;
+TileCache tileCache(graph, roadIndex);
+
+// Regions used by the arc-flags partition
+const int ARC_FLAG_REGIONS = 32;
+
+// GPS points farther than this from every road are not snapped
+const double SNAP_RADIUS_KM = 1.0;
+
+// Transit-node layer, rebuilt only when the road data changes
+const int TRANSIT_CELLS = 16;
+const char* TRANSIT_TABLE_PATH = "data/transit.tnr";
+
+// Minimal perfect hash over the loaded junction IDs (--perfect-hash), kept next to the data
+const char* PERFECT_HASH_PATH = "data/junctions.mph";
+
+// Junction name -> ID dictionary, built offline (tools/build_names.cpp) and
+// mmap'd; rebuilt here only if it does not match data/junctions.json
+NameFST nameDictionary;
+const char* NAME_DICTIONARY_PATH = "data/names.fst";
+
+// Current junction name -> ID, lock-free: created and renamed junctions
+// show up here at once, and lookups never wait for the names lock
+ConcurrentSkipList liveNames(namePool);
+std::atomic<int> nextJunctionId{0};
+
+// Renames read a junction's current name and replace it; one at a time, so
+// two renames of the same junction cannot both start from the same old name.
+// Taken before namesMutex.
+std::mutex renameMutex;
+
+// Names bound while serving that the dictionary does not have (created
+// junctions, renames); /api/names merges them with the dictionary's
+ConcurrentSkipList addedNames(namePool);
+
+// GET /api/junctions as served: the junctions of data/junctions.json plus
+// creations and renames, serialized (and compressed) from junctionMeta once
+// per change rather than per request. Changes publish a new payload under
+// junctionsOrderMutex; requests only copy the pointer.
+std::vector<int> junctionsOrder;      // IDs in file order, then created ones
+std::mutex junctionsOrderMutex;
+std::shared_ptr<const Payload> junctionsPayload;
+std::mutex junctionsPayloadMutex;
+
+// Named roads from data/roads.json, in file order
+struct NamedRoad {
+    int from;
+    int to;
+    uint32_t name;  // in namePool
+};
+std::vector<NamedRoad> namedRoads;
+
+// Type-ahead over junction and road names. Values tag the place:
+// junction ID * 2, or road index * 2 + 1.
+AdaptiveRadixTree placeNames;
+
+uint32_t junctionPlace(int id) { return (uint32_t)id << 1; }
+uint32_t roadPlace(size_t index) { return (uint32_t)index << 1 | 1; }
+
+// Typo-tolerant search over the same names and place values
+FuzzyIndex fuzzyNames;
+
+// Completions ranked by how often a place is routed from or to. Scores
+// are bumped under the shared names lock; only renames change the shape.
+PopularityTrie popularity;
+
+// Word search over the same names: every word of the query, in any order
+TokenIndex tokenNames;
+
+// Name indexes (btree, placeNames, fuzzyNames, popularity, tokenNames): searches share the lock, renames take it exclusively
+std::shared_mutex namesMutex;
+
+// Name search page size
+const int SEARCH_DEFAULT_LIMIT = 10;
+const int SEARCH_MAX_LIMIT = 100;
+
+// Nearest-junction results per request, also for a radius query
+const int NEAREST_MAX_LIMIT = 100;
+
+// Routing is read-mostly: searches share the lock, traffic updates take it exclusively
+std::shared_mutex graphMutex;
+
+// Fixed pool for batch routing, one search workspace per worker
+WorkerPool routingPool(std::thread::hardware_concurrency());
+std::vector<Graph::SearchWorkspace> routingWorkspaces(routingPool.size());
+
+// Viewport responses: full detail from this zoom up, and at most this many
+// roads; each zoom level below halves the road budget
+const int VIEWPORT_DETAIL_ZOOM = 15;
+const size_t VIEWPORT_MAX_ROADS = 2000;
+const size_t VIEWPORT_MIN_ROADS = 64;
+
+// Pairs handed to a worker per task
+const size_t PATH_BATCH_CHUNK = 32;
+
+// State shared by the batch workers and the streaming response
+struct PathBatch {
+    std::vector<std::pair<int, int>> pairs;
+    std::vector<std::pair<std::vector<int>, double>> results;  // preallocated, one slot per pair
+    std::vector<const char*> statuses;                         // per pair, as /api/path reports them
+    bool timeOnly = false;                                     // skip paths, allow table lookups
+    double epsilon = 0;                                        // allowed suboptimality, 0 = exact
+    std::vector<size_t> finished;                              // pair indices in completion order
+    std::mutex lock;
+    std::condition_variable progress;
+    std::atomic<bool> cancelled{false};
+};
 
 // ⭐ CORS Headers Function
 void enableCORS(Response& res) {
@@ -21,14 +160,118 @@ void enableCORS(Response& res) {
     res.set_header("Access-Control-Allow-Headers", "Content-Type, Authorization");
 }
 
+// Serialize the junctions into a new payload; caller holds junctionsOrderMutex
+void publishJunctions() {
+    json junctions = json::array();
+    
+    for (int id : junctionsOrder) {
+        JunctionHandle junction = junctionMeta.find(id);
+        if (junction) {
+            junctions.push_back({
+                {"id", id},
+                {"name", std::string(junction->name)},
+                {"lat", junction->lat},
+                {"lng", junction->lng}
+            });
+        }
+    }
+    
+    json response;
+    response["junctions"] = std::move(junctions);
+    auto payload = std::make_shared<const Payload>(response.dump());
+    
+    std::lock_guard<std::mutex> guard(junctionsPayloadMutex);
+    junctionsPayload = payload;
+}
+
+// Republish /api/junctions after junctionMeta changed for id
+void recordJunction(int id, bool created) {
+    std::lock_guard<std::mutex> guard(junctionsOrderMutex);
+    
+    if (created) {
+        junctionsOrder.push_back(id);
+    }
+    publishJunctions();
+}
+
+// Publish a junction created while serving (its name already claimed in
+// liveNames) to the other indexes and the /api/junctions payload. The
+// columnar store and the k-d tree are read under graphMutex or namesMutex,
+// so they change under both, taken in that order as everywhere else.
+void addJunction(const Junction& junction) {
+    int id = junction.id;
+    junctionMeta.insert(junction);
+    addedNames.assign(junction.name, id);
+    {
+        std::unique_lock<std::shared_mutex> graphGuard(graphMutex);
+        std::unique_lock<std::shared_mutex> namesGuard(namesMutex);
+        junctionStore.add(id, junction.lat, junction.lng);
+        junctionIndex.insert(id, junction.lat, junction.lng);
+        btree.insert(junction.name, id);
+        placeNames.insert(junction.name, junctionPlace(id));
+        fuzzyNames.add(junction.name, junctionPlace(id));
+        popularity.insert(junction.name, junctionPlace(id));
+        tokenNames.add(junction.name, junctionPlace(id));
+    }
+    recordJunction(id, true);
+}
+
+// Send a prepared payload: 304 if the client's copy is current, else the
+// form the client takes best
+void sendPayload(const Request& req, Response& res, const Payload& payload,
+                 const char* contentType = "application/json") {
+    Encoding encoding = payload.encodingFor(req.get_header_value("Accept-Encoding"));
+    const std::string& etag = payload.etag(encoding);
+    
+    res.set_header("ETag", etag);
+    if (payload.compressed()) {
+        res.set_header("Vary", "Accept-Encoding");
+    }
+    
+    if (Payload::matches(req.get_header_value("If-None-Match"), etag)) {
+        res.status = 304;
+        return;
+    }
+    
+    if (encoding != Encoding::IDENTITY) {
+        res.set_header("Content-Encoding", Compression::name(encoding));
+    }
+    res.set_content(payload.body(encoding), contentType);
+}
+
+// Send a JSON response, compressed as the client asks if it is large enough
+void sendJson(const Request& req, Response& res, const json& response) {
+    std::string body = response.dump();
+    
+    if (body.size() >= Compression::MIN_BYTES) {
+        res.set_header("Vary", "Accept-Encoding");
+        Encoding encoding = Compression::negotiate(req.get_header_value("Accept-Encoding"));
+        std::string compressed = Compression::compress(body, encoding);
+        
+        if (!compressed.empty()) {
+            res.set_header("Content-Encoding", Compression::name(encoding));
+            body = std::move(compressed);
+        }
+    }
+    res.set_content(body, "application/json");
+}
+
 // Load data from JSON files
 void loadData() {
+    // Names for the word index, built in one parallel pass at the end
+    std::vector<std::pair<std::string, uint32_t>> tokenEntries;
+    
     // Load junctions
     std::ifstream jFile("data/junctions.json");
     if (jFile.is_open()) {
         json jData;
         jFile >> jData;
         
+        std::vector<int> ids;
+        std::vector<double> lats, lngs;
+        std::vector<std::pair<std::string, int>> names;
+        std::vector<std::pair<std::string, uint32_t>> dictionaryEntries;
+        
         for (auto& j : jData["junctions"]) {
             int id = j["id"];
             std::string name = j["name"];
@@ -36,11 +279,39 @@ void loadData() {
             double lng = j["lng"];
             
             Junction junction(id, name, lat, lng);
-            btree.insert(name, id);
-            hashtable.insert(junction);
+            names.push_back({name, id});
+            dictionaryEntries.push_back({name, (uint32_t)id});
+            liveNames.assign(name, id);
+            nextJunctionId = std::max(nextJunctionId.load(), id + 1);
+            placeNames.insert(name, junctionPlace(id));
+            fuzzyNames.add(name, junctionPlace(id));
+            popularity.insert(name, junctionPlace(id));
+            tokenEntries.push_back({name, junctionPlace(id)});
+            junctionMeta.insert(junction);
+            junctionStore.add(id, lat, lng);
+            graph.setLocation(id, lat, lng);
+            
+            ids.push_back(id);
+            lats.push_back(lat);
+            lngs.push_back(lng);
         }
+        
+        btree.bulkLoad(std::move(names));
+        
+        {
+            std::lock_guard<std::mutex> guard(junctionsOrderMutex);
+            junctionsOrder = ids;
+            publishJunctions();
+        }
+        
+        uint64_t signature = NameFST::signatureOf(dictionaryEntries);
+        if (!nameDictionary.load(NAME_DICTIONARY_PATH, signature)) {
+            NameFST::build(dictionaryEntries, NAME_DICTIONARY_PATH);
+            nameDictionary.load(NAME_DICTIONARY_PATH, signature);
+        }
+        junctionIndex.build(ids, lats, lngs);
         jFile.close();
-        std::cout << "[OK] Loaded " << jData["junctions"].size() << " junctions" << std::endl;
+        std::cout << "[OK] Loaded " << ids.size() << " junctions" << std::endl;
     }
     
     // Load roads
@@ -54,18 +325,221 @@ void loadData() {
             int to = r["to"];
             double distance = r["distance"];
             double time = r["base_time"];
+            std::string name = r.value("name", "");
             
             graph.addEdge(from, to, distance, time);
+            
+            if (!name.empty()) {
+                placeNames.insert(name, roadPlace(namedRoads.size()));
+                fuzzyNames.add(name, roadPlace(namedRoads.size()));
+                popularity.insert(name, roadPlace(namedRoads.size()));
+                tokenEntries.push_back({name, roadPlace(namedRoads.size())});
+                namedRoads.push_back({from, to, namePool.intern(name)});
+            }
         }
         rFile.close();
         std::cout << "[OK] Loaded " << rData["roads"].size() << " roads" << std::endl;
     }
     
+    tokenNames.build(tokenEntries, std::thread::hardware_concurrency());
+    roadIndex.build(graph);
+    
+    // Traffic changes only dirty the map tiles the changed road crosses, the
+    // arc-flag regions the changed edge is flagged for and the transit-table
+    // pairs it may lie on. Runs under the graphMutex write lock taken for
+    // the change.
+    graph.setTrafficListener([](int u, int v) {
+        tileCache.invalidate(u, v);
+        arcFlags.trafficChanged(graph, u, v);
+        transitNodes.trafficChanged(graph, u, v);
+    });
+    
+    arcFlags.build(graph, ARC_FLAG_REGIONS, std::thread::hardware_concurrency());
+    
+    if (!transitNodes.load(TRANSIT_TABLE_PATH, graph)) {
+        TransitNodeRouting::build(graph, TRANSIT_CELLS, std::thread::hardware_concurrency(), TRANSIT_TABLE_PATH);
+        transitNodes.load(TRANSIT_TABLE_PATH, graph);
+    }
+    
     std::cout << "[OK] Data loaded successfully!" << std::endl;
 }
 
-int main() {
+// Switch junction ID lookups to a minimal perfect hash, reusing the saved
+// one when it was built for the same IDs
+void enablePerfectHash() {
+    PerfectHash hash;
+    uint64_t signature = PerfectHash::signatureOf(junctionStore.idColumn());
+    
+    if (!hash.load(PERFECT_HASH_PATH, signature)) {
+        hash.build(junctionStore.idColumn());
+        hash.save(PERFECT_HASH_PATH, signature);
+    }
+    
+    double bitsPerKey = hash.bitsPerKey();
+    
+    if (junctionStore.usePerfectHash(std::move(hash))) {
+        std::cout << "[OK] Perfect hash over " << junctionStore.size() << " junctions ("
+                  << bitsPerKey << " bits/key)" << std::endl;
+    } else {
+        std::cout << "[WARN] Perfect hash does not match the junctions, using the regular map" << std::endl;
+    }
+}
+
+// Junction as a response object; null if unknown. Coordinates come from the
+// columnar store, which grows as junctions are created, so callers hold
+// graphMutex or namesMutex; the name from the metadata map, which may be
+// updated concurrently. Coordinates are stored as float
+// (~2e-6 degrees apart at these latitudes), so print them rounded to
+// 5 decimals (~1 m) rather than with float noise.
+json junctionJson(int id) {
+    int i = junctionStore.find(id);
+    JunctionHandle meta = junctionMeta.find(id);
+    if (i == -1 || !meta) {
+        return nullptr;
+    }
+    
+    return {
+        {"id", id},
+        {"name", meta->name},
+        {"lat", std::round(junctionStore.latitude(i) * 1e5) / 1e5},
+        {"lng", std::round(junctionStore.longitude(i) * 1e5) / 1e5}
+    };
+}
+
+// Search result for a placeNames value
+json placeJson(uint32_t place) {
+    if (place & 1) {
+        const NamedRoad& road = namedRoads[place >> 1];
+        return {
+            {"type", "road"},
+            {"name", std::string(namePool.view(road.name))},
+            {"from", road.from},
+            {"to", road.to}
+        };
+    }
+    
+    json j = junctionJson(place >> 1);
+    if (!j.is_null()) {
+        j["type"] = "junction";
+    }
+    return j;
+}
+
+// Route where either end may be a {lat, lng} object instead of a junction ID.
+// Coordinates are snapped to the nearest road and enter the search as a
+// virtual node splitting that road. Caller holds graphMutex.
+json routeSnapped(const json& sourceValue, const json& destinationValue) {
+    thread_local Graph::SearchWorkspace ws;
+    std::vector<std::pair<int, double>> seeds[2];
+    SnapPoint snaps[2];
+    bool snapped[2] = {false, false};
+    const json* ends[2] = {&sourceValue, &destinationValue};
+    
+    for (int i = 0; i < 2; i++) {
+        const json& end = *ends[i];
+        
+        if (end.is_object()) {
+            if (!roadIndex.nearest(end["lat"], end["lng"], SNAP_RADIUS_KM, snaps[i])) {
+                return {
+                    {"success", false},
+                    {"status", "no_road_nearby"},
+                    {"message", "No road within snapping distance"}
+                };
+            }
+            snapped[i] = true;
+            seeds[i] = i == 0 ? departureSeeds(graph, snaps[i]) : arrivalSeeds(graph, snaps[i]);
+        } else {
+            int index = graph.findIndex(end.get<int>());
+            
+            if (index == -1) {
+                return {
+                    {"success", false},
+                    {"status", "unknown_junction"},
+                    {"message", "Unknown junction"}
+                };
+            }
+            seeds[i] = {{index, 0.0}};
+        }
+    }
+    
+    auto [path, totalTime] = graph.shortestPathBetween(seeds[0], seeds[1], ws);
+    
+    // Both points on the same road: driving straight along it may be quicker
+    if (snapped[0] && snapped[1]) {
+        double direct = sameRoadTime(graph, snaps[0], snaps[1]);
+        
+        if (direct != std::numeric_limits<double>::infinity() && (totalTime < 0 || direct < totalTime)) {
+            path.clear();
+            totalTime = direct;
+        }
+    }
+    
+    if (totalTime < 0) {
+        // Named as /api/path names it when the component index rules out every pair of ends
+        bool unreachable = true;
+        for (auto& from : seeds[0]) {
+            for (auto& to : seeds[1]) {
+                unreachable = unreachable && graph.reachability(from.first, to.first) == Graph::Reach::No;
+            }
+        }
+        
+        if (unreachable) {
+            return {
+                {"success", false},
+                {"status", "unreachable"},
+                {"message", "Destination cannot be reached from source"}
+            };
+        }
+        return {
+            {"success", false},
+            {"status", "no_path"},
+            {"message", "No path found"}
+        };
+    }
+    
+    json response;
+    response["success"] = true;
+    response["status"] = "ok";
+    response["path"] = json::array();
+    response["totalTime"] = totalTime;
+    response["estimatedDistance"] = totalTime * 0.5;
+    
+    auto pushSnap = [&](const SnapPoint& p) {
+        response["path"].push_back({
+            {"lat", p.lat},
+            {"lng", p.lng},
+            {"snapped", true},
+            {"offsetKm", p.distanceKm}
+        });
+    };
+    
+    if (snapped[0]) {
+        pushSnap(snaps[0]);
+    }
+    
+    for (int id : path) {
+        json j = junctionJson(id);
+        if (!j.is_null()) {
+            response["path"].push_back(j);
+        }
+    }
+    
+    if (snapped[1]) {
+        pushSnap(snaps[1]);
+    }
+    
+    return response;
+}
+
+int main(int argc, char** argv) {
     Server svr;
+    bool perfectHash = false;
+    
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--perfect-hash") {
+            perfectHash = true;
+        }
+    }
     
     std::cout << "\n========================================" << std::endl;
     std::cout << "  SMART TRAFFIC API SERVER STARTING..." << std::endl;
@@ -74,6 +548,10 @@ int main() {
     std::cout << "Loading data..." << std::endl;
     loadData();
     
+    if (perfectHash) {
+        enablePerfectHash();
+    }
+    
     // ⭐ Handle CORS preflight requests
     svr.Options(".*", [](const Request& req, Response& res) {
         enableCORS(res);
@@ -91,7 +569,7 @@ int main() {
             {"timestamp", std::time(0)}
         };
         
-        res.set_content(response.dump(), "application/json");
+        sendJson(req, res, response);
         std::cout << "[API] GET /api/health - Server healthy" << std::endl;
     });
     
@@ -99,20 +577,544 @@ int main() {
     svr.Get("/api/junctions", [&](const Request& req, Response& res) {
         enableCORS(res);  // ⭐ IMPORTANT
         
-        json response;
-        response["junctions"] = json::array();
+        std::shared_ptr<const Payload> payload;
+        {
+            std::lock_guard<std::mutex> guard(junctionsPayloadMutex);
+            payload = junctionsPayload;
+        }
+        
+        if (!payload) {
+            payload = std::make_shared<const Payload>(json{{"junctions", json::array()}}.dump());
+        }
+        
+        sendPayload(req, res, *payload);
+        std::cout << "[API] GET /api/junctions - " << (res.status == 304 ? "Not modified" : "Returned")
+                  << " (" << payload->etag() << ")" << std::endl;
+    });
+    
+    // ⭐ Create a named junction while serving. It gets the next free ID and
+    // is found by name (search, names, nearest) and listed by GET
+    // /api/junctions at once; it has no roads yet, so routing only picks it
+    // up once it is in the data files.
+    svr.Post("/api/junctions", [&](const Request& req, Response& res) {
+        enableCORS(res);  // ⭐ IMPORTANT
+        
+        try {
+            auto body = json::parse(req.body);
+            std::string name = body["name"];
+            double lat = body["lat"];
+            double lng = body["lng"];
+            json response;
+            
+            int id = nextJunctionId++;
+            
+            // Claim the name first: of two concurrent creations (or a creation
+            // and a rename) with the same name only one wins, and nobody sees
+            // the loser's junction
+            if (name.empty() || name.size() > BTree::MAX_KEY) {
+                response = {
+                    {"success", false},
+                    {"message", name.empty() ? "Name required" : "Name too long"}
+                };
+            } else if (!liveNames.insert(name, id)) {
+                response = {
+                    {"success", false},
+                    {"message", "Name already taken"}
+                };
+            } else {
+                addJunction(Junction(id, name, lat, lng));
+                response = {
+                    {"success", true},
+                    {"id", id},
+                    {"message", "Junction created"}
+                };
+                std::cout << "[API] POST /api/junctions - " << id << ": " << name << std::endl;
+            }
+            
+            sendJson(req, res, response);
+            
+        } catch (const std::exception& e) {
+            json errorResponse = {
+                {"success", false},
+                {"message", std::string("Error: ") + e.what()}
+            };
+            sendJson(req, res, errorResponse);
+        }
+    });
+    
+    // ⭐ Rename a junction while serving
+    svr.Post("/api/junctions/rename", [&](const Request& req, Response& res) {
+        enableCORS(res);  // ⭐ IMPORTANT
+        
+        try {
+            auto body = json::parse(req.body);
+            int id = body["id"];
+            std::string name = body["name"];
+            
+            std::lock_guard<std::mutex> renaming(renameMutex);
+            JunctionHandle current = junctionMeta.find(id);
+            json response;
+            
+            if (!current) {
+                response = {
+                    {"success", false},
+                    {"message", "Unknown junction"}
+                };
+            } else if (name.empty() || name.size() > BTree::MAX_KEY) {
+                response = {
+                    {"success", false},
+                    {"message", name.empty() ? "Name required" : "Name too long"}
+                };
+            } else if (name != current->name && !liveNames.insert(name, id)) {
+                // Names stay unique, as on creation
+                response = {
+                    {"success", false},
+                    {"message", "Name already taken"}
+                };
+            } else if (name != current->name) {
+                std::string oldName(current->name);
+                junctionMeta.insert(Junction(id, name, current->lat, current->lng));
+                liveNames.erase(oldName, id);
+                addedNames.erase(oldName, id);
+                uint32_t loadedId;
+                if (!nameDictionary.find(name, loadedId) || (int)loadedId != id) {
+                    addedNames.assign(name, id);
+                }
+                {
+                    std::unique_lock<std::shared_mutex> guard(namesMutex);
+                    if (btree.search(oldName) == id) {
+                        btree.remove(oldName);
+                    }
+                    btree.insert(name, id);
+                    placeNames.remove(oldName, junctionPlace(id));
+                    placeNames.insert(name, junctionPlace(id));
+                    fuzzyNames.remove(oldName, junctionPlace(id));
+                    fuzzyNames.add(name, junctionPlace(id));
+                    popularity.insert(name, junctionPlace(id));
+                    tokenNames.remove(oldName, junctionPlace(id));
+                    tokenNames.add(name, junctionPlace(id));
+                }
+                recordJunction(id, false);
+                response = {
+                    {"success", true},
+                    {"message", "Junction renamed"}
+                };
+                std::cout << "[API] POST /api/junctions/rename - " << id << ": "
+                          << current->name << " -> " << name << std::endl;
+            } else {
+                response = {
+                    {"success", true},
+                    {"message", "Junction already has that name"}
+                };
+            }
+            
+            sendJson(req, res, response);
+            
+        } catch (const std::exception& e) {
+            json errorResponse = {
+                {"success", false},
+                {"message", std::string("Error: ") + e.what()}
+            };
+            sendJson(req, res, errorResponse);
+        }
+    });
+    
+    // ⭐ Junctions and roads whose name starts with a prefix, paged by cursor
+    // (or rank=popular: most routed first); or, with q=, names holding every
+    // word of q in any order, ignoring case and accents (fuzzy=1: whole
+    // names allowing typos instead)
+    svr.Get("/api/search", [&](const Request& req, Response& res) {
+        enableCORS(res);  // ⭐ IMPORTANT
+        
+        try {
+            std::string prefix = req.get_param_value("prefix");
+            std::string cursor = req.get_param_value("cursor");
+            int limit = req.has_param("limit") ? std::stoi(req.get_param_value("limit")) : SEARCH_DEFAULT_LIMIT;
+            limit = std::max(1, std::min(limit, SEARCH_MAX_LIMIT));
+            
+            json response;
+            response["success"] = true;
+            response["results"] = json::array();
+            
+            if (req.has_param("q") && req.get_param_value("fuzzy") != "1") {
+                std::string q = req.get_param_value("q");
+                
+                {
+                    // The store placeJson() reads changes under namesMutex too
+                    std::shared_lock<std::shared_mutex> guard(namesMutex);
+                    for (uint32_t place : tokenNames.search(q, limit)) {
+                        json j = placeJson(place);
+                        if (!j.is_null()) {
+                            response["results"].push_back(j);
+                        }
+                    }
+                }
+                
+                sendJson(req, res, response);
+                std::cout << "[API] GET /api/search - words \"" << q << "\": "
+                          << response["results"].size() << " results" << std::endl;
+                return;
+            }
+            
+            if (req.has_param("q")) {
+                std::string q = req.get_param_value("q");
+                int maxEdits = FuzzyIndex::editBudget(q);
+                
+                {
+                    // Closest first; distance is the number of edits from the query
+                    std::shared_lock<std::shared_mutex> guard(namesMutex);
+                    for (auto& match : fuzzyNames.search(q, maxEdits, limit)) {
+                        json j = placeJson(match.value);
+                        if (!j.is_null()) {
+                            j["distance"] = match.distance;
+                            response["results"].push_back(j);
+                        }
+                    }
+                }
+                
+                sendJson(req, res, response);
+                std::cout << "[API] GET /api/search - q=\"" << q << "\" (" << maxEdits << " edits): "
+                          << response["results"].size() << " results" << std::endl;
+                return;
+            }
+            
+            // Most popular completions first: top `limit` only, no paging
+            if (req.get_param_value("rank") == "popular") {
+                std::shared_lock<std::shared_mutex> guard(namesMutex);
+                for (auto [place, score] : popularity.topK(prefix, limit)) {
+                    json j = placeJson(place);
+                    if (!j.is_null()) {
+                        j["popularity"] = score;
+                        response["results"].push_back(j);
+                    }
+                }
+                guard.unlock();
+                
+                response["nextCursor"] = nullptr;
+                sendJson(req, res, response);
+                std::cout << "[API] GET /api/search - \"" << prefix << "\" by popularity: "
+                          << response["results"].size() << " results" << std::endl;
+                return;
+            }
+            
+            std::string lastName;
+            std::string nextCursor;
+            {
+                // Whole names at a time; one more name is peeked to know whether to hand out a cursor
+                std::shared_lock<std::shared_mutex> guard(namesMutex);
+                placeNames.complete(prefix, cursor, [&](const std::string& name, const std::vector<uint32_t>& places) {
+                    if ((int)response["results"].size() >= limit) {
+                        nextCursor = lastName;
+                        return false;
+                    }
+                    
+                    for (uint32_t place : places) {
+                        json j = placeJson(place);
+                        if (!j.is_null()) {
+                            response["results"].push_back(j);
+                        }
+                    }
+                    lastName = name;
+                    return true;
+                });
+            }
+            
+            response["nextCursor"] = nextCursor.empty() ? json(nullptr) : json(nextCursor);
+            
+            sendJson(req, res, response);
+            std::cout << "[API] GET /api/search - \"" << prefix << "\": "
+                      << response["results"].size() << " results" << std::endl;
+            
+        } catch (const std::exception& e) {
+            json errorResponse = {
+                {"success", false},
+                {"message", std::string("Error: ") + e.what()}
+            };
+            sendJson(req, res, errorResponse);
+        }
+    });
+    
+    // ⭐ Junction name dictionary: exact name, prefix (paged by cursor) or
+    // name range [from, to). Answers come from the mapped dictionary, which
+    // holds the names as loaded (junctions renamed since then are left
+    // out), merged with the names bound since (addedNames).
+    svr.Get("/api/names", [&](const Request& req, Response& res) {
+        enableCORS(res);  // ⭐ IMPORTANT
+        
+        try {
+            int limit = req.has_param("limit") ? std::stoi(req.get_param_value("limit")) : SEARCH_DEFAULT_LIMIT;
+            limit = std::max(1, std::min(limit, SEARCH_MAX_LIMIT));
+            
+            json response;
+            response["success"] = true;
+            response["results"] = json::array();
+            
+            // Entries still naming their junction
+            auto current = [](std::string_view name, uint32_t id) {
+                JunctionHandle meta = junctionMeta.find(id);
+                return meta && meta->name == name;
+            };
+            
+            if (req.has_param("name")) {
+                std::string name = req.get_param_value("name");
+                uint32_t id;
+                
+                if (nameDictionary.find(name, id) && current(name, id)) {
+                    response["results"].push_back({{"name", name}, {"id", id}});
+                } else {
+                    int live = liveNames.find(name);
+                    if (live != ConcurrentSkipList::NONE) {
+                        response["results"].push_back({{"name", name}, {"id", live}});
+                    }
+                }
+                
+                sendJson(req, res, response);
+                std::cout << "[API] GET /api/names - \"" << name << "\": "
+                          << response["results"].size() << " results" << std::endl;
+                return;
+            }
+            
+            // Up to limit + 1 current entries from each source, in name order
+            typedef std::vector<std::pair<std::string, uint32_t>> Page;
+            Page loaded, added;
+            auto collectInto = [&](Page& page) {
+                return [&](std::string_view name, uint32_t id) {
+                    if (current(name, id)) {
+                        page.push_back({std::string(name), id});
+                    }
+                    return (int)page.size() <= limit;
+                };
+            };
+            auto collectLoaded = collectInto(loaded);
+            auto collectAdded = collectInto(added);
+            
+            if (req.has_param("from") || req.has_param("to")) {
+                std::string from = req.get_param_value("from");
+                std::string to = req.has_param("to") ? req.get_param_value("to") : std::string(1, '\xff');
+                nameDictionary.range(from, to, collectLoaded);
+                addedNames.range(from, to, collectAdded);
+            } else {
+                std::string prefix = req.get_param_value("prefix");
+                std::string cursor = req.get_param_value("cursor");
+                nameDictionary.prefix(prefix, cursor, collectLoaded);
+                addedNames.scan(prefix, cursor, collectAdded);
+            }
+            
+            Page page;
+            std::merge(loaded.begin(), loaded.end(), added.begin(), added.end(), std::back_inserter(page));
+            
+            std::string nextCursor;
+            if ((int)page.size() > limit) {
+                page.resize(limit);
+                nextCursor = page.back().first;
+            }
+            for (auto& [name, id] : page) {
+                response["results"].push_back({{"name", name}, {"id", id}});
+            }
+            
+            response["nextCursor"] = nextCursor.empty() ? json(nullptr) : json(nextCursor);
+            
+            sendJson(req, res, response);
+            std::cout << "[API] GET /api/names - " << response["results"].size() << " of "
+                      << nameDictionary.size() << " names" << std::endl;
+            
+        } catch (const std::exception& e) {
+            json errorResponse = {
+                {"success", false},
+                {"message", std::string("Error: ") + e.what()}
+            };
+            sendJson(req, res, errorResponse);
+        }
+    });
+    
+    // ⭐ Nearest junctions to a GPS coordinate (k nearest, or the k nearest within
+    // radius km; k defaults to 1, or to the cap for a radius query)
+    svr.Get("/api/nearest", [&](const Request& req, Response& res) {
+        enableCORS(res);  // ⭐ IMPORTANT
+        
+        try {
+            double lat = std::stod(req.get_param_value("lat"));
+            double lng = std::stod(req.get_param_value("lng"));
+            bool byRadius = req.has_param("radius");
+            double radius = byRadius ? std::stod(req.get_param_value("radius")) : 0;
+            int k = req.has_param("k") ? std::stoi(req.get_param_value("k")) : (byRadius ? NEAREST_MAX_LIMIT : 1);
+            k = std::max(1, std::min(k, NEAREST_MAX_LIMIT));
+            
+            json response;
+            response["success"] = true;
+            response["junctions"] = json::array();
+            {
+                // Junctions created while serving change the index and the store
+                std::shared_lock<std::shared_mutex> guard(graphMutex);
+                std::vector<SpatialHit> hits = byRadius
+                    ? junctionIndex.nearest(lat, lng, k, std::max(0.0, radius))
+                    : junctionIndex.nearest(lat, lng, k);
+                
+                for (auto& hit : hits) {
+                    json j = junctionJson(hit.id);
+                    if (!j.is_null()) {
+                        j["distanceKm"] = hit.distanceKm;
+                        response["junctions"].push_back(j);
+                    }
+                }
+            }
+            
+            sendJson(req, res, response);
+            std::cout << "[API] GET /api/nearest - Returned " 
+                      << response["junctions"].size() << " junctions" << std::endl;
+            
+        } catch (const std::exception& e) {
+            json errorResponse = {
+                {"success", false},
+                {"message", std::string("Error: ") + e.what()}
+            };
+            sendJson(req, res, errorResponse);
+        }
+    });
+    
+    // ⭐ Junctions and roads inside a map viewport, with live traffic multipliers
+    svr.Get("/api/viewport", [&](const Request& req, Response& res) {
+        enableCORS(res);  // ⭐ IMPORTANT
         
-        std::ifstream jFile("data/junctions.json");
-        if (jFile.is_open()) {
-            json jData;
-            jFile >> jData;
-            response["junctions"] = jData["junctions"];
-            jFile.close();
+        try {
+            double minLat = std::stod(req.get_param_value("minLat"));
+            double minLng = std::stod(req.get_param_value("minLng"));
+            double maxLat = std::stod(req.get_param_value("maxLat"));
+            double maxLng = std::stod(req.get_param_value("maxLng"));
+            int zoom = req.has_param("zoom") ? std::stoi(req.get_param_value("zoom")) : VIEWPORT_DETAIL_ZOOM;
+            
+            // Road budget for this zoom: halves per level below full detail
+            int below = std::max(0, std::min(VIEWPORT_DETAIL_ZOOM - zoom, 30));
+            size_t budget = std::max(VIEWPORT_MIN_ROADS, VIEWPORT_MAX_ROADS >> below);
+            
+            struct ViewRoad {
+                int from;
+                int to;
+                double importance;
+            };
+            
+            std::vector<ViewRoad> roads;
+            std::vector<int> junctionIds;
+            bool decimated = false;
+            
+            json response;
+            response["success"] = true;
+            response["zoom"] = zoom;
+            response["roads"] = json::array();
+            response["junctions"] = json::array();
+            
+            std::shared_lock<std::shared_mutex> guard(graphMutex);
+            
+            // Importance: length times free-flow speed, so long fast arterials survive decimation
+            for (auto [u, v] : roadIndex.inBox(minLat, minLng, maxLat, maxLng)) {
+                double importance = 0;
+                for (auto& edge : graph.edges(u)) {
+                    if (edge.to == v && edge.baseTime > 0) {
+                        importance = std::max(importance, edge.distance * edge.distance / edge.baseTime);
+                    }
+                }
+                roads.push_back({u, v, importance});
+            }
+            
+            if (roads.size() > budget) {
+                std::nth_element(roads.begin(), roads.begin() + budget, roads.end(),
+                    [](const ViewRoad& a, const ViewRoad& b) { return a.importance > b.importance; });
+                roads.resize(budget);
+                decimated = true;
+            }
+            
+            // Current time over base time per direction; null when closed or missing
+            auto multiplier = [&](int u, int v) -> json {
+                for (auto& edge : graph.edges(u)) {
+                    if (edge.to == v && edge.baseTime > 0 &&
+                        edge.currentTime != std::numeric_limits<double>::infinity()) {
+                        return edge.currentTime / edge.baseTime;
+                    }
+                }
+                return nullptr;
+            };
+            
+            for (auto& r : roads) {
+                response["roads"].push_back({
+                    {"from", graph.junctionId(r.from)},
+                    {"to", graph.junctionId(r.to)},
+                    {"path", {{graph.latitude(r.from), graph.longitude(r.from)},
+                              {graph.latitude(r.to), graph.longitude(r.to)}}},
+                    {"forward", multiplier(r.from, r.to)},
+                    {"backward", multiplier(r.to, r.from)}
+                });
+            }
+            
+            // Once roads are decimated only junctions on the kept roads are shown
+            if (decimated) {
+                for (auto& r : roads) {
+                    junctionIds.push_back(graph.junctionId(r.from));
+                    junctionIds.push_back(graph.junctionId(r.to));
+                }
+                std::sort(junctionIds.begin(), junctionIds.end());
+                junctionIds.erase(std::unique(junctionIds.begin(), junctionIds.end()), junctionIds.end());
+            } else {
+                junctionIds = junctionIndex.inBox(minLat, minLng, maxLat, maxLng);
+            }
+            
+            for (int id : junctionIds) {
+                json j = junctionJson(id);
+                if (!j.is_null() && j["lat"] >= minLat && j["lat"] <= maxLat &&
+                    j["lng"] >= minLng && j["lng"] <= maxLng) {
+                    response["junctions"].push_back(j);
+                }
+            }
+            
+            response["decimated"] = decimated;
+            
+            sendJson(req, res, response);
+            std::cout << "[API] GET /api/viewport - Returned " << response["junctions"].size()
+                      << " junctions, " << response["roads"].size() << " roads (zoom "
+                      << zoom << ")" << std::endl;
+            
+        } catch (const std::exception& e) {
+            json errorResponse = {
+                {"success", false},
+                {"message", std::string("Error: ") + e.what()}
+            };
+            sendJson(req, res, errorResponse);
         }
+    });
+    
+    // ⭐ Live traffic map as vector tiles (Mapbox Vector Tile encoding)
+    svr.Get("/api/tiles/:z/:x/:y", [&](const Request& req, Response& res) {
+        enableCORS(res);  // ⭐ IMPORTANT
         
-        res.set_content(response.dump(), "application/json");
-        std::cout << "[API] GET /api/junctions - Returned " 
-                  << response["junctions"].size() << " junctions" << std::endl;
+        try {
+            int z = std::stoi(req.path_params.at("z"));
+            int x = std::stoi(req.path_params.at("x"));
+            int y = std::stoi(req.path_params.at("y"));
+            
+            if (!tileCache.isValidTile(z, x, y)) {
+                res.status = 404;
+                return;
+            }
+            
+            std::shared_ptr<const Payload> tile;
+            {
+                std::shared_lock<std::shared_mutex> guard(graphMutex);
+                tile = tileCache.tile(z, x, y);
+            }
+            
+            if (tile->body().empty()) {
+                res.status = 204;
+                return;
+            }
+            
+            sendPayload(req, res, *tile, "application/vnd.mapbox-vector-tile");
+            
+        } catch (const std::exception& e) {
+            json errorResponse = {
+                {"success", false},
+                {"message", std::string("Error: ") + e.what()}
+            };
+            sendJson(req, res, errorResponse);
+        }
     });
     
     // ⭐ Find shortest path
@@ -121,42 +1123,109 @@ int main() {
         
         try {
             auto body = json::parse(req.body);
+            
+            // GPS coordinates instead of junction IDs: snap to roads first
+            if (body["source"].is_object() || body["destination"].is_object()) {
+                std::cout << "[API] POST /api/path - Routing from coordinates" << std::endl;
+                
+                std::shared_lock<std::shared_mutex> guard(graphMutex);
+                sendJson(req, res, routeSnapped(body["source"], body["destination"]));
+                return;
+            }
+            
             int source = body["source"];
             int destination = body["destination"];
+            bool timeOnly = body.value("timeOnly", false);
+            double epsilon = body.value("epsilon", 0.0);
             
             std::cout << "[API] POST /api/path - Finding path: " 
                       << source << " -> " << destination << std::endl;
             
-            auto [path, totalTime] = graph.dijkstra(source, destination);
+            thread_local Graph::SearchWorkspace ws;
+            std::shared_lock<std::shared_mutex> guard(graphMutex);
+            
+            if (graph.findIndex(source) == -1 || graph.findIndex(destination) == -1) {
+                json errorResponse = {
+                    {"success", false},
+                    {"status", "unknown_junction"},
+                    {"message", "Unknown junction"}
+                };
+                sendJson(req, res, errorResponse);
+                return;
+            }
+            
+            // Both ends of every routed request count toward place popularity
+            {
+                std::shared_lock<std::shared_mutex> names(namesMutex);
+                popularity.bump(junctionPlace(source));
+                popularity.bump(junctionPlace(destination));
+            }
+            
+            // Component index rejects pairs in different components without searching
+            if (graph.isUnreachable(source, destination)) {
+                json errorResponse = {
+                    {"success", false},
+                    {"status", "unreachable"},
+                    {"message", "Destination cannot be reached from source"}
+                };
+                sendJson(req, res, errorResponse);
+                std::cout << "[API] POST /api/path - Unreachable pair rejected" << std::endl;
+                return;
+            }
+            
+            // Long trips that only need an ETA are answered from the transit table
+            double tableTime;
+            
+            if (timeOnly && transitNodes.query(graph, source, destination, tableTime)) {
+                json response = {
+                    {"success", tableTime >= 0},
+                    {"status", tableTime >= 0 ? "ok" : "no_path"},
+                    {"totalTime", tableTime},
+                    {"engine", "transit"}
+                };
+                
+                if (tableTime < 0) {
+                    response["message"] = "No path found";
+                }
+                
+                sendJson(req, res, response);
+                return;
+            }
+            
+            // epsilon > 0 trades optimality (within 1 + epsilon) for a smaller search
+            auto [path, totalTime] = epsilon > 0
+                ? approximateRouter.shortestPath(graph, source, destination, epsilon, ws)
+                : arcFlags.shortestPath(graph, source, destination, ws);
             
             if (path.empty()) {
                 json errorResponse = {
                     {"success", false},
+                    {"status", "no_path"},
                     {"message", "No path found"}
                 };
-                res.set_content(errorResponse.dump(), "application/json");
+                sendJson(req, res, errorResponse);
                 return;
             }
             
             json response;
             response["success"] = true;
+            response["status"] = "ok";
             response["path"] = json::array();
             response["totalTime"] = totalTime;
             response["estimatedDistance"] = totalTime * 0.5;
             
+            if (epsilon > 0) {
+                response["epsilon"] = epsilon;
+            }
+            
             for (int id : path) {
-                Junction* j = hashtable.search(id);
-                if (j) {
-                    response["path"].push_back({
-                        {"id", j->id},
-                        {"name", j->name},
-                        {"lat", j->lat},
-                        {"lng", j->lng}
-                    });
+                json j = junctionJson(id);
+                if (!j.is_null()) {
+                    response["path"].push_back(j);
                 }
             }
             
-            res.set_content(response.dump(), "application/json");
+            sendJson(req, res, response);
             std::cout << "[Dijkstra] Path found! Total time: " 
                       << totalTime << " minutes" << std::endl;
             
@@ -165,7 +1234,221 @@ int main() {
                 {"success", false},
                 {"message", std::string("Error: ") + e.what()}
             };
-            res.set_content(errorResponse.dump(), "application/json");
+            sendJson(req, res, errorResponse);
+        }
+    });
+    
+    // ⭐ Solve many (source, destination) pairs on the worker pool.
+    // Results are streamed as NDJSON lines in completion order.
+    svr.Post("/api/path/batch", [&](const Request& req, Response& res) {
+        enableCORS(res);  // ⭐ IMPORTANT
+        
+        auto batch = std::make_shared<PathBatch>();
+        
+        try {
+            auto body = json::parse(req.body);
+            batch->timeOnly = body.value("timeOnly", false);
+            batch->epsilon = body.value("epsilon", 0.0);
+            
+            for (auto& p : body["pairs"]) {
+                if (p.is_array()) {
+                    batch->pairs.push_back({p[0], p[1]});
+                } else {
+                    batch->pairs.push_back({p["source"], p["destination"]});
+                }
+            }
+        } catch (const std::exception& e) {
+            json errorResponse = {
+                {"success", false},
+                {"message", std::string("Error: ") + e.what()}
+            };
+            sendJson(req, res, errorResponse);
+            return;
+        }
+        
+        size_t total = batch->pairs.size();
+        batch->results.resize(total);
+        batch->statuses.resize(total);
+        batch->finished.reserve(total);
+        
+        std::cout << "[API] POST /api/path/batch - Solving " << total
+                  << " pairs on " << routingPool.size() << " workers" << std::endl;
+        
+        for (size_t begin = 0; begin < total; begin += PATH_BATCH_CHUNK) {
+            size_t end = std::min(total, begin + PATH_BATCH_CHUNK);
+            
+            routingPool.submit([batch, begin, end](size_t worker) {
+                if (batch->cancelled) {
+                    return;
+                }
+                
+                auto& ws = routingWorkspaces[worker];
+                {
+                    std::shared_lock<std::shared_mutex> guard(graphMutex);
+                    
+                    for (size_t i = begin; i < end; i++) {
+                        auto [source, destination] = batch->pairs[i];
+                        double tableTime;
+                        
+                        // Checked first: the searches answer source == dest without looking it up
+                        if (graph.findIndex(source) == -1 || graph.findIndex(destination) == -1) {
+                            batch->results[i] = {std::vector<int>(), -1};
+                            batch->statuses[i] = "unknown_junction";
+                            continue;
+                        }
+                        if (graph.isUnreachable(source, destination)) {
+                            batch->results[i] = {std::vector<int>(), -1};
+                            batch->statuses[i] = "unreachable";
+                            continue;
+                        }
+                        
+                        if (batch->timeOnly && transitNodes.query(graph, source, destination, tableTime)) {
+                            batch->results[i] = {std::vector<int>(), tableTime};
+                        } else if (batch->epsilon > 0) {
+                            batch->results[i] = approximateRouter.shortestPath(graph, source, destination, batch->epsilon, ws);
+                        } else {
+                            batch->results[i] = arcFlags.shortestPath(graph, source, destination, ws);
+                        }
+                        batch->statuses[i] = batch->results[i].second >= 0 ? "ok" : "no_path";
+                    }
+                }
+                {
+                    std::lock_guard<std::mutex> guard(batch->lock);
+                    
+                    for (size_t i = begin; i < end; i++) {
+                        batch->finished.push_back(i);
+                    }
+                }
+                batch->progress.notify_one();
+            });
+        }
+        
+        size_t emitted = 0;
+        
+        // Compressed as it streams; each chunk is flushed so lines arrive as they are solved
+        Encoding encoding = Compression::negotiate(req.get_header_value("Accept-Encoding"));
+        auto compressor = std::make_shared<Compression::Stream>(encoding);
+        res.set_header("Vary", "Accept-Encoding");
+        if (encoding != Encoding::IDENTITY) {
+            res.set_header("Content-Encoding", Compression::name(encoding));
+        }
+        
+        res.set_chunked_content_provider("application/x-ndjson",
+            [batch, total, emitted, compressor](size_t, DataSink& sink) mutable {
+                std::vector<size_t> ready;
+                {
+                    std::unique_lock<std::mutex> guard(batch->lock);
+                    batch->progress.wait(guard, [&] {
+                        return batch->finished.size() > emitted || emitted == total;
+                    });
+                    ready.assign(batch->finished.begin() + emitted, batch->finished.end());
+                }
+                
+                std::string chunk;
+                
+                for (size_t i : ready) {
+                    auto& [path, totalTime] = batch->results[i];
+                    json line = {
+                        {"index", i},
+                        {"source", batch->pairs[i].first},
+                        {"destination", batch->pairs[i].second},
+                        {"success", totalTime >= 0},
+                        {"status", batch->statuses[i]}
+                    };
+                    std::string status = batch->statuses[i];
+                    
+                    if (status == "unknown_junction") {
+                        line["message"] = "Unknown junction";
+                    } else if (status == "unreachable") {
+                        line["message"] = "Destination cannot be reached from source";
+                    } else if (status == "no_path") {
+                        line["message"] = "No path found";
+                    } else {
+                        line["totalTime"] = totalTime;
+                        
+                        if (!batch->timeOnly) {
+                            line["path"] = path;
+                        }
+                    }
+                    
+                    chunk += line.dump();
+                    chunk += '\n';
+                }
+                
+                emitted += ready.size();
+                
+                if (!chunk.empty()) {
+                    chunk = compressor->write(chunk);
+                }
+                if (emitted == total) {
+                    chunk += compressor->finish();
+                }
+                
+                if (!chunk.empty() && !sink.write(chunk.data(), chunk.size())) {
+                    batch->cancelled = true;
+                    return false;
+                }
+                
+                if (emitted == total) {
+                    sink.done();
+                }
+                return true;
+            },
+            [batch](bool success) {
+                if (!success) {
+                    batch->cancelled = true;
+                }
+            });
+    });
+    
+    // ⭐ Map-match a GPS trace onto the road network
+    svr.Post("/api/match", [&](const Request& req, Response& res) {
+        enableCORS(res);  // ⭐ IMPORTANT
+        
+        try {
+            auto body = json::parse(req.body);
+            
+            json response;
+            response["success"] = true;
+            response["points"] = json::array();
+            
+            std::shared_lock<std::shared_mutex> guard(graphMutex);
+            MapMatcher matcher(graph, roadIndex);
+            
+            auto emit = [&](const std::vector<MatchedPoint>& decided) {
+                for (auto& m : decided) {
+                    json point = {
+                        {"index", m.sequence},
+                        {"matched", m.matched}
+                    };
+                    
+                    if (m.matched) {
+                        point["lat"] = m.position.lat;
+                        point["lng"] = m.position.lng;
+                        point["from"] = graph.junctionId(m.position.from);
+                        point["to"] = graph.junctionId(m.position.to);
+                        point["fraction"] = m.position.fraction;
+                    }
+                    
+                    response["points"].push_back(point);
+                }
+            };
+            
+            for (auto& p : body["points"]) {
+                emit(matcher.push({p["lat"], p["lng"]}));
+            }
+            emit(matcher.flush());
+            
+            sendJson(req, res, response);
+            std::cout << "[API] POST /api/match - Matched " 
+                      << response["points"].size() << " points" << std::endl;
+            
+        } catch (const std::exception& e) {
+            json errorResponse = {
+                {"success", false},
+                {"message", std::string("Error: ") + e.what()}
+            };
+            sendJson(req, res, errorResponse);
         }
     });
     
@@ -182,21 +1465,63 @@ int main() {
             std::cout << "[API] POST /api/traffic - Updating: " 
                       << from << " <-> " << to << " (x" << multiplier << ")" << std::endl;
             
-            graph.updateTraffic(from, to, multiplier);
+            {
+                std::unique_lock<std::shared_mutex> guard(graphMutex);
+                graph.updateTraffic(from, to, multiplier);
+            }
             
             json response = {
                 {"success", true},
                 {"message", "Traffic updated successfully"}
             };
             
-            res.set_content(response.dump(), "application/json");
+            sendJson(req, res, response);
+            
+        } catch (const std::exception& e) {
+            json errorResponse = {
+                {"success", false},
+                {"message", std::string("Error: ") + e.what()}
+            };
+            sendJson(req, res, errorResponse);
+        }
+    });
+    
+    // ⭐ Close or reopen a road (one direction unless bidirectional)
+    svr.Post("/api/closure", [&](const Request& req, Response& res) {
+        enableCORS(res);  // ⭐ IMPORTANT
+        
+        try {
+            auto body = json::parse(req.body);
+            int from = body["from"];
+            int to = body["to"];
+            bool closed = body.value("closed", true);
+            bool bidirectional = body.value("bidirectional", true);
+            
+            std::cout << "[API] POST /api/closure - " << (closed ? "Closing: " : "Reopening: ")
+                      << from << (bidirectional ? " <-> " : " -> ") << to << std::endl;
+            
+            {
+                std::unique_lock<std::shared_mutex> guard(graphMutex);
+                graph.setRoadClosed(from, to, closed);
+                
+                if (bidirectional) {
+                    graph.setRoadClosed(to, from, closed);
+                }
+            }
+            
+            json response = {
+                {"success", true},
+                {"message", closed ? "Road closed" : "Road reopened"}
+            };
+            
+            sendJson(req, res, response);
             
         } catch (const std::exception& e) {
             json errorResponse = {
                 {"success", false},
                 {"message", std::string("Error: ") + e.what()}
             };
-            res.set_content(errorResponse.dump(), "application/json");
+            sendJson(req, res, errorResponse);
         }
     });
     
@@ -205,8 +1530,18 @@ int main() {
     std::cout << "========================================" << std::endl;
     std::cout << "Available Endpoints:" << std::endl;
     std::cout << "  GET  /api/junctions        - Get all junctions" << std::endl;
+    std::cout << "  POST /api/junctions        - Create a named junction" << std::endl;
+    std::cout << "  POST /api/junctions/rename - Rename a junction" << std::endl;
+    std::cout << "  GET  /api/names            - Junction name dictionary: exact, prefix or range" << std::endl;
+    std::cout << "  GET  /api/search           - Search junctions and roads by name prefix, words or fuzzy q" << std::endl;
+    std::cout << "  GET  /api/nearest          - Nearest junctions to lat/lng" << std::endl;
+    std::cout << "  GET  /api/viewport         - Junctions and roads in a map box" << std::endl;
+    std::cout << "  GET  /api/tiles/z/x/y      - Traffic map vector tile" << std::endl;
     std::cout << "  POST /api/path             - Find shortest path" << std::endl;
+    std::cout << "  POST /api/path/batch       - Stream many shortest paths" << std::endl;
+    std::cout << "  POST /api/match            - Map-match a GPS trace" << std::endl;
     std::cout << "  POST /api/traffic          - Update traffic" << std::endl;
+    std::cout << "  POST /api/closure          - Close or reopen a road" << std::endl;
     std::cout << "  GET  /api/health           - Health check" << std::endl;
     std::cout << "Press Ctrl+C to stop server..." << std::endl;
     
@@ -0,0 +1,379 @@
+#ifndef ARCFLAGS_H
+#define ARCFLAGS_H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "graph.h"
+#include "partition.h"
+using namespace std;
+
+// Arc-flags goal-directed routing.
+//
+// Junctions are split into regions; every directed edge gets one bit per
+// region, set when the edge lies on some shortest path (by baseTime) into
+// that region. A query towards region R only relaxes edges flagged for R.
+//
+// Flags describe base times. With live traffic a region stays exact as long
+// as no edge flagged for it got slower and no edge anywhere got faster than
+// its base time: every base-optimal path into R then keeps its cost while all
+// other paths can only get more expensive. Regions that fail this check are
+// searched without pruning until the edges are back at base time or the
+// flags are rebuilt. The check is kept up to date edge by edge as traffic
+// changes (trafficChanged()), so a query only reads two counters.
+//
+// A query into a region that fails it searches the flagged edges on base
+// times and keeps that route if none of its edges is slower now; only
+// queries whose base route is congested fall back to plain Dijkstra.
+class ArcFlags
+{
+
+private:
+    Partition partition;
+    vector<int> edgeOffset;       // node -> global index of its first edge
+    vector<uint64_t> flags;       // edge-major bit matrix, wordsPerEdge per edge
+    int wordsPerEdge;
+    unsigned long builtStructure;
+    bool built;
+
+    // Live traffic against base times, by edge: -1 faster, 0 same, 1 slower
+    vector<int8_t> edgeState;
+    vector<int> slowerFlagged;    // by region: slower edges flagged for it
+    int fasterEdges;
+
+    bool hasFlag(int edge, int region) const
+    {
+        return (flags[(size_t)edge * wordsPerEdge + region / 64] >> (region % 64)) & 1;
+    }
+
+    static void setFlag(vector<uint64_t>& matrix, int words, int edge, int region)
+    {
+        matrix[(size_t)edge * words + region / 64] |= uint64_t(1) << (region % 64);
+    }
+
+    static int8_t stateOf(const Graph::Edge& edge)
+    {
+        return edge.currentTime < edge.baseTime ? -1 : edge.currentTime > edge.baseTime;
+    }
+
+    void setState(int edge, int8_t state)
+    {
+        int8_t old = edgeState[edge];
+
+        if (old == state)
+        {
+            return;
+        }
+
+        fasterEdges += (state == -1) - (old == -1);
+
+        // Only a slower edge's own regions lose their guarantee
+        if ((old == 1) != (state == 1))
+        {
+            int delta = state == 1 ? 1 : -1;
+            const uint64_t* row = &flags[(size_t)edge * wordsPerEdge];
+
+            for (int w = 0; w < wordsPerEdge; w++)
+            {
+                for (uint64_t bits = row[w]; bits; bits &= bits - 1)
+                {
+                    slowerFlagged[w * 64 + __builtin_ctzll(bits)] += delta;
+                }
+            }
+        }
+        edgeState[edge] = state;
+    }
+
+public:
+    ArcFlags() : wordsPerEdge(0), builtStructure(0), built(false), fasterEdges(0) {}
+
+    // Precompute flags. One backward search per boundary node (a node with an
+    // incoming edge from another region), spread across worker threads.
+    void build(const Graph& graph, int regionCount, size_t threads)
+    {
+        int n = graph.nodeCount();
+        partition.build(graph, regionCount);
+
+        int regions = partition.size();
+        wordsPerEdge = (regions + 63) / 64;
+
+        edgeOffset.assign(n + 1, 0);
+
+        for (int u = 0; u < n; u++)
+        {
+            edgeOffset[u + 1] = edgeOffset[u] + graph.edges(u).size();
+        }
+
+        int m = edgeOffset[n];
+
+        // Reverse adjacency in CSR form: for node v, the edges u -> v
+        vector<int> revOffset(n + 1, 0);
+        vector<int> revFrom(m);
+        vector<int> revEdge(m);
+
+        for (int u = 0; u < n; u++)
+        {
+            for (const auto& edge : graph.edges(u))
+            {
+                revOffset[edge.to + 1]++;
+            }
+        }
+
+        for (int v = 0; v < n; v++)
+        {
+            revOffset[v + 1] += revOffset[v];
+        }
+
+        vector<int> fillPos(revOffset.begin(), revOffset.end() - 1);
+        vector<int> boundary;
+        vector<char> isBoundary(n, 0);
+
+        flags.assign((size_t)m * wordsPerEdge, 0);
+
+        for (int u = 0; u < n; u++)
+        {
+            const auto& out = graph.edges(u);
+
+            for (int k = 0; k < (int)out.size(); k++)
+            {
+                int v = out[k].to;
+                int e = edgeOffset[u] + k;
+
+                revFrom[fillPos[v]] = u;
+                revEdge[fillPos[v]++] = e;
+
+                if (partition.region(u) == partition.region(v))
+                {
+                    setFlag(flags, wordsPerEdge, e, partition.region(v));
+                }
+                else if (!isBoundary[v])
+                {
+                    isBoundary[v] = 1;
+                    boundary.push_back(v);
+                }
+            }
+        }
+
+        if (threads == 0)
+        {
+            threads = 1;
+        }
+
+        vector<vector<uint64_t>> local(threads, vector<uint64_t>(flags.size(), 0));
+        atomic<size_t> next(0);
+
+        auto worker = [&](size_t self)
+        {
+            vector<double> dist(n, numeric_limits<double>::infinity());
+            vector<int> reached;
+            vector<pair<double, int>> heap;
+            auto later = greater<pair<double, int>>();
+
+            for (size_t task = next++; task < boundary.size(); task = next++)
+            {
+                int target = boundary[task];
+                int region = partition.region(target);
+
+                for (int v : reached)
+                {
+                    dist[v] = numeric_limits<double>::infinity();
+                }
+                reached.clear();
+
+                dist[target] = 0;
+                reached.push_back(target);
+                heap.assign(1, {0, target});
+
+                while (!heap.empty())
+                {
+                    pop_heap(heap.begin(), heap.end(), later);
+                    auto [d, v] = heap.back();
+                    heap.pop_back();
+
+                    if (d > dist[v])
+                    {
+                        continue;
+                    }
+
+                    for (int i = revOffset[v]; i < revOffset[v + 1]; i++)
+                    {
+                        int u = revFrom[i];
+                        int k = revEdge[i] - edgeOffset[u];
+                        double candidate = d + graph.edges(u)[k].baseTime;
+
+                        if (candidate < dist[u])
+                        {
+                            if (dist[u] == numeric_limits<double>::infinity())
+                            {
+                                reached.push_back(u);
+                            }
+                            dist[u] = candidate;
+                            heap.push_back({candidate, u});
+                            push_heap(heap.begin(), heap.end(), later);
+                        }
+                    }
+                }
+
+                // Flag every edge of the shortest-path DAG towards target
+                for (int u : reached)
+                {
+                    const auto& out = graph.edges(u);
+
+                    for (int k = 0; k < (int)out.size(); k++)
+                    {
+                        double via = out[k].baseTime + dist[out[k].to];
+
+                        if (via <= dist[u] + 1e-9 * max(1.0, dist[u]))
+                        {
+                            setFlag(local[self], wordsPerEdge, edgeOffset[u] + k, region);
+                        }
+                    }
+                }
+            }
+        };
+
+        vector<thread> pool;
+
+        for (size_t i = 1; i < threads; i++)
+        {
+            pool.emplace_back(worker, i);
+        }
+
+        worker(0);
+
+        for (auto& t : pool)
+        {
+            t.join();
+        }
+
+        for (const auto& part : local)
+        {
+            for (size_t i = 0; i < flags.size(); i++)
+            {
+                flags[i] |= part[i];
+            }
+        }
+
+        // Traffic already on the roads
+        edgeState.assign(m, 0);
+        slowerFlagged.assign(regions, 0);
+        fasterEdges = 0;
+
+        for (int u = 0; u < n; u++)
+        {
+            const auto& out = graph.edges(u);
+
+            for (int k = 0; k < (int)out.size(); k++)
+            {
+                setState(edgeOffset[u] + k, stateOf(out[k]));
+            }
+        }
+
+        builtStructure = graph.getStructureVersion();
+        built = true;
+
+        cout << "[ArcFlags] " << regions << " regions, " << boundary.size()
+             << " boundary nodes, " << m << " edges flagged" << endl;
+    }
+
+    bool isReady(const Graph& graph) const
+    {
+        return built && builtStructure == graph.getStructureVersion();
+    }
+
+    // Record that the u -> v edges (dense indices) changed time; -1, -1 means
+    // any edge may have. Call from the graph's traffic listener, i.e. under
+    // the same write lock as the change.
+    void trafficChanged(const Graph& graph, int u, int v)
+    {
+        if (!isReady(graph))
+        {
+            return;
+        }
+
+        for (int from = u == -1 ? 0 : u; from < (u == -1 ? graph.nodeCount() : u + 1); from++)
+        {
+            const auto& out = graph.edges(from);
+
+            for (int k = 0; k < (int)out.size(); k++)
+            {
+                if (u == -1 || out[k].to == v)
+                {
+                    setState(edgeOffset[from] + k, stateOf(out[k]));
+                }
+            }
+        }
+    }
+
+    // Exact shortest path on currentTime, pruned by the destination's flags.
+    // pruned (if given) tells whether the flags could be used.
+    pair<vector<int>, double> shortestPath(const Graph& graph, int source, int dest, Graph::SearchWorkspace& ws,
+                                           bool* pruned = nullptr) const
+    {
+        int t = graph.findIndex(dest);
+
+        if (pruned)
+        {
+            *pruned = false;
+        }
+
+        if (!isReady(graph) || t == -1 || fasterEdges > 0)
+        {
+            return graph.shortestPath(source, dest, ws);
+        }
+
+        int region = partition.region(t);
+        auto flagged = [&](int u, int k)
+        {
+            return hasFlag(edgeOffset[u] + k, region);
+        };
+
+        if (slowerFlagged[region] == 0)
+        {
+            if (pruned)
+            {
+                *pruned = true;
+            }
+            return graph.shortestPath(source, dest, ws, flagged);
+        }
+
+        // Some edge flagged for the region is slower. The flags still lead to
+        // a base-optimal route; if none of its edges is slower now it costs
+        // the base distance, which no route can beat, so it is the answer.
+        auto route = graph.shortestPath(source, dest, ws, flagged, [](const Graph::Edge& edge)
+        {
+            return edge.baseTime;
+        });
+
+        if (route.second <= 0)
+        {
+            return route;    // same junction, or no route at all
+        }
+
+        double now = 0;
+
+        for (int v = t; ws.parent[v] != -1; v = ws.parent[v])
+        {
+            now += graph.edgeTime(ws.parent[v], v);
+        }
+
+        if (now > route.second * (1 + 1e-12))
+        {
+            return graph.shortestPath(source, dest, ws);
+        }
+
+        if (pruned)
+        {
+            *pruned = true;
+        }
+        return {route.first, now};
+    }
+
+    int regionCount() const
+    {
+        return partition.size();
+    }
+};
+
+#endif
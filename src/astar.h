@@ -0,0 +1,175 @@
+#ifndef ASTAR_H
+#define ASTAR_H
+
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <vector>
+#include "geo.h"
+#include "graph.h"
+using namespace std;
+
+// Bounded-suboptimal routing with weighted A*.
+//
+// The heuristic is straight-line distance to the destination times the
+// smallest minutes-per-km of any road under current traffic. Distances are
+// taken in a local equirectangular projection, which is a true metric, so
+// the estimate never exceeds the real remaining time. Inflating it by
+// (1 + epsilon) makes the search greedier towards the destination while the
+// returned time stays within (1 + epsilon) of optimal; epsilon = 0 is plain
+// A* and exact.
+class WeightedAStar
+{
+
+private:
+    mutable mutex refreshLock;
+    mutable atomic<unsigned long> checkedVersion;
+    mutable vector<double> x;      // projected km by dense node index
+    mutable vector<double> y;
+    mutable double minutesPerKm;   // 0 disables the heuristic
+
+    // Recompute projection and speed bound when roads or traffic changed
+    void refresh(const Graph& graph) const
+    {
+        unsigned long version = graph.getStructureVersion() * 1000003UL + graph.getTrafficVersion();
+
+        if (checkedVersion.load(memory_order_acquire) == version)
+        {
+            return;
+        }
+
+        lock_guard<mutex> guard(refreshLock);
+
+        if (checkedVersion.load(memory_order_relaxed) == version)
+        {
+            return;
+        }
+
+        int n = graph.nodeCount();
+        double latSum = 0;
+        bool allLocated = true;
+
+        for (int v = 0; v < n; v++)
+        {
+            latSum += graph.latitude(v);
+            allLocated = allLocated && (graph.latitude(v) != 0 || graph.longitude(v) != 0);
+        }
+
+        LocalProjection projection(n ? latSum / n : 0);
+        x.resize(n);
+        y.resize(n);
+
+        for (int v = 0; v < n; v++)
+        {
+            x[v] = projection.x(graph.longitude(v));
+            y[v] = projection.y(graph.latitude(v));
+        }
+
+        // A junction without coordinates could sit anywhere, so no bound holds
+        minutesPerKm = allLocated ? numeric_limits<double>::infinity() : 0;
+
+        for (int u = 0; u < n && minutesPerKm > 0; u++)
+        {
+            for (const auto& edge : graph.edges(u))
+            {
+                double length = hypot(x[u] - x[edge.to], y[u] - y[edge.to]);
+
+                if (length > 0)
+                {
+                    minutesPerKm = min(minutesPerKm, edge.currentTime / length);
+                }
+            }
+        }
+
+        if (minutesPerKm == numeric_limits<double>::infinity())
+        {
+            minutesPerKm = 0;
+        }
+
+        checkedVersion.store(version, memory_order_release);
+    }
+
+public:
+    WeightedAStar() : checkedVersion(~0UL), minutesPerKm(0) {}
+
+    pair<vector<int>, double> shortestPath(const Graph& graph, int source, int dest, double epsilon,
+                                           Graph::SearchWorkspace& ws) const
+    {
+        if (source == dest)
+        {
+            return {vector<int>{source}, 0};
+        }
+
+        int s = graph.findIndex(source);
+        int t = graph.findIndex(dest);
+
+        if (s == -1 || t == -1 || graph.reachability(s, t) == Graph::Reach::No)
+        {
+            return {vector<int>(), -1};
+        }
+
+        refresh(graph);
+
+        double weight = (1 + max(0.0, epsilon)) * minutesPerKm;
+        auto estimate = [&](int v)
+        {
+            return weight * hypot(x[v] - x[t], y[v] - y[t]);
+        };
+        auto later = greater<pair<double, int>>();
+
+        ws.reset(graph.nodeCount());
+        ws.settle(s, 0, -1);
+        ws.heap.push_back({estimate(s), s});
+
+        while (!ws.heap.empty())
+        {
+            pop_heap(ws.heap.begin(), ws.heap.end(), later);
+            auto [priority, u] = ws.heap.back();
+            ws.heap.pop_back();
+
+            if (u == t)
+            {
+                break;
+            }
+
+            double g = ws.distance(u);
+
+            // Stale entry: u was reached more cheaply after this was queued
+            if (priority > g + estimate(u) + 1e-9 * max(1.0, g))
+            {
+                continue;
+            }
+
+            for (const auto& edge : graph.edges(u))
+            {
+                double candidate = g + edge.currentTime;
+
+                if (candidate < ws.distance(edge.to))
+                {
+                    ws.settle(edge.to, candidate, u);
+                    ws.heap.push_back({candidate + estimate(edge.to), edge.to});
+                    push_heap(ws.heap.begin(), ws.heap.end(), later);
+                }
+            }
+        }
+
+        double total = ws.distance(t);
+
+        if (total == numeric_limits<double>::infinity())
+        {
+            return {vector<int>(), -1};
+        }
+
+        vector<int> path;
+
+        for (int current = t; current != -1; current = ws.parent[current])
+        {
+            path.push_back(graph.junctionId(current));
+        }
+
+        reverse(path.begin(), path.end());
+        return {path, total};
+    }
+};
+
+#endif
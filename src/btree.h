@@ -1,71 +1,791 @@
 #ifndef BTREE_H
 #define BTREE_H
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
-#include <map>
+#include <limits>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 using namespace std;
 
-class BTree 
+// B+tree from junction name to ID.
+//
+// Nodes hold up to 64 keys, so a lookup touches a handful of nodes instead
+// of one heap node per key. Each node is one fixed-size block: the sorted
+// keys' common prefix is stored once and the rest of each key sits in an
+// inline byte buffer addressed by an offset table, next to the values
+// (leaves) or child pointers (inner nodes). A node splits when it runs out
+// of slots or of bytes. Inner nodes keep only the shortest separator that
+// tells two children apart. Leaves are chained left to right for ordered
+// scans, and bulkLoad() builds the whole tree bottom-up from sorted input.
+class BTree
 {
 
 private:
-    map<string, int> data;
-    
+    static const int CAPACITY = 64;                  // keys per leaf, separators per inner node
+    static const int KEY_BYTES = 888;                // prefix and suffix bytes per node
+    static const int BULK_FILL = 56;                 // keys per node in bulkLoad(), room for later inserts
+    static const int BULK_BYTES = KEY_BYTES * 7 / 8;
+
+    // A key in two pieces, e.g. a node's prefix and one of its suffixes
+    struct KeyRef
+    {
+        string_view head;
+        string_view tail;
+
+        size_t size() const
+        {
+            return head.size() + tail.size();
+        }
+
+        char operator[](size_t i) const
+        {
+            return i < head.size() ? head[i] : tail[i - head.size()];
+        }
+
+        // Copy the bytes from position `from` on to out; returns how many
+        size_t copy(size_t from, char* out) const
+        {
+            size_t n = 0;
+
+            if (from < head.size())
+            {
+                n = head.copy(out, string_view::npos, from);
+                from = head.size();
+            }
+            return n + tail.copy(out + n, string_view::npos, from - head.size());
+        }
+
+        string text() const
+        {
+            string s(head);
+            s.append(tail);
+            return s;
+        }
+    };
+
+    // Keys of one node: the shared prefix is bytes[0, offsets[0]), suffix i
+    // is bytes[offsets[i], offsets[i + 1])
+    struct alignas(64) Node
+    {
+        uint16_t offsets[CAPACITY + 1];
+        uint16_t count;
+        bool leaf;
+        char bytes[KEY_BYTES];
+
+        explicit Node(bool isLeaf) : offsets{0}, count(0), leaf(isLeaf) {}
+
+        string_view prefix() const
+        {
+            return string_view(bytes, offsets[0]);
+        }
+
+        string_view suffix(int i) const
+        {
+            return string_view(bytes + offsets[i], offsets[i + 1] - offsets[i]);
+        }
+
+        KeyRef key(int i) const
+        {
+            return {prefix(), suffix(i)};
+        }
+
+        // Position of key relative to the whole node when it does not share
+        // the prefix: 0 (before every key) or count (after); -1 if it does
+        int outside(string_view key) const
+        {
+            int c = key.substr(0, offsets[0]).compare(prefix());
+
+            if (c < 0 || (c == 0 && key.size() < offsets[0]))
+            {
+                return 0;
+            }
+            return c > 0 ? count : -1;
+        }
+
+        // First i with key(i) >= key, or with key(i) > key when strict
+        int bound(string_view key, bool strict) const
+        {
+            int side = outside(key);
+
+            if (side != -1)
+            {
+                return side;
+            }
+
+            string_view rest = key.substr(offsets[0]);
+            int lo = 0, hi = count;
+
+            while (lo < hi)
+            {
+                int mid = (lo + hi) / 2;
+                int c = suffix(mid).compare(rest);
+
+                if (c < 0 || (strict && c == 0))
+                {
+                    lo = mid + 1;
+                }
+                else
+                {
+                    hi = mid;
+                }
+            }
+            return lo;
+        }
+
+        bool equals(int i, string_view key) const
+        {
+            return key.size() == offsets[0] + suffix(i).size() &&
+                   key.substr(0, offsets[0]) == prefix() &&
+                   key.substr(offsets[0]) == suffix(i);
+        }
+
+        // True if key can go in without a split or a shorter prefix
+        bool fitsInPlace(string_view key) const
+        {
+            return count < CAPACITY && outside(key) == -1 && offsets[count] + key.size() - offsets[0] <= KEY_BYTES;
+        }
+
+        // Add key at i; needs fitsInPlace(key)
+        void insert(int i, string_view key)
+        {
+            string_view rest = key.substr(offsets[0]);
+            memmove(bytes + offsets[i] + rest.size(), bytes + offsets[i], offsets[count] - offsets[i]);
+            memcpy(bytes + offsets[i], rest.data(), rest.size());
+
+            for (int j = count; j > i; j--)
+            {
+                offsets[j + 1] = offsets[j] + rest.size();
+            }
+            offsets[i + 1] = offsets[i] + rest.size();
+            count++;
+        }
+
+        void erase(int i)
+        {
+            uint16_t length = offsets[i + 1] - offsets[i];
+            memmove(bytes + offsets[i], bytes + offsets[i + 1], offsets[count] - offsets[i + 1]);
+
+            for (int j = i + 1; j < count; j++)
+            {
+                offsets[j] = offsets[j + 1] - length;
+            }
+            count--;
+        }
+
+        // Write n sorted keys with their longest common prefix; they must fit()
+        void encode(const KeyRef* keys, int n)
+        {
+            size_t common = n ? commonPrefix(keys[0], keys[n - 1]) : 0;
+            size_t at = common;
+
+            for (size_t j = 0; j < common; j++)
+            {
+                bytes[j] = keys[0][j];
+            }
+            offsets[0] = common;
+
+            for (int k = 0; k < n; k++)
+            {
+                at += keys[k].copy(common, bytes + at);
+                offsets[k + 1] = at;
+            }
+            count = n;
+        }
+    };
+
+    struct Leaf : Node
+    {
+        Leaf* next = nullptr;                // leaf chain
+        int values[CAPACITY];                // parallel to keys
+
+        Leaf() : Node(true) {}
+    };
+
+    struct Inner : Node
+    {
+        Node* children[CAPACITY + 1];        // count + 1
+
+        Inner() : Node(false) {}
+    };
+
+    // A run of keys that outgrew its node, with the separator above each
+    // new node to its right
+    typedef vector<pair<string, Node*>> Splits;
+
+    Node* root;
+    int count;
+    bool logging;
+
+    static size_t commonPrefix(const KeyRef& a, const KeyRef& b)
+    {
+        size_t n = min(a.size(), b.size()), common = 0;
+
+        while (common < n && a[common] == b[common])
+        {
+            common++;
+        }
+        return common;
+    }
+
+    // Bytes n sorted keys take in a node
+    static size_t encodedBytes(const KeyRef* keys, int n)
+    {
+        size_t total = 0;
+
+        for (int k = 0; k < n; k++)
+        {
+            total += keys[k].size();
+        }
+        return n ? total - (n - 1) * commonPrefix(keys[0], keys[n - 1]) : 0;
+    }
+
+    static bool fits(const KeyRef* keys, int n)
+    {
+        return n <= CAPACITY && encodedBytes(keys, n) <= KEY_BYTES;
+    }
+
+    // Shortest string s with a < s <= b (a < b)
+    static string separator(const KeyRef& a, const KeyRef& b)
+    {
+        string s = b.text();
+        s.resize(commonPrefix(a, b) + 1);
+        return s;
+    }
+
+    // Fill node with n keys and their values (leaf) or n + 1 children (inner)
+    static void place(Node* node, const KeyRef* keys, int n, const int* values, Node* const* children)
+    {
+        node->encode(keys, n);
+
+        if (node->leaf)
+        {
+            memcpy(((Leaf*)node)->values, values, n * sizeof(int));
+        }
+        else
+        {
+            memcpy(((Inner*)node)->children, children, (n + 1) * sizeof(Node*));
+        }
+    }
+
+    // Cut keys[begin, end) into runs that each fit a node, halving until they
+    // do; between two runs of an inner node one key moves up (gap 1). Any two
+    // keys fit (MAX_KEY), so a run that does not has at least three.
+    static void cut(const vector<KeyRef>& keys, int begin, int end, int gap, vector<pair<int, int>>& runs)
+    {
+        if (fits(keys.data() + begin, end - begin))
+        {
+            runs.push_back({begin, end});
+            return;
+        }
+
+        int mid = (begin + end) / 2;
+        cut(keys, begin, mid, gap, runs);
+        cut(keys, mid + gap, end, gap, runs);
+    }
+
+    // Lay sorted keys (with their values or children) out over node and, if
+    // they do not fit in one, over new nodes to its right, added to splits
+    static void layOut(Node* node, const vector<KeyRef>& keys, const int* values, Node* const* children,
+                       Splits& splits)
+    {
+        vector<pair<int, int>> runs;
+        cut(keys, 0, keys.size(), node->leaf ? 0 : 1, runs);
+
+        // New nodes first: keys may point into node's own bytes
+        for (size_t r = 1; r < runs.size(); r++)
+        {
+            int begin = runs[r].first;
+            int n = runs[r].second - begin;
+            Node* right = node->leaf ? (Node*)new Leaf() : (Node*)new Inner();
+
+            place(right, keys.data() + begin, n, values ? values + begin : nullptr, children ? children + begin : nullptr);
+            splits.push_back({node->leaf ? separator(keys[begin - 1], keys[begin]) : keys[begin - 1].text(), right});
+        }
+
+        if (node->leaf)
+        {
+            Leaf scratch;
+            place(&scratch, keys.data(), runs[0].second, values, nullptr);
+
+            Leaf* leaf = (Leaf*)node;
+            Leaf* after = leaf->next;
+            *leaf = scratch;
+
+            for (auto it = splits.end() - (runs.size() - 1); it != splits.end(); ++it)
+            {
+                leaf->next = (Leaf*)it->second;
+                leaf = leaf->next;
+            }
+            leaf->next = after;
+        }
+        else
+        {
+            Inner scratch;
+            place(&scratch, keys.data(), runs[0].second, nullptr, children);
+            *(Inner*)node = scratch;
+        }
+    }
+
+    // Insert below node; nodes that overflow split, and their new right
+    // siblings go into splits for the parent
+    void insertInto(Node* node, string_view key, int id, Splits& splits)
+    {
+        if (node->leaf)
+        {
+            Leaf* leaf = (Leaf*)node;
+            int i = leaf->bound(key, false);
+
+            if (i < leaf->count && leaf->equals(i, key))
+            {
+                leaf->values[i] = id;
+                return;
+            }
+
+            count++;
+
+            if (leaf->fitsInPlace(key))
+            {
+                memmove(leaf->values + i + 1, leaf->values + i, (leaf->count - i) * sizeof(int));
+                leaf->values[i] = id;
+                leaf->insert(i, key);
+                return;
+            }
+
+            // Lay the keys out again: a shorter prefix, or a split
+            vector<KeyRef> keys;
+            vector<int> values(leaf->values, leaf->values + leaf->count);
+
+            for (int j = 0; j < leaf->count; j++)
+            {
+                keys.push_back(leaf->key(j));
+            }
+            keys.insert(keys.begin() + i, KeyRef{key, {}});
+            values.insert(values.begin() + i, id);
+            layOut(leaf, keys, values.data(), nullptr, splits);
+            return;
+        }
+
+        Inner* inner = (Inner*)node;
+        int c = inner->bound(key, true);
+        Splits below;
+        insertInto(inner->children[c], key, id, below);
+
+        if (below.empty())
+        {
+            return;
+        }
+
+        if (below.size() == 1 && inner->fitsInPlace(below[0].first))
+        {
+            memmove(inner->children + c + 2, inner->children + c + 1, (inner->count - c) * sizeof(Node*));
+            inner->children[c + 1] = below[0].second;
+            inner->insert(c, below[0].first);
+            return;
+        }
+
+        vector<KeyRef> keys;
+        vector<Node*> children(inner->children, inner->children + inner->count + 1);
+
+        for (int j = 0; j < inner->count; j++)
+        {
+            keys.push_back(inner->key(j));
+        }
+        for (size_t u = 0; u < below.size(); u++)
+        {
+            keys.insert(keys.begin() + c + u, KeyRef{below[u].first, {}});
+            children.insert(children.begin() + c + 1 + u, below[u].second);
+        }
+        layOut(inner, keys, nullptr, children.data(), splits);
+    }
+
+    const Leaf* findLeaf(string_view key) const
+    {
+        const Node* node = root;
+
+        while (!node->leaf)
+        {
+            node = ((const Inner*)node)->children[node->bound(key, true)];
+        }
+        return (const Leaf*)node;
+    }
+
+    // End of the run of sorted keys from begin that bulkLoad() puts in one node
+    static size_t fill(const vector<KeyRef>& keys, size_t begin)
+    {
+        size_t end = begin + 1;
+        size_t total = keys[begin].size();
+        size_t common = total;
+
+        while (end < keys.size() && end - begin < BULK_FILL)
+        {
+            size_t shared = min(common, commonPrefix(keys[begin], keys[end]));
+            total += keys[end].size();
+
+            if (total - (end - begin) * shared > BULK_BYTES)
+            {
+                break;
+            }
+            common = shared;
+            end++;
+        }
+        return end;
+    }
+
+    static void destroy(Node* node)
+    {
+        if (node->leaf)
+        {
+            delete (Leaf*)node;
+            return;
+        }
+
+        const Inner* inner = (const Inner*)node;
+
+        for (int i = 0; i <= inner->count; i++)
+        {
+            destroy(inner->children[i]);
+        }
+        delete inner;
+    }
+
+    static void countNodes(const Node* node, size_t& nodes, size_t& bytes)
+    {
+        nodes++;
+
+        if (node->leaf)
+        {
+            bytes += sizeof(Leaf);
+            return;
+        }
+
+        bytes += sizeof(Inner);
+        const Inner* inner = (const Inner*)node;
+
+        for (int i = 0; i <= inner->count; i++)
+        {
+            countNodes(inner->children[i], nodes, bytes);
+        }
+    }
+
 public:
-    
-    void insert(const string& name, int id) 
+    // Longest name the tree takes; longer ones throw length_error
+    static const size_t MAX_KEY = KEY_BYTES / 2;
+
+    BTree() : root(new Leaf()), count(0), logging(true) {}
+    BTree(const BTree&) = delete;
+    BTree& operator=(const BTree&) = delete;
+
+    ~BTree()
+    {
+        destroy(root);
+    }
+
+    // Per-call messages are part of the CLI demo; bulk loads switch them off
+    void setLogging(bool enabled)
+    {
+        logging = enabled;
+    }
+
+    void insert(const string& name, int id)
+    {
+        if (name.size() > MAX_KEY)
+        {
+            throw length_error("BTree: name longer than " + to_string(MAX_KEY) + " bytes");
+        }
+
+        Splits splits;
+        insertInto(root, name, id, splits);
+
+        // The root split: a new root above the pieces (which may split too)
+        while (!splits.empty())
+        {
+            vector<KeyRef> keys;
+            vector<Node*> children{root};
+
+            for (auto& [up, node] : splits)
+            {
+                keys.push_back({up, {}});
+                children.push_back(node);
+            }
+
+            Inner* top = new Inner();
+            Splits above;
+            layOut(top, keys, nullptr, children.data(), above);
+            root = top;
+            splits.swap(above);
+        }
+
+        if (logging)
+        {
+            cout << "[B-Tree] Inserted: " << name << " -> ID: " << id << endl;
+        }
+    }
+
+    // Replace the contents with (name, id) pairs. Input sorted by name is
+    // used as is; anything else is sorted first. For duplicate names the
+    // last pair wins, as with repeated insert().
+    void bulkLoad(vector<pair<string, int>> entries)
+    {
+        for (auto& e : entries)
+        {
+            if (e.first.size() > MAX_KEY)
+            {
+                throw length_error("BTree: name longer than " + to_string(MAX_KEY) + " bytes");
+            }
+        }
+
+        auto byName = [](const pair<string, int>& a, const pair<string, int>& b)
+        {
+            return a.first < b.first;
+        };
+
+        if (!is_sorted(entries.begin(), entries.end(), byName))
+        {
+            stable_sort(entries.begin(), entries.end(), byName);
+        }
+
+        vector<pair<string, int>> unique;
+        unique.reserve(entries.size());
+
+        for (auto& e : entries)
+        {
+            if (!unique.empty() && unique.back().first == e.first)
+            {
+                unique.back().second = e.second;
+            }
+            else
+            {
+                unique.push_back(move(e));
+            }
+        }
+
+        destroy(root);
+        count = unique.size();
+
+        vector<KeyRef> keys;
+        vector<int> ids;
+        keys.reserve(unique.size());
+        ids.reserve(unique.size());
+
+        for (auto& [name, id] : unique)
+        {
+            keys.push_back({name, {}});
+            ids.push_back(id);
+        }
+
+        // Leaves, with their first and last key for the separators above
+        struct Built
+        {
+            Node* node;
+            KeyRef first;
+            KeyRef last;
+        };
+
+        vector<Built> level;
+        Leaf* previous = nullptr;
+
+        for (size_t begin = 0; begin < keys.size();)
+        {
+            size_t end = fill(keys, begin);
+            Leaf* leaf = new Leaf();
+            place(leaf, keys.data() + begin, end - begin, ids.data() + begin, nullptr);
+
+            if (previous)
+            {
+                previous->next = leaf;
+            }
+            previous = leaf;
+            level.push_back({leaf, keys[begin], keys[end - 1]});
+            begin = end;
+        }
+
+        while (level.size() > 1)
+        {
+            // separators[i] tells level[i] and level[i + 1] apart
+            vector<string> separators;
+            vector<KeyRef> separatorKeys;
+            vector<Node*> children;
+
+            for (size_t i = 0; i < level.size(); i++)
+            {
+                if (i > 0)
+                {
+                    separators.push_back(separator(level[i - 1].last, level[i].first));
+                }
+                children.push_back(level[i].node);
+            }
+            for (const string& s : separators)
+            {
+                separatorKeys.push_back({s, {}});
+            }
+
+            vector<Built> above;
+
+            for (size_t begin = 0; begin < level.size();)
+            {
+                // Children [begin, end) with the separators between them
+                size_t end = begin + 1 < level.size() ? fill(separatorKeys, begin) + 1 : begin + 1;
+                Inner* inner = new Inner();
+                place(inner, separatorKeys.data() + begin, end - begin - 1, nullptr, children.data() + begin);
+                above.push_back({inner, level[begin].first, level[end - 1].last});
+                begin = end;
+            }
+
+            level.swap(above);
+        }
+
+        root = level.empty() ? new Leaf() : level[0].node;
+    }
+
+    // Remove a name. Nodes are not merged afterwards: names are removed
+    // rarely, and a sparse leaf only costs a little space.
+    bool remove(const string& name)
     {
-        data[name] = id;
-        cout << "[B-Tree] Inserted: " << name << " -> ID: " << id << endl;
+        Leaf* leaf = const_cast<Leaf*>(findLeaf(name));
+        int i = leaf->bound(name, false);
+
+        if (i == leaf->count || !leaf->equals(i, name))
+        {
+            return false;
+        }
+
+        memmove(leaf->values + i, leaf->values + i + 1, (leaf->count - i - 1) * sizeof(int));
+        leaf->erase(i);
+        count--;
+        return true;
     }
-    
-    int search(const string& name) 
+
+    int search(const string& name)
     {
-        auto it = data.find(name);
-    
-        if (it != data.end()) 
+        const Leaf* leaf = findLeaf(name);
+        int i = leaf->bound(name, false);
+
+        if (i < leaf->count && leaf->equals(i, name))
+        {
+            if (logging)
+            {
+                cout << "[B-Tree] Found: " << name << " -> ID: " << leaf->values[i] << endl;
+            }
+            return leaf->values[i];
+        }
+
+        if (logging)
         {
-            cout << "[B-Tree] Found: " << name << " -> ID: " << it->second << endl;
-            return it->second;
+            cout << "[B-Tree] Not found: " << name << endl;
         }
-        
-        cout << "[B-Tree] Not found: " << name << endl;
         return -1;
     }
-    
-    vector<string> searchByPrefix(const string& prefix) 
+
+    // Ordered scan from the first name >= start; visit(name, id) returns
+    // false to stop
+    template <typename Visit>
+    void scanFrom(string_view start, const Visit& visit) const
     {
-        vector<string> results;
-    
-        for (auto& [name, id] : data) 
+        const Leaf* leaf = findLeaf(start);
+        int i = leaf->bound(start, false);
+        string name;
+
+        for (; leaf; leaf = leaf->next, i = 0)
         {
-            if (name.substr(0, prefix.length()) == prefix) 
+            for (; i < leaf->count; i++)
             {
-                results.push_back(name);
+                name.assign(leaf->prefix()).append(leaf->suffix(i));
+
+                if (!visit(name, leaf->values[i]))
+                {
+                    return;
+                }
             }
         }
+    }
+
+    // Names starting with prefix, in order. Seeks to the first name >= prefix
+    // and stops at the first one past the prefix range.
+    vector<string> searchByPrefix(const string& prefix)
+    {
+        vector<string> results;
+
+        for (auto& [name, id] : searchByPrefix(prefix, numeric_limits<int>::max(), "").matches)
+        {
+            results.push_back(move(name));
+        }
         return results;
     }
-    
-    void display() 
+
+    struct PrefixPage
+    {
+        vector<pair<string, int>> matches;
+        string nextCursor;       // pass back to continue; empty on the last page
+    };
+
+    // One page of at most limit matches. cursor is the nextCursor of the
+    // previous page (the last name it returned), or empty for the first page.
+    PrefixPage searchByPrefix(const string& prefix, int limit, const string& cursor) const
+    {
+        PrefixPage page;
+        const string& start = cursor > prefix ? cursor : prefix;
+
+        if (limit <= 0)
+        {
+            return page;
+        }
+
+        scanFrom(start, [&](const string& name, int id)
+        {
+            if (name.compare(0, prefix.size(), prefix) != 0)
+            {
+                return false;
+            }
+
+            if (!cursor.empty() && name == cursor)
+            {
+                return true;
+            }
+
+            if ((int)page.matches.size() == limit)
+            {
+                page.nextCursor = page.matches.back().first;
+                return false;
+            }
+
+            page.matches.push_back({name, id});
+            return true;
+        });
+        return page;
+    }
+
+    void display()
     {
         cout << "\n========== B-TREE CONTENTS ==========" << endl;
-        cout << "Total Junctions: " << data.size() << endl;
+        cout << "Total Junctions: " << count << endl;
         cout << "-------------------------------------" << endl;
-    
-        for (auto& [name, id] : data) 
+
+        scanFrom("", [](const string& name, int id)
         {
             cout << "  " << name << " -> ID: " << id << endl;
-        }
+            return true;
+        });
         cout << "====================================\n" << endl;
     }
-    
-    int size() const 
+
+    // Heap footprint of the tree (its nodes)
+    size_t memoryBytes() const
+    {
+        size_t nodes = 0, bytes = 0;
+        countNodes(root, nodes, bytes);
+        return bytes;
+    }
+
+    int size() const
     {
-        return data.size();
+        return count;
     }
 };
 
-#endif
\ No newline at end of file
+#endif
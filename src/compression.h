@@ -0,0 +1,340 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+using namespace std;
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+
+// Content codings for responses: which one a client takes (Accept-Encoding,
+// with q-values) and the compressors for it, one-shot or as a stream.
+//
+// gzip needs zlib (build with -DHAVE_ZLIB -lz), br needs the Brotli encoder
+// (-DHAVE_BROTLI -lbrotlienc); a coding not built in is never chosen. Not
+// CPPHTTPLIB_ZLIB_SUPPORT / CPPHTTPLIB_BROTLI_SUPPORT: those make httplib
+// compress every JSON body again on every request, whatever its size.
+enum class Encoding
+{
+    IDENTITY,
+    GZIP,
+    BROTLI
+};
+
+class Compression
+{
+
+private:
+    // q-value of a coding in an Accept-Encoding header; -1 if not listed
+    static double quality(string_view header, string_view coding)
+    {
+        double wildcard = -1;
+        size_t pos = 0;
+
+        while (pos < header.size())
+        {
+            size_t end = header.find(',', pos);
+
+            if (end == string_view::npos)
+            {
+                end = header.size();
+            }
+
+            string_view item = header.substr(pos, end - pos);
+            size_t semicolon = item.find(';');
+            string_view token = trim(item.substr(0, semicolon));
+            double q = 1;
+
+            if (semicolon != string_view::npos)
+            {
+                string_view parameter = trim(item.substr(semicolon + 1));
+
+                if (parameter.size() > 2 && (parameter[0] == 'q' || parameter[0] == 'Q') && parameter[1] == '=')
+                {
+                    q = strtod(string(parameter.substr(2)).c_str(), nullptr);
+                }
+            }
+
+            if (equalsIgnoringCase(token, coding))
+            {
+                return q;
+            }
+            if (token == "*")
+            {
+                wildcard = q;
+            }
+            pos = end + 1;
+        }
+        return wildcard;
+    }
+
+    static string_view trim(string_view s)
+    {
+        while (!s.empty() && (s.front() == ' ' || s.front() == '\t'))
+        {
+            s.remove_prefix(1);
+        }
+        while (!s.empty() && (s.back() == ' ' || s.back() == '\t'))
+        {
+            s.remove_suffix(1);
+        }
+        return s;
+    }
+
+    static bool equalsIgnoringCase(string_view a, string_view b)
+    {
+        if (a.size() != b.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    // Bodies smaller than this go out as they are: a packet or two either
+    // way, and compressing them costs more time than it saves
+    static const size_t MIN_BYTES = 1024;
+
+    // Brotli quality for bodies compressed once and kept. 11 packs the
+    // junction list a fifth smaller but takes seconds per rebuild; per-request
+    // bodies use 5 (gzip: level 9 kept, 6 per request).
+    static const int BROTLI_BEST = 9;
+
+    static bool available(Encoding encoding)
+    {
+        switch (encoding)
+        {
+            case Encoding::IDENTITY:
+                return true;
+            case Encoding::GZIP:
+#ifdef HAVE_ZLIB
+                return true;
+#else
+                return false;
+#endif
+            case Encoding::BROTLI:
+#ifdef HAVE_BROTLI
+                return true;
+#else
+                return false;
+#endif
+        }
+        return false;
+    }
+
+    // Content-Encoding header value; empty for identity
+    static const char* name(Encoding encoding)
+    {
+        switch (encoding)
+        {
+            case Encoding::GZIP:
+                return "gzip";
+            case Encoding::BROTLI:
+                return "br";
+            default:
+                return "";
+        }
+    }
+
+    // The coding to answer an Accept-Encoding header with: the highest
+    // q-value among those built in, br before gzip on a tie, identity if
+    // neither is acceptable. No header means identity.
+    static Encoding negotiate(string_view acceptEncoding)
+    {
+        Encoding chosen = Encoding::IDENTITY;
+        double best = 0;
+
+        for (Encoding encoding : {Encoding::BROTLI, Encoding::GZIP})
+        {
+            double q = available(encoding) ? quality(acceptEncoding, name(encoding)) : -1;
+
+            if (q > best)
+            {
+                chosen = encoding;
+                best = q;
+            }
+        }
+        return chosen;
+    }
+
+    // data in the given coding, at the best level for bodies that are kept;
+    // empty if the coding is not built in or fails
+    static string compress(string_view data, Encoding encoding, bool best = false)
+    {
+        string out;
+        (void)data;    // unused when no coding is built in
+        (void)best;
+
+        if (encoding == Encoding::GZIP)
+        {
+#ifdef HAVE_ZLIB
+            z_stream stream{};
+
+            // windowBits 15 + 16: gzip header and trailer rather than zlib's
+            if (deflateInit2(&stream, best ? Z_BEST_COMPRESSION : 6, Z_DEFLATED, 15 + 16, 8,
+                             Z_DEFAULT_STRATEGY) != Z_OK)
+            {
+                return out;
+            }
+
+            out.resize(deflateBound(&stream, data.size()));
+            stream.next_in = (Bytef*)data.data();
+            stream.avail_in = data.size();
+            stream.next_out = (Bytef*)&out[0];
+            stream.avail_out = out.size();
+
+            int status = deflate(&stream, Z_FINISH);
+            out.resize(status == Z_STREAM_END ? stream.total_out : 0);
+            deflateEnd(&stream);
+#endif
+        }
+        else if (encoding == Encoding::BROTLI)
+        {
+#ifdef HAVE_BROTLI
+            size_t size = BrotliEncoderMaxCompressedSize(data.size());
+            out.resize(size ? size : data.size() + 1024);
+
+            if (!BrotliEncoderCompress(best ? BROTLI_BEST : 5, BROTLI_DEFAULT_WINDOW,
+                                       BROTLI_MODE_TEXT, data.size(), (const uint8_t*)data.data(), &size,
+                                       (uint8_t*)&out[0]))
+            {
+                size = 0;
+            }
+            out.resize(size);
+#endif
+        }
+        return out;
+    }
+
+    // A response compressed piece by piece as it is produced (a chunked
+    // stream): each write() returns bytes the client can decode at once,
+    // finish() the end of the stream.
+    class Stream
+    {
+
+    private:
+        Encoding encoding;
+#ifdef HAVE_ZLIB
+        z_stream zlib{};
+#endif
+#ifdef HAVE_BROTLI
+        BrotliEncoderState* brotli = nullptr;
+#endif
+
+        string run(string_view data, bool last)
+        {
+            string out;
+            [[maybe_unused]] char buffer[16 * 1024];
+            (void)last;
+
+#ifdef HAVE_ZLIB
+            if (encoding == Encoding::GZIP)
+            {
+                zlib.next_in = (Bytef*)data.data();
+                zlib.avail_in = data.size();
+
+                do
+                {
+                    zlib.next_out = (Bytef*)buffer;
+                    zlib.avail_out = sizeof(buffer);
+                    deflate(&zlib, last ? Z_FINISH : Z_SYNC_FLUSH);
+                    out.append(buffer, sizeof(buffer) - zlib.avail_out);
+                } while (zlib.avail_out == 0);
+            }
+#endif
+#ifdef HAVE_BROTLI
+            if (encoding == Encoding::BROTLI)
+            {
+                size_t availableIn = data.size();
+                const uint8_t* nextIn = (const uint8_t*)data.data();
+                BrotliEncoderOperation op = last ? BROTLI_OPERATION_FINISH : BROTLI_OPERATION_FLUSH;
+
+                do
+                {
+                    size_t availableOut = sizeof(buffer);
+                    uint8_t* nextOut = (uint8_t*)buffer;
+
+                    if (!BrotliEncoderCompressStream(brotli, op, &availableIn, &nextIn, &availableOut, &nextOut,
+                                                     nullptr))
+                    {
+                        break;
+                    }
+                    out.append(buffer, sizeof(buffer) - availableOut);
+                } while (availableIn > 0 || BrotliEncoderHasMoreOutput(brotli));
+            }
+#endif
+            if (encoding == Encoding::IDENTITY)
+            {
+                out.assign(data);
+            }
+            return out;
+        }
+
+    public:
+        // encoding must be available()
+        explicit Stream(Encoding e) : encoding(e)
+        {
+#ifdef HAVE_ZLIB
+            if (encoding == Encoding::GZIP)
+            {
+                deflateInit2(&zlib, 6, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+            }
+#endif
+#ifdef HAVE_BROTLI
+            if (encoding == Encoding::BROTLI)
+            {
+                brotli = BrotliEncoderCreateInstance(nullptr, nullptr, nullptr);
+                BrotliEncoderSetParameter(brotli, BROTLI_PARAM_QUALITY, 5);
+                BrotliEncoderSetParameter(brotli, BROTLI_PARAM_MODE, BROTLI_MODE_TEXT);
+            }
+#endif
+        }
+
+        ~Stream()
+        {
+#ifdef HAVE_ZLIB
+            if (encoding == Encoding::GZIP)
+            {
+                deflateEnd(&zlib);
+            }
+#endif
+#ifdef HAVE_BROTLI
+            if (brotli)
+            {
+                BrotliEncoderDestroyInstance(brotli);
+            }
+#endif
+        }
+
+        Stream(const Stream&) = delete;
+        Stream& operator=(const Stream&) = delete;
+
+        string write(string_view data)
+        {
+            return run(data, false);
+        }
+
+        string finish()
+        {
+            return run(string_view(), true);
+        }
+    };
+};
+
+#endif
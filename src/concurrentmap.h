@@ -0,0 +1,356 @@
+#ifndef CONCURRENTMAP_H
+#define CONCURRENTMAP_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "hashtable.h"
+#include "stringpool.h"
+using namespace std;
+
+// Junction record handed out by ConcurrentJunctionMap. It is immutable and
+// reference counted, so it stays valid however the map changes afterwards.
+// The name is a view into the map's StringPool, valid as long as the pool.
+struct JunctionRecord
+{
+    int id;
+    string_view name;
+    double lat;
+    double lng;
+};
+
+typedef shared_ptr<const JunctionRecord> JunctionHandle;
+
+// Epoch-based reclamation for read-mostly structures (an RCU flavour).
+//
+// A reader announces the global epoch in its own slot while it looks at
+// shared data and clears it afterwards; that is two plain stores, no lock.
+// A writer that unlinks an object tags it with the epoch at that moment and
+// frees it only once every reader that might still see it has left.
+// A thread should only be inside one manager's Guard at a time.
+class EpochManager
+{
+
+private:
+    static const int MAX_READERS = 256;
+
+    struct alignas(64) Slot
+    {
+        atomic<uint64_t> epoch{0};     // 0 = not reading
+        atomic<bool> claimed{false};
+    };
+
+    struct Retired
+    {
+        uint64_t epoch;
+        function<void()> release;
+    };
+
+    Slot slots[MAX_READERS];
+    atomic<uint64_t> globalEpoch{1};
+    mutex retireLock;
+    vector<Retired> retired;
+
+    // This thread's slot, claimed on first use and given back at thread exit
+    Slot* mySlot()
+    {
+        struct Owner
+        {
+            Slot* slot = nullptr;
+
+            ~Owner()
+            {
+                if (slot)
+                {
+                    slot->claimed.store(false, memory_order_release);
+                }
+            }
+        };
+
+        thread_local Owner owner;
+        thread_local EpochManager* ownerOf = nullptr;
+
+        if (ownerOf == this && owner.slot)
+        {
+            return owner.slot;
+        }
+
+        for (int i = 0; i < MAX_READERS; i++)
+        {
+            bool expected = false;
+
+            if (slots[i].claimed.compare_exchange_strong(expected, true))
+            {
+                if (owner.slot)
+                {
+                    owner.slot->claimed.store(false, memory_order_release);
+                }
+                owner.slot = &slots[i];
+                ownerOf = this;
+                return owner.slot;
+            }
+        }
+        return nullptr;    // more threads than slots: callers fall back to the writer lock
+    }
+
+    uint64_t oldestActive() const
+    {
+        uint64_t oldest = UINT64_MAX;
+
+        for (const Slot& slot : slots)
+        {
+            uint64_t e = slot.epoch.load(memory_order_seq_cst);
+
+            if (e != 0)
+            {
+                oldest = min(oldest, e);
+            }
+        }
+        return oldest;
+    }
+
+public:
+
+    // RAII read-side critical section
+    class Guard
+    {
+
+    private:
+        Slot* slot;
+
+    public:
+        explicit Guard(EpochManager& manager) : slot(manager.mySlot())
+        {
+            if (slot)
+            {
+                slot->epoch.store(manager.globalEpoch.load(memory_order_seq_cst), memory_order_seq_cst);
+            }
+        }
+
+        ~Guard()
+        {
+            if (slot)
+            {
+                slot->epoch.store(0, memory_order_release);
+            }
+        }
+
+        bool pinned() const
+        {
+            return slot != nullptr;
+        }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+
+    // Free `release` once no reader can still hold what it refers to
+    void retire(function<void()> release)
+    {
+        uint64_t epoch = globalEpoch.fetch_add(1, memory_order_seq_cst);
+        vector<Retired> ready;
+        {
+            lock_guard<mutex> guard(retireLock);
+            retired.push_back({epoch, move(release)});
+
+            uint64_t oldest = oldestActive();
+            auto keep = partition(retired.begin(), retired.end(), [&](const Retired& r)
+            {
+                return r.epoch >= oldest;
+            });
+
+            move(keep, retired.end(), back_inserter(ready));
+            retired.erase(keep, retired.end());
+        }
+
+        for (auto& r : ready)
+        {
+            r.release();
+        }
+    }
+
+    ~EpochManager()
+    {
+        for (auto& r : retired)
+        {
+            r.release();
+        }
+    }
+};
+
+// Junction ID -> record map for metadata that changes while the server is
+// serving. The table is split into stripes; each stripe is an immutable,
+// ID-sorted snapshot behind an atomic pointer.
+//
+// find() pins the epoch, binary-searches the current snapshot and copies out
+// a JunctionHandle: no locks, and a concurrent writer never blocks it.
+// Writers take the stripe's mutex, copy the snapshot with their change, swap
+// the pointer and retire the old snapshot through the EpochManager. A write
+// costs O(stripe size), so the stripe count should keep stripes small.
+// Names are interned in a StringPool shared with the other name holders;
+// a renamed junction's old name stays in the pool.
+class ConcurrentJunctionMap
+{
+
+private:
+    typedef vector<pair<int, JunctionHandle>> Snapshot;
+
+    struct alignas(64) Stripe
+    {
+        atomic<const Snapshot*> current{nullptr};
+        mutex writer;
+    };
+
+    StringPool& pool;
+    vector<Stripe> stripes;
+    size_t stripeMask;
+    atomic<int> elementCount{0};
+    mutable EpochManager epochs;
+
+    Stripe& stripeOf(int id)
+    {
+        return stripes[JunctionIdHash()(id) & stripeMask];
+    }
+
+    const Stripe& stripeOf(int id) const
+    {
+        return stripes[JunctionIdHash()(id) & stripeMask];
+    }
+
+    static JunctionHandle lookup(const Snapshot* snapshot, int id)
+    {
+        if (!snapshot)
+        {
+            return nullptr;
+        }
+
+        auto it = lower_bound(snapshot->begin(), snapshot->end(), id,
+            [](const pair<int, JunctionHandle>& entry, int key)
+            {
+                return entry.first < key;
+            });
+
+        return it != snapshot->end() && it->first == id ? it->second : nullptr;
+    }
+
+    // Replace a stripe's snapshot; caller holds stripe.writer
+    void publish(Stripe& stripe, Snapshot* next)
+    {
+        const Snapshot* old = stripe.current.exchange(next, memory_order_seq_cst);
+
+        if (old)
+        {
+            epochs.retire([old] { delete old; });
+        }
+    }
+
+public:
+    // Names are interned in `names`; stripeCount is rounded up to a power of two
+    explicit ConcurrentJunctionMap(StringPool& names, size_t stripeCount = 1024) : pool(names)
+    {
+        size_t n = 1;
+
+        while (n < stripeCount)
+        {
+            n *= 2;
+        }
+
+        stripes = vector<Stripe>(n);
+        stripeMask = n - 1;
+    }
+
+    ~ConcurrentJunctionMap()
+    {
+        for (auto& stripe : stripes)
+        {
+            delete stripe.current.load();
+        }
+    }
+
+    // Insert or replace; readers see either the old or the new record
+    void insert(const Junction& junction)
+    {
+        Stripe& stripe = stripeOf(junction.id);
+        string_view name = pool.view(pool.intern(junction.name));
+        JunctionHandle record = make_shared<const JunctionRecord>(
+            JunctionRecord{junction.id, name, junction.lat, junction.lng});
+
+        lock_guard<mutex> guard(stripe.writer);
+        const Snapshot* current = stripe.current.load(memory_order_acquire);
+        Snapshot* next = current ? new Snapshot(*current) : new Snapshot();
+
+        auto it = lower_bound(next->begin(), next->end(), junction.id,
+            [](const pair<int, JunctionHandle>& entry, int key)
+            {
+                return entry.first < key;
+            });
+
+        if (it != next->end() && it->first == junction.id)
+        {
+            it->second = record;
+        }
+        else
+        {
+            next->insert(it, {junction.id, record});
+            elementCount.fetch_add(1, memory_order_relaxed);
+        }
+
+        publish(stripe, next);
+    }
+
+    bool erase(int id)
+    {
+        Stripe& stripe = stripeOf(id);
+        lock_guard<mutex> guard(stripe.writer);
+        const Snapshot* current = stripe.current.load(memory_order_acquire);
+
+        if (!lookup(current, id))
+        {
+            return false;
+        }
+
+        Snapshot* next = new Snapshot();
+        next->reserve(current->size() - 1);
+
+        for (const auto& entry : *current)
+        {
+            if (entry.first != id)
+            {
+                next->push_back(entry);
+            }
+        }
+
+        elementCount.fetch_sub(1, memory_order_relaxed);
+        publish(stripe, next);
+        return true;
+    }
+
+    // Current record, or null
+    JunctionHandle find(int id) const
+    {
+        const Stripe& stripe = stripeOf(id);
+        EpochManager::Guard guard(epochs);
+
+        if (!guard.pinned())
+        {
+            // Out of reader slots: keep the snapshot alive by blocking writers instead
+            lock_guard<mutex> writer(const_cast<mutex&>(stripe.writer));
+            return lookup(stripe.current.load(memory_order_acquire), id);
+        }
+
+        return lookup(stripe.current.load(memory_order_seq_cst), id);
+    }
+
+    int size() const
+    {
+        return elementCount.load(memory_order_relaxed);
+    }
+};
+
+#endif
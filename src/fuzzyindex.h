@@ -0,0 +1,699 @@
+#ifndef FUZZYINDEX_H
+#define FUZZYINDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "postings.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+using namespace std;
+
+// Typo-tolerant name search: a trigram inverted index finds candidates,
+// bit-parallel Levenshtein (Myers / Hyyrö) checks and ranks them.
+//
+// Names are folded (ASCII lowercased, punctuation to single spaces) and
+// padded as "  name " before cutting trigrams, so a name of n bytes has
+// n + 1 of them. For k allowed edits the padded query is cut into k + 1
+// pieces; a match leaves at least one piece intact, so it is in the
+// intersection of that piece's trigram lists. The union of those
+// intersections (count-filtered when large) is verified with Myers'
+// algorithm, a few word operations per name byte.
+//
+// Posting lists are delta coded in blocks of 128 doc IDs, bit-packed with
+// one width per block in four interleaved 32-bit lanes (SIMD-BP128 layout),
+// so a block decodes with 128-bit shifts and masks and checking candidates
+// against it is a 4-wide compare. The last block of a list stays raw until
+// it fills up, so names can be added at any time; removal is a tombstone.
+class FuzzyIndex
+{
+
+private:
+    static const int BLOCK = 128;
+    static const int MAX_QUERY = 64;          // Myers works on one machine word
+    static constexpr size_t FEW = 64;         // candidates left to Myers alone
+    static constexpr size_t PIECE_LISTS = 3;  // lists intersected per query piece
+    static constexpr size_t MANY = 1024;      // union size that pays for a count filter
+    static constexpr size_t SKIP_RATIO = 8;   // list / candidates length to skip rather than merge
+
+    struct Postings
+    {
+        vector<uint32_t> lastDoc;        // per block, for skipping
+        vector<uint32_t> offset;         // per block, into words
+        vector<uint8_t> width;           // per block, bits per delta
+        vector<uint32_t> words;
+        vector<uint32_t> tail;           // raw, not yet a full block
+        uint32_t count = 0;
+    };
+
+    unordered_map<uint32_t, Postings> grams;
+    vector<uint32_t> nameEnd;            // doc -> end of its folded name in text
+    string text;
+    vector<uint32_t> values;
+    vector<bool> removed;
+    int liveCount = 0;
+
+    static uint32_t gramKey(const char* p)
+    {
+        return (uint32_t)(uint8_t)p[0] << 16 | (uint32_t)(uint8_t)p[1] << 8 | (uint8_t)p[2];
+    }
+
+    // Trigrams of a folded name in order, repeats included
+    static vector<uint32_t> gramSequence(const string& folded)
+    {
+        string padded = "  " + folded + " ";
+        vector<uint32_t> keys;
+
+        for (size_t i = 0; i + 3 <= padded.size(); i++)
+        {
+            keys.push_back(gramKey(padded.data() + i));
+        }
+        return keys;
+    }
+
+    // Distinct trigrams of a folded name
+    static vector<uint32_t> trigramsOf(const string& folded)
+    {
+        vector<uint32_t> keys = gramSequence(folded);
+        sort(keys.begin(), keys.end());
+        keys.erase(unique(keys.begin(), keys.end()), keys.end());
+        return keys;
+    }
+
+    // Pack 128 ascending doc IDs following `base` into the list's words
+    static void packBlock(Postings& list, const uint32_t* docs, uint32_t base)
+    {
+        uint32_t deltas[BLOCK];
+        uint32_t all = 0;
+
+        for (int i = 0; i < BLOCK; i++)
+        {
+            deltas[i] = docs[i] - (i ? docs[i - 1] : base);
+            all |= deltas[i];
+        }
+
+        int b = 32 - __builtin_clz(all | 1);
+        size_t start = list.words.size();
+        list.words.resize(start + 4 * b, 0);
+
+        // Value j sits in lane j % 4, row j / 4 of that lane's bit stream
+        for (int j = 0; j < BLOCK; j++)
+        {
+            size_t bit = (size_t)(j / 4) * b;
+            uint32_t* lane = &list.words[start + j % 4];
+            lane[4 * (bit >> 5)] |= deltas[j] << (bit & 31);
+
+            if ((bit & 31) + b > 32)
+            {
+                lane[4 * ((bit >> 5) + 1)] |= deltas[j] >> (32 - (bit & 31));
+            }
+        }
+
+        list.lastDoc.push_back(docs[BLOCK - 1]);
+        list.offset.push_back(start);
+        list.width.push_back(b);
+    }
+
+#ifdef __SSE2__
+    // One block of B-bit deltas; B is a constant so every shift is fixed
+    // and the rows unroll
+    template <int B>
+    static void unpack(const uint32_t* in, uint32_t base, uint32_t* out)
+    {
+        const __m128i mask = _mm_set1_epi32(B == 32 ? -1 : (int)((1u << B) - 1));
+        __m128i prev = _mm_set1_epi32((int)base);
+
+#pragma GCC unroll 32
+        for (int row = 0; row < BLOCK / 4; row++)
+        {
+            const int bit = row * B;
+            const int shift = bit & 31;
+            const __m128i* word = (const __m128i*)(in + 4 * (bit >> 5));
+            __m128i v = _mm_srli_epi32(_mm_loadu_si128(word), shift);
+
+            if (shift + B > 32)
+            {
+                v = _mm_or_si128(v, _mm_slli_epi32(_mm_loadu_si128(word + 1), 32 - shift));
+            }
+            v = _mm_and_si128(v, mask);
+
+            // Prefix sum of four deltas, carried on from the previous row
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+            v = _mm_add_epi32(v, prev);
+            _mm_storeu_si128((__m128i*)(out + 4 * row), v);
+            prev = _mm_shuffle_epi32(v, 0xff);
+        }
+    }
+
+    template <int... B>
+    static void unpackWidth(int b, const uint32_t* in, uint32_t base, uint32_t* out,
+                            integer_sequence<int, B...>)
+    {
+        typedef void (*Unpack)(const uint32_t*, uint32_t, uint32_t*);
+        static const Unpack table[] = {unpack<B + 1>...};
+        table[b - 1](in, base, out);
+    }
+#endif
+
+    // Doc IDs of block `block` into out[0..127]
+    static void decodeBlock(const Postings& list, size_t block, uint32_t* out)
+    {
+        const uint32_t* in = list.words.data() + list.offset[block];
+        int b = list.width[block];
+        uint32_t base = block ? list.lastDoc[block - 1] : 0;
+
+#ifdef __SSE2__
+        unpackWidth(b, in, base, out, make_integer_sequence<int, 32>());
+#else
+        uint32_t mask = b == 32 ? ~0u : (1u << b) - 1;
+        uint32_t doc = base;
+
+        for (int j = 0; j < BLOCK; j++)
+        {
+            size_t bit = (size_t)(j / 4) * b;
+            const uint32_t* lane = in + j % 4;
+            uint32_t v = lane[4 * (bit >> 5)] >> (bit & 31);
+
+            if ((bit & 31) + b > 32)
+            {
+                v |= lane[4 * ((bit >> 5) + 1)] << (32 - (bit & 31));
+            }
+            doc += v & mask;
+            out[j] = doc;
+        }
+#endif
+    }
+
+    static void decodeAll(const Postings& list, vector<uint32_t>& out)
+    {
+        out.resize(list.count);
+
+        for (size_t block = 0; block < list.lastDoc.size(); block++)
+        {
+            decodeBlock(list, block, out.data() + block * BLOCK);
+        }
+        copy(list.tail.begin(), list.tail.end(), out.begin() + list.lastDoc.size() * BLOCK);
+    }
+
+    // hits[i]++ for every a[i] that is also in b (both sorted). Four values
+    // of a are compared with four of b at once, all 16 pairs.
+    static void countSorted(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint8_t* hits)
+    {
+        size_t i = 0, j = 0;
+
+#ifdef __SSE2__
+        while (i + 4 <= na && j + 4 <= nb)
+        {
+            __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+            __m128i vb = _mm_loadu_si128((const __m128i*)(b + j));
+            __m128i eq = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi32(va, vb), _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x39))),
+                _mm_or_si128(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x4e)),
+                             _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, 0x93))));
+
+            for (int mask = _mm_movemask_ps(_mm_castsi128_ps(eq)); mask; mask &= mask - 1)
+            {
+                hits[i + __builtin_ctz(mask)]++;
+            }
+
+            uint32_t lastA = a[i + 3], lastB = b[j + 3];
+            i += lastA <= lastB ? 4 : 0;
+            j += lastB <= lastA ? 4 : 0;
+        }
+#endif
+        while (i < na && j < nb)
+        {
+            if (a[i] < b[j])
+            {
+                i++;
+            }
+            else if (b[j] < a[i])
+            {
+                j++;
+            }
+            else
+            {
+                hits[i++]++;
+                j++;
+            }
+        }
+    }
+
+    // hits[i]++ for every candidate in `list`. A list much longer than the
+    // candidates is skipped through block by block (galloping over the
+    // block ends, a 4-wide scan inside a block); otherwise it is decoded
+    // whole and merged.
+    static void countHits(const Postings& list, const vector<uint32_t>& candidates, vector<uint8_t>& hits,
+                          vector<uint32_t>& scratch)
+    {
+        if (list.count <= SKIP_RATIO * candidates.size())
+        {
+            decodeAll(list, scratch);
+            countSorted(candidates.data(), candidates.size(), scratch.data(), scratch.size(), hits.data());
+            return;
+        }
+
+        uint32_t block[BLOCK];
+        size_t decoded = SIZE_MAX;
+        size_t current = 0;
+        int pos = 0;
+
+        for (size_t i = 0; i < candidates.size(); i++)
+        {
+            uint32_t doc = candidates[i];
+
+            current = gallop(list.lastDoc, current, doc);
+
+            if (current < list.lastDoc.size())
+            {
+                if (decoded != current)
+                {
+                    decodeBlock(list, current, block);
+                    decoded = current;
+                    pos = 0;
+                }
+                pos = lowerBound(block, pos, BLOCK, doc);
+                hits[i] += pos < BLOCK && block[pos] == doc;
+            }
+            else
+            {
+                hits[i] += binary_search(list.tail.begin(), list.tail.end(), doc);
+            }
+        }
+    }
+
+    // Drop the candidates with fewer than `minimum` hits
+    static void prune(vector<uint32_t>& candidates, vector<uint8_t>& hits, int minimum)
+    {
+        size_t kept = 0;
+
+        for (size_t i = 0; i < candidates.size(); i++)
+        {
+            if (hits[i] >= minimum)
+            {
+                candidates[kept] = candidates[i];
+                hits[kept] = hits[i];
+                kept++;
+            }
+        }
+
+        candidates.resize(kept);
+        hits.resize(kept);
+    }
+
+    // Count filter: each edit breaks at most 3 trigrams, so a match holds at
+    // least `needed` of the query's distinct trigram lists. Lists are counted
+    // shortest first, the ones not yet counted assumed present, until few
+    // candidates are left.
+    static void countFilter(vector<const Postings*> lists, int needed, vector<uint32_t>& candidates,
+                            vector<uint32_t>& scratch)
+    {
+        sort(lists.begin(), lists.end(), [](const Postings* x, const Postings* y)
+        {
+            return x->count < y->count;
+        });
+
+        vector<uint8_t> hits(candidates.size(), 0);
+
+        for (size_t i = 0; i < lists.size() && candidates.size() > FEW; i++)
+        {
+            countHits(*lists[i], candidates, hits, scratch);
+            prune(candidates, hits, needed - (int)(lists.size() - i - 1));
+        }
+    }
+
+    string_view nameOf(uint32_t doc) const
+    {
+        uint32_t start = doc ? nameEnd[doc - 1] : 0;
+        return string_view(text.data() + start, nameEnd[doc] - start);
+    }
+
+public:
+
+    struct Match
+    {
+        uint32_t value;
+        int distance;
+    };
+
+    // Lowercase ASCII, other punctuation and whitespace become single
+    // spaces; bytes >= 0x80 (UTF-8) are kept as they are
+    static string fold(const string& name)
+    {
+        string out;
+
+        for (unsigned char c : name)
+        {
+            if (isalnum(c) || c >= 0x80)
+            {
+                out += (char)tolower(c);
+            }
+            else if (!out.empty() && out.back() != ' ')
+            {
+                out += ' ';
+            }
+        }
+
+        if (!out.empty() && out.back() == ' ')
+        {
+            out.pop_back();
+        }
+        return out;
+    }
+
+    // Edits allowed for a query: none up to 2 bytes, one up to 5, then two
+    static int editBudget(const string& query)
+    {
+        size_t length = fold(query).size();
+        return length <= 2 ? 0 : length <= 5 ? 1 : 2;
+    }
+
+    // Folded query prepared for distance(): a bit mask of its positions per
+    // byte value. At most 64 bytes.
+    struct Pattern
+    {
+        uint64_t peq[256] = {0};
+        int length;
+
+        explicit Pattern(string_view pattern) : length(pattern.size())
+        {
+            for (int i = 0; i < length; i++)
+            {
+                peq[(uint8_t)pattern[i]] |= 1ULL << i;
+            }
+        }
+    };
+
+    // Edit distance between a pattern and a folded string if it is at most
+    // maxEdits, otherwise maxEdits + 1
+    static int distance(const Pattern& pattern, string_view text, int maxEdits)
+    {
+        int m = pattern.length;
+        int n = text.size();
+
+        if (abs(m - n) > maxEdits)
+        {
+            return maxEdits + 1;
+        }
+        if (m == 0)
+        {
+            return n;
+        }
+
+        uint64_t pv = m == 64 ? ~0ULL : (1ULL << m) - 1;
+        uint64_t mv = 0;
+        uint64_t last = 1ULL << (m - 1);
+        int score = m;
+
+        for (int j = 0; j < n; j++)
+        {
+            uint64_t eq = pattern.peq[(uint8_t)text[j]];
+            uint64_t xv = eq | mv;
+            uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+            uint64_t ph = mv | ~(xh | pv);
+            uint64_t mh = pv & xh;
+
+            if (ph & last)
+            {
+                score++;
+            }
+            else if (mh & last)
+            {
+                score--;
+            }
+
+            // Row 0 grows by one per text byte (global, not substring, distance)
+            ph = (ph << 1) | 1;
+            mh <<= 1;
+            pv = mh | ~(xv | ph);
+            mv = ph & xv;
+
+            // Each remaining byte can lower the score by at most one
+            if (score - (n - j - 1) > maxEdits)
+            {
+                return maxEdits + 1;
+            }
+        }
+
+        return min(score, maxEdits + 1);
+    }
+
+    static int distance(string_view pattern, string_view text, int maxEdits)
+    {
+        return distance(Pattern(pattern), text, maxEdits);
+    }
+
+    void reserve(size_t names, size_t textBytes)
+    {
+        nameEnd.reserve(names);
+        values.reserve(names);
+        removed.reserve(names);
+        text.reserve(textBytes);
+    }
+
+    void add(const string& name, uint32_t value)
+    {
+        string folded = fold(name);
+        uint32_t doc = values.size();
+
+        text += folded;
+        nameEnd.push_back(text.size());
+        values.push_back(value);
+        removed.push_back(false);
+        liveCount++;
+
+        for (uint32_t key : trigramsOf(folded))
+        {
+            Postings& list = grams[key];
+            list.tail.push_back(doc);
+            list.count++;
+
+            if (list.tail.size() == BLOCK)
+            {
+                packBlock(list, list.tail.data(), list.lastDoc.empty() ? 0 : list.lastDoc.back());
+                list.tail.clear();
+            }
+        }
+    }
+
+    // Drop `value` under `name`; false if it was not there
+    bool remove(const string& name, uint32_t value)
+    {
+        string folded = fold(name);
+        bool found = false;
+
+        for (uint32_t doc : candidates(folded, 0))
+        {
+            if (!removed[doc] && values[doc] == value && nameOf(doc) == folded)
+            {
+                removed[doc] = true;
+                liveCount--;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    // Docs that may be within maxEdits of a folded query. The padded query
+    // is cut into maxEdits + 1 pieces of at least 3 bytes; a match leaves
+    // one piece untouched and so holds every trigram of it. Each piece is
+    // the intersection of its shortest trigram lists, and pieces are placed
+    // to keep the shortest list of each piece short.
+    vector<uint32_t> candidates(const string& folded, int maxEdits) const
+    {
+        vector<uint32_t> sequence = gramSequence(folded);
+        int length = sequence.size() + 2;      // padded bytes
+        int pieces = maxEdits + 1;
+
+        if (length < 3 * pieces)
+        {
+            return {};
+        }
+
+        // List per trigram position, null if the index has never seen it
+        vector<const Postings*> at(sequence.size());
+
+        for (size_t p = 0; p < sequence.size(); p++)
+        {
+            auto it = grams.find(sequence[p]);
+            at[p] = it == grams.end() ? nullptr : &it->second;
+        }
+
+        // best[j][b] = cheapest split of bytes [0, b) into j pieces, where a
+        // piece [a, b) holds trigrams a .. b - 3 and costs its shortest list
+        const uint64_t NONE = UINT64_MAX;
+        vector<vector<uint64_t>> best(pieces + 1, vector<uint64_t>(length + 1, NONE));
+        vector<vector<int>> cut(pieces + 1, vector<int>(length + 1, 0));
+        best[0][0] = 0;
+
+        for (int j = 1; j <= pieces; j++)
+        {
+            for (int b = 3 * j; b <= length; b++)
+            {
+                uint64_t shortest = NONE;
+
+                for (int a = b - 3; a >= 3 * (j - 1); a--)
+                {
+                    shortest = min<uint64_t>(shortest, at[a] ? at[a]->count : 0);
+
+                    if (best[j - 1][a] != NONE && best[j - 1][a] + shortest < best[j][b])
+                    {
+                        best[j][b] = best[j - 1][a] + shortest;
+                        cut[j][b] = a;
+                    }
+                }
+            }
+        }
+
+        vector<uint32_t> result, scratch;
+        vector<uint8_t> hits;
+
+        for (int j = pieces, b = length; j > 0; b = cut[j][b], j--)
+        {
+            vector<const Postings*> lists;
+            bool missing = false;
+
+            for (int p = cut[j][b]; p + 3 <= b; p++)
+            {
+                missing |= !at[p];
+                lists.push_back(at[p]);
+            }
+
+            if (missing)
+            {
+                continue;
+            }
+
+            sort(lists.begin(), lists.end());
+            lists.erase(unique(lists.begin(), lists.end()), lists.end());
+            sort(lists.begin(), lists.end(), [](const Postings* x, const Postings* y)
+            {
+                return x->count < y->count;
+            });
+
+            // The longer lists of a piece mostly repeat the same word, and
+            // once few candidates are left Myers drops strays more cheaply
+            vector<uint32_t> piece;
+            decodeAll(*lists[0], piece);
+
+            for (size_t i = 1; i < min(lists.size(), PIECE_LISTS) && piece.size() > FEW; i++)
+            {
+                hits.assign(piece.size(), 0);
+                countHits(*lists[i], piece, hits, scratch);
+                prune(piece, hits, 1);
+            }
+
+            vector<uint32_t> merged;
+            set_union(result.begin(), result.end(), piece.begin(), piece.end(), back_inserter(merged));
+            result.swap(merged);
+        }
+
+        // Short queries make short, common pieces; their union is narrowed
+        // down by trigram count before verification
+        if (result.size() > MANY)
+        {
+            vector<const Postings*> lists;
+
+            for (const Postings* list : at)
+            {
+                if (list)
+                {
+                    lists.push_back(list);
+                }
+            }
+
+            sort(lists.begin(), lists.end());
+            lists.erase(unique(lists.begin(), lists.end()), lists.end());
+
+            vector<uint32_t> keys = sequence;
+            sort(keys.begin(), keys.end());
+            int distinct = unique(keys.begin(), keys.end()) - keys.begin();
+
+            countFilter(lists, distinct - 3 * maxEdits, result, scratch);
+        }
+
+        return result;
+    }
+
+    // Names within maxEdits of the query (clamped to what the trigram filter
+    // can guarantee), closest first, then in insertion order. Queries are
+    // cut to 64 bytes after folding.
+    vector<Match> search(const string& query, int maxEdits, size_t limit) const
+    {
+        string folded = fold(query).substr(0, MAX_QUERY);
+        maxEdits = max(0, min(maxEdits, (int)folded.size() / 3));
+
+        Pattern pattern(folded);
+        vector<Match> matches;
+
+        vector<uint32_t> docs = candidates(folded, maxEdits);
+
+        for (size_t i = 0; i < docs.size(); i++)
+        {
+            uint32_t doc = docs[i];
+
+            // Candidates are scattered over the names: fetch ahead, the end
+            // offsets first and the text once its offset has arrived
+            if (i + 16 < docs.size())
+            {
+                __builtin_prefetch(&nameEnd[docs[i + 16]]);
+            }
+            if (i + 8 < docs.size())
+            {
+                __builtin_prefetch(text.data() + nameEnd[docs[i + 8]]);
+            }
+
+            if (removed[doc])
+            {
+                continue;
+            }
+
+            int d = distance(pattern, nameOf(doc), maxEdits);
+
+            if (d <= maxEdits)
+            {
+                matches.push_back({values[doc], d});
+            }
+        }
+
+        stable_sort(matches.begin(), matches.end(), [](const Match& a, const Match& b)
+        {
+            return a.distance < b.distance;
+        });
+
+        if (matches.size() > limit)
+        {
+            matches.resize(limit);
+        }
+        return matches;
+    }
+
+    int size() const
+    {
+        return liveCount;
+    }
+
+    size_t memoryBytes() const
+    {
+        size_t bytes = text.capacity() + nameEnd.capacity() * 4 + values.capacity() * 4 +
+                       removed.capacity() / 8 + grams.bucket_count() * sizeof(void*);
+
+        for (auto& [key, list] : grams)
+        {
+            bytes += sizeof(key) + sizeof(list) + 2 * sizeof(void*) +
+                     list.lastDoc.capacity() * 4 + list.offset.capacity() * 4 +
+                     list.width.capacity() + list.words.capacity() * 4 + list.tail.capacity() * 4;
+        }
+        return bytes;
+    }
+};
+
+#endif
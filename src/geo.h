@@ -0,0 +1,44 @@
+#ifndef GEO_H
+#define GEO_H
+
+#include <cmath>
+using namespace std;
+
+const double EARTH_RADIUS_KM = 6371.0;
+const double DEG_TO_RAD = 3.14159265358979323846 / 180.0;
+
+// Great-circle distance between two lat/lng points, in km
+inline double haversineKm(double lat1, double lng1, double lat2, double lng2)
+{
+    double dLat = (lat2 - lat1) * DEG_TO_RAD;
+    double dLng = (lng2 - lng1) * DEG_TO_RAD;
+    double a = sin(dLat / 2) * sin(dLat / 2)
+             + cos(lat1 * DEG_TO_RAD) * cos(lat2 * DEG_TO_RAD) * sin(dLng / 2) * sin(dLng / 2);
+
+    return 2 * EARTH_RADIUS_KM * asin(min(1.0, sqrt(a)));
+}
+
+// Equirectangular projection to km around a reference latitude. Within a
+// city this is accurate to a fraction of a percent, and unlike haversine it
+// is a plain Euclidean metric, which heuristics and spatial indexes rely on.
+struct LocalProjection
+{
+    double kmPerDegLat;
+    double kmPerDegLng;
+
+    LocalProjection(double referenceLat = 0.0)
+        : kmPerDegLat(EARTH_RADIUS_KM * DEG_TO_RAD),
+          kmPerDegLng(EARTH_RADIUS_KM * DEG_TO_RAD * cos(referenceLat * DEG_TO_RAD)) {}
+
+    double x(double lng) const
+    {
+        return lng * kmPerDegLng;
+    }
+
+    double y(double lat) const
+    {
+        return lat * kmPerDegLat;
+    }
+};
+
+#endif
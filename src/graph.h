@@ -3,10 +3,14 @@
 
 #include <iostream>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <queue>
 #include <limits>
 #include <algorithm>
+#include <functional>
+#include <atomic>
+#include <mutex>
 using namespace std;
 
 class Graph 
@@ -16,7 +20,7 @@ public:
 
     struct Edge 
     {
-        int to;
+        int to;               // dense node index (see junctionId())
         double distance;
         double baseTime;      
         double currentTime;   
@@ -26,136 +30,678 @@ public:
             : to(t), distance(d), baseTime(tm), currentTime(tm) {}
     };
     
+    // Per-thread scratch space for shortestPath(). Arrays are indexed by
+    // dense node index and reused across queries; a round stamp marks which
+    // entries belong to the current search so nothing is cleared per query.
+    struct SearchWorkspace
+    {
+        vector<double> dist;
+        vector<int> parent;
+        vector<unsigned> stamp;
+        vector<pair<double, int>> heap;
+        unsigned round = 0;
+
+        void reset(int nodes)
+        {
+            if ((int)dist.size() < nodes)
+            {
+                dist.resize(nodes);
+                parent.resize(nodes);
+                stamp.resize(nodes, 0);
+            }
+
+            if (++round == 0)
+            {
+                fill(stamp.begin(), stamp.end(), 0);
+                round = 1;
+            }
+
+            heap.clear();
+        }
+
+        double distance(int v) const
+        {
+            return stamp[v] == round ? dist[v] : numeric_limits<double>::infinity();
+        }
+
+        void settle(int v, double d, int p)
+        {
+            stamp[v] = round;
+            dist[v] = d;
+            parent[v] = p;
+        }
+    };
+
+    // Answer of the component index for a (source, destination) pair
+    enum class Reach { Yes, No, Unknown };
+
 private:
 
-    map<int, vector<Edge>> adjList;
+    vector<vector<Edge>> adjList;      // by dense node index
+    unordered_map<int, int> indexOf;   // junction ID -> dense index
+    vector<int> junctionIds;           // dense index -> junction ID
+    vector<double> latitudes;          // by dense index, 0 until setLocation()
+    vector<double> longitudes;
     int edgeCount;
+    int congestedEdges;                // directed edges with currentTime != baseTime
+    bool logging;
+
+    // Bumped on every change so precomputed engines can tell when they are stale
+    unsigned long structureVersion;
+    unsigned long trafficVersion;
+    unsigned long closureVersion;
+
+    // Component labels over open edges, rebuilt lazily after roads are added
+    // or closed. weakLabel: undirected components. strongLabel: Tarjan SCC
+    // ids, which come out in reverse topological order of the condensation.
+    mutable mutex componentLock;
+    mutable atomic<unsigned long> componentVersion;
+    mutable vector<int> weakLabel;
+    mutable vector<int> strongLabel;
+
+    // Told about every directed edge whose currentTime changed (dense indices);
+    // -1, -1 means every edge may have changed
+    function<void(int, int)> trafficListener;
+
+    void notifyTraffic(int u, int v)
+    {
+        if (trafficListener)
+        {
+            trafficListener(u, v);
+        }
+    }
+
+    static bool isOpen(const Edge& edge)
+    {
+        return edge.currentTime != numeric_limits<double>::infinity();
+    }
+
+    void labelComponents() const
+    {
+        int n = nodeCount();
+        weakLabel.assign(n, -1);
+        strongLabel.assign(n, -1);
+
+        // Undirected components: an open edge in either direction links its ends
+        vector<vector<int>> undirected(n);
+
+        for (int u = 0; u < n; u++)
+        {
+            for (const auto& edge : adjList[u])
+            {
+                if (isOpen(edge))
+                {
+                    undirected[u].push_back(edge.to);
+                    undirected[edge.to].push_back(u);
+                }
+            }
+        }
+
+        int weakCount = 0;
+        vector<int> stack;
+
+        for (int start = 0; start < n; start++)
+        {
+            if (weakLabel[start] != -1)
+            {
+                continue;
+            }
+
+            weakLabel[start] = weakCount;
+            stack.push_back(start);
+
+            while (!stack.empty())
+            {
+                int u = stack.back();
+                stack.pop_back();
+
+                for (int v : undirected[u])
+                {
+                    if (weakLabel[v] == -1)
+                    {
+                        weakLabel[v] = weakCount;
+                        stack.push_back(v);
+                    }
+                }
+            }
+            weakCount++;
+        }
+
+        // Iterative Tarjan over open directed edges
+        vector<int> order(n, -1), low(n, 0), next(n, 0), sccStack, callStack;
+        vector<char> onStack(n, 0);
+        int counter = 0, strongCount = 0;
+
+        for (int start = 0; start < n; start++)
+        {
+            if (order[start] != -1)
+            {
+                continue;
+            }
+
+            callStack.push_back(start);
+
+            while (!callStack.empty())
+            {
+                int u = callStack.back();
+
+                if (order[u] == -1)
+                {
+                    order[u] = low[u] = counter++;
+                    sccStack.push_back(u);
+                    onStack[u] = 1;
+                }
+
+                bool descended = false;
+
+                while (next[u] < (int)adjList[u].size())
+                {
+                    const Edge& edge = adjList[u][next[u]++];
+
+                    if (!isOpen(edge))
+                    {
+                        continue;
+                    }
+
+                    if (order[edge.to] == -1)
+                    {
+                        callStack.push_back(edge.to);
+                        descended = true;
+                        break;
+                    }
+
+                    if (onStack[edge.to])
+                    {
+                        low[u] = min(low[u], order[edge.to]);
+                    }
+                }
+
+                if (descended)
+                {
+                    continue;
+                }
+
+                callStack.pop_back();
+
+                if (!callStack.empty())
+                {
+                    int parent = callStack.back();
+                    low[parent] = min(low[parent], low[u]);
+                }
+
+                if (low[u] == order[u])
+                {
+                    int v;
+
+                    do
+                    {
+                        v = sccStack.back();
+                        sccStack.pop_back();
+                        onStack[v] = 0;
+                        strongLabel[v] = strongCount;
+                    } while (v != u);
+
+                    strongCount++;
+                }
+            }
+        }
+    }
+
+    int internNode(int id)
+    {
+        auto it = indexOf.find(id);
+
+        if (it != indexOf.end())
+        {
+            return it->second;
+        }
+
+        int index = junctionIds.size();
+        indexOf[id] = index;
+        junctionIds.push_back(id);
+        latitudes.push_back(0.0);
+        longitudes.push_back(0.0);
+        adjList.emplace_back();
+        structureVersion++;
+        return index;
+    }
+
+    void setTime(int from, int to, double trafficMultiplier)
+    {
+        for (auto& edge : adjList[from])
+        {
+            if (edge.to == to && isOpen(edge))
+            {
+                bool wasCongested = edge.currentTime != edge.baseTime;
+
+                // baseTime se calculation
+                edge.currentTime = edge.baseTime * trafficMultiplier;
+                congestedEdges += (edge.currentTime != edge.baseTime) - wasCongested;
+                break;
+            }
+        }
+    }
     
 public:
 
-    Graph() : edgeCount(0) {}
+    Graph()
+        : edgeCount(0), congestedEdges(0), logging(true),
+          structureVersion(0), trafficVersion(0), closureVersion(0), componentVersion(~0UL) {}
+
+    // Console output per edge/query is useful for the CLI demo but
+    // serializes bulk loads and batch routing on stdout.
+    void setLogging(bool enabled)
+    {
+        logging = enabled;
+    }
+
+    // Caches of traffic-dependent output (e.g. map tiles) subscribe here
+    void setTrafficListener(function<void(int, int)> listener)
+    {
+        trafficListener = listener;
+    }
     
     void addEdge(int from, int to, double distance, double time) 
     {
-        adjList[from].push_back(Edge(to, distance, time));
-        adjList[to].push_back(Edge(from, distance, time));
+        int u = internNode(from);
+        int v = internNode(to);
+
+        adjList[u].push_back(Edge(v, distance, time));
+        adjList[v].push_back(Edge(u, distance, time));
         edgeCount++;
+        structureVersion++;
         
-        cout << "[Graph] Added edge: " << from << " <-> " << to 
-             << " (" << distance << "km, " << time << "min)" << endl;
+        if (logging)
+        {
+            cout << "[Graph] Added edge: " << from << " <-> " << to
+                 << " (" << distance << "km, " << time << "min)" << endl;
+        }
     }
     
     void updateTraffic(int from, int to, double trafficMultiplier) 
     {
-        // From -> To direction
-        for (auto& edge : adjList[from]) 
+        int u = findIndex(from);
+        int v = findIndex(to);
+
+        if (u != -1 && v != -1)
+        {
+            // From -> To aur To -> From (bidirectional)
+            setTime(u, v, trafficMultiplier);
+            setTime(v, u, trafficMultiplier);
+            notifyTraffic(u, v);
+            notifyTraffic(v, u);
+        }
+
+        trafficVersion++;
+
+        if (logging)
+        {
+            cout << "[Graph] Updated traffic: " << from << " <-> " << to
+                 << " (multiplier: " << trafficMultiplier << "x)" << endl;
+        }
+    }
+
+    // Close (or reopen) the from -> to direction of a road. A closed edge has
+    // infinite currentTime, so every search skips it; traffic updates leave it
+    // closed until it is reopened at its base time.
+    void setRoadClosed(int from, int to, bool closed)
+    {
+        int u = findIndex(from);
+        int v = findIndex(to);
+
+        if (u == -1 || v == -1)
+        {
+            return;
+        }
+
+        for (auto& edge : adjList[u])
         {
-            if (edge.to == to) 
+            if (edge.to == v && isOpen(edge) == closed)
             {
-                // baseTime se calculation
-                edge.currentTime = edge.baseTime * trafficMultiplier;
-                break;
+                bool wasCongested = edge.currentTime != edge.baseTime;
+                edge.currentTime = closed ? numeric_limits<double>::infinity() : edge.baseTime;
+                congestedEdges += (edge.currentTime != edge.baseTime) - wasCongested;
             }
         }
         
-        // To -> From direction (bidirectional)
-        for (auto& edge : adjList[to]) 
+        notifyTraffic(u, v);
+        trafficVersion++;
+        closureVersion++;
+
+        if (logging)
+        {
+            cout << "[Graph] Road " << from << " -> " << to
+                 << (closed ? " closed" : " reopened") << endl;
+        }
+    }
+
+    // O(1) reachability check against the component labels. Different weak
+    // components, or an SCC that comes earlier in reverse topological order,
+    // can never reach the destination; the same SCC always can.
+    Reach reachability(int sourceIndex, int destIndex) const
+    {
+        unsigned long version = structureVersion * 1000003UL + closureVersion;
+
+        if (componentVersion.load(memory_order_acquire) != version)
         {
-            if (edge.to == from) 
+            lock_guard<mutex> guard(componentLock);
+
+            if (componentVersion.load(memory_order_relaxed) != version)
             {
-                // bestTime se calculation
-                edge.currentTime = edge.baseTime * trafficMultiplier;
-                break;
+                labelComponents();
+                componentVersion.store(version, memory_order_release);
             }
         }
         
-        cout << "[Graph] Updated traffic: " << from << " <-> " << to 
-             << " (multiplier: " << trafficMultiplier << "x)" << endl;
+        if (weakLabel[sourceIndex] != weakLabel[destIndex]
+            || strongLabel[sourceIndex] < strongLabel[destIndex])
+        {
+            return Reach::No;
+        }
+
+        return strongLabel[sourceIndex] == strongLabel[destIndex] ? Reach::Yes : Reach::Unknown;
     }
-    
-    // DIJKSTRA ME currentTime usage ⭐⭐⭐
-    pair<vector<int>, double> dijkstra(int source, int dest) 
+
+    // Both junctions exist and the component index rules out any path
+    bool isUnreachable(int source, int dest) const
     {
-        cout << "\n[Dijkstra] Finding shortest path: " 
-             << source << " -> " << dest << endl;
-        
-        map<int, double> dist;
-        map<int, int> parent;
-        priority_queue<pair<double, int>, 
-                       vector<pair<double, int>>, 
-                       greater<pair<double, int>>> pq;
-        
-        for (auto& [node, edges] : adjList) 
+        int s = findIndex(source);
+        int t = findIndex(dest);
+        return s != -1 && t != -1 && reachability(s, t) == Reach::No;
+    }
+
+    // Junction coordinates, used by partitioning and geometric heuristics
+    void setLocation(int id, double lat, double lng)
+    {
+        int index = internNode(id);
+        latitudes[index] = lat;
+        longitudes[index] = lng;
+    }
+
+    double latitude(int index) const
+    {
+        return latitudes[index];
+    }
+
+    double longitude(int index) const
+    {
+        return longitudes[index];
+    }
+
+    unsigned long getStructureVersion() const
+    {
+        return structureVersion;
+    }
+
+    unsigned long getTrafficVersion() const
+    {
+        return trafficVersion;
+    }
+
+    // True while any edge runs at something other than its base time
+    bool hasLiveTraffic() const
+    {
+        return congestedEdges > 0;
+    }
+
+    int findIndex(int id) const
+    {
+        auto it = indexOf.find(id);
+        return it == indexOf.end() ? -1 : it->second;
+    }
+
+    int junctionId(int index) const
+    {
+        return junctionIds[index];
+    }
+
+    int nodeCount() const
+    {
+        return junctionIds.size();
+    }
+
+    const vector<Edge>& edges(int index) const
+    {
+        return adjList[index];
+    }
+
+    // Quiet, read-only Dijkstra on currentTime. Safe to call from several
+    // threads at once as long as each one passes its own workspace.
+    pair<vector<int>, double> shortestPath(int source, int dest, SearchWorkspace& ws) const
+    {
+        return shortestPath(source, dest, ws, [](int, int) { return true; });
+    }
+
+    // Same search, relaxing only the edges for which allow(node, k) is true,
+    // where k is the position of the edge in edges(node). Goal-directed
+    // engines use this to prune with their precomputed data.
+    template <typename EdgeFilter>
+    pair<vector<int>, double> shortestPath(int source, int dest, SearchWorkspace& ws, const EdgeFilter& allow) const
+    {
+        return shortestPath(source, dest, ws, allow, [](const Edge& edge) { return edge.currentTime; });
+    }
+
+    // Same search with each edge costing weight(edge) instead, e.g. its
+    // baseTime. ws.parent holds the route (dense indices) afterwards.
+    template <typename EdgeFilter, typename EdgeWeight>
+    pair<vector<int>, double> shortestPath(int source, int dest, SearchWorkspace& ws, const EdgeFilter& allow,
+                                           const EdgeWeight& weight) const
+    {
+        if (source == dest)
         {
-            dist[node] = numeric_limits<double>::infinity();
+            return {vector<int>{source}, 0};
         }
-        
-        dist[source] = 0;
-        pq.push({0, source});
-        
-        while (!pq.empty()) 
+
+        int s = findIndex(source);
+        int t = findIndex(dest);
+
+        if (s == -1 || t == -1 || reachability(s, t) == Reach::No)
+        {
+            return {vector<int>(), -1};
+        }
+
+        auto later = greater<pair<double, int>>();
+
+        ws.reset(nodeCount());
+        ws.settle(s, 0, -1);
+        ws.heap.push_back({0, s});
+
+        while (!ws.heap.empty())
         {
-            auto [currentDist, u] = pq.top();
-            pq.pop();
-            
-            if (u == dest) 
+            pop_heap(ws.heap.begin(), ws.heap.end(), later);
+            auto [currentDist, u] = ws.heap.back();
+            ws.heap.pop_back();
+
+            if (u == t)
             {
                 break;
             }
-            
-            if (currentDist > dist[u]) 
+
+            if (currentDist > ws.distance(u))
             {
                 continue;
             }
-            
-            for (auto& edge : adjList[u]) 
+
+            const auto& out = adjList[u];
+
+            for (int k = 0; k < (int)out.size(); k++)
             {
-                int v = edge.to;
-                double weight = edge.currentTime;
-                
-                if (dist[u] + weight < dist[v]) 
+                if (!allow(u, k))
+                {
+                    continue;
+                }
+
+                const Edge& edge = out[k];
+                double candidate = currentDist + weight(edge);
+
+                if (candidate < ws.distance(edge.to))
                 {
-                    dist[v] = dist[u] + weight;
-                    parent[v] = u;
-                    pq.push({dist[v], v});
+                    ws.settle(edge.to, candidate, u);
+                    ws.heap.push_back({candidate, edge.to});
+                    push_heap(ws.heap.begin(), ws.heap.end(), later);
                 }
             }
         }
-        
-        if (dist[dest] == numeric_limits<double>::infinity()) 
+
+        double total = ws.distance(t);
+
+        if (total == numeric_limits<double>::infinity())
         {
-            cout << "[Dijkstra] No path found!" << endl;
             return {vector<int>(), -1};
         }
-        
+
         vector<int> path;
-        int current = dest;
-        
-        while (current != source) 
+
+        for (int current = t; current != -1; current = ws.parent[current])
         {
-            path.push_back(current);
-            current = parent[current];
+            path.push_back(junctionIds[current]);
         }
-        
-        path.push_back(source);
+
+        reverse(path.begin(), path.end());
+        return {path, total};
+    }
+
+    // Current time of the fastest open u -> v edge (dense indices), or infinity
+    double edgeTime(int u, int v) const
+    {
+        double best = numeric_limits<double>::infinity();
+
+        for (const auto& edge : adjList[u])
+        {
+            if (edge.to == v)
+            {
+                best = min(best, edge.currentTime);
+            }
+        }
+        return best;
+    }
+
+    // Dijkstra between sets of seeded nodes (dense index, cost): sources start
+    // with their cost, targets add theirs on arrival. This routes between
+    // points in the middle of roads, whose "virtual node" is represented by
+    // the two road ends. The returned junction IDs run from the chosen source
+    // node to the chosen target node.
+    pair<vector<int>, double> shortestPathBetween(const vector<pair<int, double>>& sources,
+                                                  const vector<pair<int, double>>& targets,
+                                                  SearchWorkspace& ws) const
+    {
+        const double INF = numeric_limits<double>::infinity();
+        bool possible = false;
+
+        for (auto [s, sc] : sources)
+        {
+            for (auto [t, tc] : targets)
+            {
+                possible = possible || (sc < INF && tc < INF && reachability(s, t) != Reach::No);
+            }
+        }
+
+        if (!possible)
+        {
+            return {vector<int>(), -1};
+        }
+
+        auto later = greater<pair<double, int>>();
+
+        ws.reset(nodeCount());
+
+        for (auto [s, cost] : sources)
+        {
+            if (cost < ws.distance(s))
+            {
+                ws.settle(s, cost, -1);
+                ws.heap.push_back({cost, s});
+                push_heap(ws.heap.begin(), ws.heap.end(), later);
+            }
+        }
+
+        double best = INF;
+        int goal = -1;
+
+        while (!ws.heap.empty() && ws.heap.front().first < best)
+        {
+            pop_heap(ws.heap.begin(), ws.heap.end(), later);
+            auto [currentDist, u] = ws.heap.back();
+            ws.heap.pop_back();
+
+            if (currentDist > ws.distance(u))
+            {
+                continue;
+            }
+
+            for (auto [t, cost] : targets)
+            {
+                if (t == u && currentDist + cost < best)
+                {
+                    best = currentDist + cost;
+                    goal = u;
+                }
+            }
+
+            for (const auto& edge : adjList[u])
+            {
+                double candidate = currentDist + edge.currentTime;
+
+                if (candidate < ws.distance(edge.to))
+                {
+                    ws.settle(edge.to, candidate, u);
+                    ws.heap.push_back({candidate, edge.to});
+                    push_heap(ws.heap.begin(), ws.heap.end(), later);
+                }
+            }
+        }
+
+        if (goal == -1)
+        {
+            return {vector<int>(), -1};
+        }
+
+        vector<int> path;
+
+        for (int current = goal; current != -1; current = ws.parent[current])
+        {
+            path.push_back(junctionIds[current]);
+        }
+
         reverse(path.begin(), path.end());
+        return {path, best};
+    }
+    
+    // DIJKSTRA ME currentTime usage ⭐⭐⭐
+    pair<vector<int>, double> dijkstra(int source, int dest) const
+    {
+        cout << "\n[Dijkstra] Finding shortest path: " 
+             << source << " -> " << dest << endl;
+        
+        SearchWorkspace ws;
+        auto result = shortestPath(source, dest, ws);
         
-        cout << "[Dijkstra] Path found! Total time: " 
-             << dist[dest] << " minutes" << endl;
+        if (result.first.empty())
+        {
+            cout << "[Dijkstra] No path found!" << endl;
+            return result;
+        }
         
-        return {path, dist[dest]};
+        cout << "[Dijkstra] Path found! Total time: "
+             << result.second << " minutes" << endl;
+        
+        return result;
     }
     
     // Reset all traffic to normal
     void resetAllTraffic()
     {
-        for (auto& [junction, edges] : adjList) 
+        for (auto& edges : adjList)
         {
             for (auto& edge : edges) 
             {
                 edge.currentTime = edge.baseTime; // Reset to original
             }
         }
+        congestedEdges = 0;
+        trafficVersion++;
+        closureVersion++;
+        notifyTraffic(-1, -1);
         cout << "[Graph] All traffic reset to normal" << endl;
     }
     
@@ -166,13 +712,15 @@ public:
         cout << "Total Edges: " << edgeCount << endl;
         cout << "-----------------------------------" << endl;
         
-        for (auto& [junction, edges] : adjList) 
+        map<int, int> byId(indexOf.begin(), indexOf.end());
+
+        for (auto& [junction, index] : byId)
         {
             cout << "Junction " << junction << " connects to: ";
         
-            for (auto& edge : edges) 
+            for (auto& edge : adjList[index])
             {
-                cout << "[" << edge.to << ": " << edge.distance 
+                cout << "[" << junctionIds[edge.to] << ": " << edge.distance
                      << "km, base:" << edge.baseTime 
                      << "min, current:" << edge.currentTime << "min] ";
             }
@@ -184,4 +732,3 @@ public:
 };
 
 #endif
-
@@ -1,113 +1,252 @@
 #ifndef HASHTABLE_H
 #define HASHTABLE_H
 
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <vector>
-#include <list>
 #include <string>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 using namespace std;
 
-struct Junction 
+struct Junction
 {
     int id;
     string name;
     double lat;
     double lng;
-    
+
     Junction() : id(0), name(""), lat(0.0), lng(0.0) {}
 
-    Junction(int i, string n, double la, double lo) 
+    Junction(int i, string n, double la, double lo)
         : id(i), name(n), lat(la), lng(lo) {}
 };
 
-class HashTable 
+// Default hash: splitmix64 finalizer, so sequential IDs spread over all bits
+struct JunctionIdHash
+{
+    uint64_t operator()(int id) const
+    {
+        uint64_t x = (uint64_t)(uint32_t)id + 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+};
+
+// Open-addressing hash table keyed by junction ID, laid out like a Swiss
+// table: one control byte per slot holds EMPTY or the low 7 bits of the
+// slot's hash (h2). Slots come in groups of 16; a lookup compares all 16
+// control bytes of a group against h2 at once (SSE2, or a plain loop where
+// unavailable) and only touches slots whose byte matches. Groups are probed
+// in triangular order starting at the group picked by the high hash bits
+// (h1). The table doubles once it is 7/8 full.
+//
+// Pointers returned by search() stay valid until the next insert.
+template <typename Hash = JunctionIdHash>
+class BasicHashTable
 {
 
 private:
-    static const int TABLE_SIZE = 100;
-    vector<list<Junction>> table;
+    static const int GROUP_SIZE = 16;
+    static constexpr int8_t EMPTY = -128;    // 0x80; full slots are 0..127
+
+    vector<int8_t> control;     // capacity bytes, one per slot
+    vector<Junction> slots;
+    size_t groupMask;           // group count - 1 (group count is a power of two)
     int elementCount;
-    
-    int hashFunction(int key) 
+    bool logging;
+    Hash hasher;
+
+    // Bit i set where control[group * 16 + i] == byte
+    uint32_t matchByte(size_t group, int8_t byte) const
     {
-        return key % TABLE_SIZE;
+        const int8_t* ctrl = control.data() + group * GROUP_SIZE;
+#ifdef __SSE2__
+        __m128i bytes = _mm_loadu_si128((const __m128i*)ctrl);
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(byte)));
+#else
+        uint32_t mask = 0;
+
+        for (int i = 0; i < GROUP_SIZE; i++)
+        {
+            mask |= (uint32_t)(ctrl[i] == byte) << i;
+        }
+        return mask;
+#endif
     }
-    
-public:
-    HashTable() : table(TABLE_SIZE), elementCount(0) {}
-    
-    void insert(const Junction& junction) 
+
+    static int lowestBit(uint32_t mask)
+    {
+        return __builtin_ctz(mask);
+    }
+
+    // Slot of id, or -1
+    long findSlot(int id, uint64_t hash) const
     {
-        int index = hashFunction(junction.id);
-        
-        for (auto& j : table[index]) 
+        int8_t h2 = hash & 0x7f;
+        size_t group = (hash >> 7) & groupMask;
+
+        for (size_t step = 1; ; step++)
         {
-            if (j.id == junction.id) 
+            for (uint32_t match = matchByte(group, h2); match; match &= match - 1)
             {
-                j = junction;
-                cout << "[HashTable] Updated: ID " << junction.id << endl;
-                return;
+                size_t slot = group * GROUP_SIZE + lowestBit(match);
+
+                if (slots[slot].id == id)
+                {
+                    return slot;
+                }
+            }
+
+            // An empty slot in the group ends the probe sequence
+            if (matchByte(group, EMPTY))
+            {
+                return -1;
             }
+
+            group = (group + step) & groupMask;
         }
-        
-        table[index].push_back(junction);
-        elementCount++;
+    }
+
+    // First empty slot along id's probe sequence (the table is never full)
+    size_t freeSlot(uint64_t hash) const
+    {
+        size_t group = (hash >> 7) & groupMask;
 
-        cout << "[HashTable] Inserted: " << junction.name 
-             << " at bucket " << index << endl;
+        for (size_t step = 1; ; step++)
+        {
+            uint32_t empty = matchByte(group, EMPTY);
+
+            if (empty)
+            {
+                return group * GROUP_SIZE + lowestBit(empty);
+            }
+
+            group = (group + step) & groupMask;
+        }
     }
-    
-    Junction* search(int id) 
+
+    size_t capacity() const
+    {
+        return control.size();
+    }
+
+    void place(Junction&& junction)
     {
-        int index = hashFunction(id);
-        
-        for (auto& j : table[index]) 
+        uint64_t hash = hasher(junction.id);
+        size_t slot = freeSlot(hash);
+        control[slot] = hash & 0x7f;
+        slots[slot] = move(junction);
+    }
+
+    void rehash(size_t groups)
+    {
+        vector<int8_t> oldControl(groups * GROUP_SIZE, EMPTY);
+        vector<Junction> oldSlots(groups * GROUP_SIZE);
+        control.swap(oldControl);
+        slots.swap(oldSlots);
+        groupMask = groups - 1;
+
+        for (size_t i = 0; i < oldControl.size(); i++)
+        {
+            if (oldControl[i] != EMPTY)
+            {
+                place(move(oldSlots[i]));
+            }
+        }
+    }
+
+public:
+    BasicHashTable(Hash hash = Hash())
+        : control(GROUP_SIZE, EMPTY), slots(GROUP_SIZE), groupMask(0),
+          elementCount(0), logging(true), hasher(hash) {}
+
+    // Insert messages are part of the CLI demo; bulk loads switch them off
+    void setLogging(bool enabled)
+    {
+        logging = enabled;
+    }
+
+    void insert(const Junction& junction)
+    {
+        uint64_t hash = hasher(junction.id);
+        long slot = findSlot(junction.id, hash);
+
+        if (slot != -1)
         {
-            if (j.id == id) 
+            slots[slot] = junction;
+
+            if (logging)
             {
-                cout << "[HashTable] Found: " << j.name << endl;
-                return &j;
+                cout << "[HashTable] Updated: ID " << junction.id << endl;
             }
+            return;
+        }
+
+        // Max load factor 7/8
+        if ((size_t)(elementCount + 1) * 8 > capacity() * 7)
+        {
+            rehash((groupMask + 1) * 2);
+        }
+
+        place(Junction(junction));
+        elementCount++;
+
+        if (logging)
+        {
+            cout << "[HashTable] Inserted: " << junction.name << endl;
         }
-        
-        cout << "[HashTable] Not found: ID " << id << endl;
+    }
+
+    Junction* search(int id)
+    {
+        long slot = findSlot(id, hasher(id));
+        return slot == -1 ? nullptr : &slots[slot];
+    }
 
-        return nullptr;
+    const Junction* search(int id) const
+    {
+        long slot = findSlot(id, hasher(id));
+        return slot == -1 ? nullptr : &slots[slot];
     }
-    
-    void display() 
+
+    void display()
     {
         cout << "\n======== HASH TABLE CONTENTS ========" << endl;
         cout << "Total Elements: " << elementCount << endl;
-        cout << "Load Factor: " << (double)elementCount / TABLE_SIZE << endl;
+        cout << "Capacity: " << capacity() << " slots" << endl;
+        cout << "Load Factor: " << (double)elementCount / capacity() << endl;
         cout << "-------------------------------------" << endl;
-        
-        int usedBuckets = 0;
-    
-        for (int i = 0; i < TABLE_SIZE; i++) 
+
+        for (size_t group = 0; group <= groupMask; group++)
         {
-            if (!table[i].empty()) 
+            uint32_t full = ~matchByte(group, EMPTY) & 0xffff;
+
+            if (full)
             {
-                usedBuckets++;
-                cout << "Bucket " << i << " (" << table[i].size() << " items): ";
-            
-                for (auto& j : table[i]) 
+                cout << "Group " << group << " (" << __builtin_popcount(full) << " items): ";
+
+                for (; full; full &= full - 1)
                 {
-                    cout << "[" << j.name << "] ";
+                    cout << "[" << slots[group * GROUP_SIZE + lowestBit(full)].name << "] ";
                 }
-                
+
                 cout << endl;
             }
         }
-        
-        cout << "Used Buckets: " << usedBuckets << " / " << TABLE_SIZE << endl;
+
         cout << "====================================\n" << endl;
     }
-    
-    int size() const 
+
+    int size() const
     {
         return elementCount;
     }
 };
 
+using HashTable = BasicHashTable<>;
+
 #endif
@@ -0,0 +1,155 @@
+#ifndef JUNCTIONSTORE_H
+#define JUNCTIONSTORE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "perfecthash.h"
+using namespace std;
+
+// Junction records stored column by column. Each junction gets a dense
+// internal index in insertion order; coordinates sit in two float arrays,
+// so scanning coordinates touches nothing else and adding a junction does
+// not allocate per record. Names are not kept here: they change while
+// serving and live in the server's junction map (interned in its StringPool).
+//
+// Once the ID set is final, usePerfectHash() switches ID lookups to a
+// minimal perfect hash (one probe, a few bits per key); junctions added
+// after that go to a small overlay map.
+class JunctionStore
+{
+
+private:
+    vector<int> ids;                  // internal index -> junction ID
+    vector<float> lats;
+    vector<float> lngs;
+    unordered_map<int, int> indexOf;  // junction ID -> internal index (overlay once perfect)
+
+    PerfectHash perfect;
+    vector<int> slotIndex;            // perfect hash slot -> internal index
+    bool usingPerfect = false;
+
+public:
+
+    // Add a junction, or update it if the ID is already present. Returns
+    // its internal index.
+    int add(int id, double lat, double lng)
+    {
+        int index = find(id);
+
+        if (index != -1)
+        {
+            lats[index] = lat;
+            lngs[index] = lng;
+        }
+        else
+        {
+            index = ids.size();
+            indexOf[id] = index;
+            ids.push_back(id);
+            lats.push_back(lat);
+            lngs.push_back(lng);
+        }
+
+        return index;
+    }
+
+    void reserve(size_t count)
+    {
+        ids.reserve(count);
+        lats.reserve(count);
+        lngs.reserve(count);
+        indexOf.reserve(count);
+    }
+
+    // Internal index of a junction ID, or -1
+    int find(int id) const
+    {
+        if (usingPerfect)
+        {
+            int slot = perfect.lookup(id);
+
+            if (slot >= 0 && slot < (int)slotIndex.size() && ids[slotIndex[slot]] == id)
+            {
+                return slotIndex[slot];
+            }
+
+            if (indexOf.empty())
+            {
+                return -1;
+            }
+        }
+
+        auto it = indexOf.find(id);
+        return it == indexOf.end() ? -1 : it->second;
+    }
+
+    // Hash over exactly the IDs currently stored (see idColumn()); the
+    // general map is dropped and only holds junctions added from now on.
+    bool usePerfectHash(PerfectHash hash)
+    {
+        if (hash.size() != size())
+        {
+            return false;
+        }
+
+        slotIndex.assign(size(), -1);
+
+        for (int i = 0; i < size(); i++)
+        {
+            int slot = hash.lookup(ids[i]);
+
+            if (slot < 0 || slot >= size() || slotIndex[slot] != -1)
+            {
+                slotIndex.clear();
+                return false;
+            }
+            slotIndex[slot] = i;
+        }
+
+        perfect = move(hash);
+        usingPerfect = true;
+        indexOf = unordered_map<int, int>();
+        return true;
+    }
+
+    const vector<int>& idColumn() const
+    {
+        return ids;
+    }
+
+    int id(int index) const
+    {
+        return ids[index];
+    }
+
+    float latitude(int index) const
+    {
+        return lats[index];
+    }
+
+    float longitude(int index) const
+    {
+        return lngs[index];
+    }
+
+    // Whole columns, for sequential scans
+    const float* latitudes() const
+    {
+        return lats.data();
+    }
+
+    const float* longitudes() const
+    {
+        return lngs.data();
+    }
+
+    int size() const
+    {
+        return ids.size();
+    }
+};
+
+#endif
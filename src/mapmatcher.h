@@ -0,0 +1,318 @@
+#ifndef MAPMATCHER_H
+#define MAPMATCHER_H
+
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <vector>
+#include "geo.h"
+#include "graph.h"
+#include "segmentindex.h"
+using namespace std;
+
+struct GpsPoint
+{
+    double lat;
+    double lng;
+};
+
+struct MatchedPoint
+{
+    long long sequence;   // position of the point in the stream
+    bool matched;         // false when no road was close enough
+    SnapPoint position;   // road (dense node indices) and snapped coordinates
+};
+
+struct MapMatchOptions
+{
+    double sigmaKm = 0.01;              // GPS noise
+    double betaKm = 0.05;               // tolerated route/straight-line mismatch
+    double candidateRadiusKm = 0.05;
+    int maxCandidates = 6;
+    int lag = 8;                        // layers kept before a point is decided
+    double detourFactor = 2.0;          // route search bound: factor * straight + slack
+    double detourSlackKm = 0.3;
+};
+
+// Streaming HMM map matcher with fixed-lag Viterbi decoding.
+//
+// Hidden states are candidate positions on nearby roads (from SegmentIndex).
+// Emission scores follow the GPS noise (Gaussian in the snap distance);
+// transition scores compare the driving distance between two candidates
+// with the straight-line distance between the GPS points (exponential in the
+// difference, after Newson & Krumm). Driving distances come from a Dijkstra
+// on road lengths, bounded by a detour limit.
+//
+// Only the last `lag` layers are kept. When a point arrives, the oldest
+// layer is decided by backtracking from the current best candidate and
+// handed back to the caller, so memory and work per point stay constant.
+class MapMatcher
+{
+
+private:
+    struct Layer
+    {
+        long long sequence;
+        vector<SnapPoint> candidates;
+        vector<double> score;      // best log-probability of ending here
+        vector<int> back;          // best predecessor in the previous layer, -1 at a chain start
+        double lat;
+        double lng;
+    };
+
+    const Graph& graph;
+    const SegmentIndex& roads;
+    MapMatchOptions options;
+    deque<Layer> window;
+    long long nextSequence;
+    Graph::SearchWorkspace ws;
+
+    double roadLength(int u, int v) const
+    {
+        double best = numeric_limits<double>::infinity();
+
+        for (const auto& edge : graph.edges(u))
+        {
+            if (edge.to == v && edge.currentTime != numeric_limits<double>::infinity())
+            {
+                best = min(best, edge.distance);
+            }
+        }
+        return best;
+    }
+
+    // Driving distance (km) from one candidate to each of the next layer's
+    // candidates; infinity where the detour bound is exceeded.
+    vector<double> routeDistances(const SnapPoint& from, const vector<SnapPoint>& to, double bound)
+    {
+        const double INF = numeric_limits<double>::infinity();
+        vector<double> result(to.size(), INF);
+        auto later = greater<pair<double, int>>();
+
+        ws.reset(graph.nodeCount());
+
+        auto seed = [&](int node, double d)
+        {
+            if (d < ws.distance(node))
+            {
+                ws.settle(node, d, -1);
+                ws.heap.push_back({d, node});
+                push_heap(ws.heap.begin(), ws.heap.end(), later);
+            }
+        };
+
+        seed(from.to, proRated(1 - from.fraction, roadLength(from.from, from.to)));
+        seed(from.from, proRated(from.fraction, roadLength(from.to, from.from)));
+
+        while (!ws.heap.empty())
+        {
+            pop_heap(ws.heap.begin(), ws.heap.end(), later);
+            auto [d, u] = ws.heap.back();
+            ws.heap.pop_back();
+
+            if (d > bound)
+            {
+                break;
+            }
+
+            if (d > ws.distance(u))
+            {
+                continue;
+            }
+
+            for (const auto& edge : graph.edges(u))
+            {
+                if (edge.currentTime == INF)
+                {
+                    continue;
+                }
+
+                double candidate = d + edge.distance;
+
+                if (candidate < ws.distance(edge.to))
+                {
+                    ws.settle(edge.to, candidate, u);
+                    ws.heap.push_back({candidate, edge.to});
+                    push_heap(ws.heap.begin(), ws.heap.end(), later);
+                }
+            }
+        }
+
+        for (size_t i = 0; i < to.size(); i++)
+        {
+            const SnapPoint& p = to[i];
+            double viaFrom = ws.distance(p.from) + proRated(p.fraction, roadLength(p.from, p.to));
+            double viaTo = ws.distance(p.to) + proRated(1 - p.fraction, roadLength(p.to, p.from));
+            result[i] = min(viaFrom, viaTo);
+
+            // Moving along the same road without passing a junction
+            if (p.from == from.from && p.to == from.to)
+            {
+                if (p.fraction >= from.fraction)
+                {
+                    result[i] = min(result[i], proRated(p.fraction - from.fraction, roadLength(p.from, p.to)));
+                }
+                else
+                {
+                    result[i] = min(result[i], proRated(from.fraction - p.fraction, roadLength(p.to, p.from)));
+                }
+            }
+
+            if (result[i] > bound)
+            {
+                result[i] = INF;
+            }
+        }
+
+        return result;
+    }
+
+    // Decide the oldest layer by backtracking from the newest layer's best state
+    MatchedPoint decideOldest() const
+    {
+        const Layer& newest = window.back();
+        int state = max_element(newest.score.begin(), newest.score.end()) - newest.score.begin();
+
+        for (size_t i = window.size() - 1; i > 0; i--)
+        {
+            state = window[i].back[state];
+        }
+
+        return {window.front().sequence, true, window.front().candidates[state]};
+    }
+
+    // A chain break: decode everything buffered so far
+    void drain(vector<MatchedPoint>& out)
+    {
+        while (!window.empty())
+        {
+            out.push_back(decideOldest());
+            window.pop_front();
+        }
+    }
+
+public:
+    MapMatcher(const Graph& g, const SegmentIndex& r, MapMatchOptions o = MapMatchOptions())
+        : graph(g), roads(r), options(o), nextSequence(0) {}
+
+    // Feed one GPS point; returns the points whose match is now final, in order
+    vector<MatchedPoint> push(const GpsPoint& point)
+    {
+        vector<MatchedPoint> decided;
+        Layer layer;
+        layer.sequence = nextSequence++;
+        layer.lat = point.lat;
+        layer.lng = point.lng;
+        layer.candidates = roads.withinRadius(point.lat, point.lng, options.candidateRadiusKm);
+
+        if ((int)layer.candidates.size() > options.maxCandidates)
+        {
+            layer.candidates.resize(options.maxCandidates);
+        }
+
+        if (layer.candidates.empty())
+        {
+            // Off-road point: decide what we have and report it unmatched
+            drain(decided);
+            decided.push_back({layer.sequence, false, SnapPoint()});
+            return decided;
+        }
+
+        size_t n = layer.candidates.size();
+        layer.score.assign(n, -numeric_limits<double>::infinity());
+        layer.back.assign(n, -1);
+
+        auto emission = [&](const SnapPoint& p)
+        {
+            double z = p.distanceKm / options.sigmaKm;
+            return -0.5 * z * z;
+        };
+
+        if (!window.empty())
+        {
+            const Layer& previous = window.back();
+            double straight = haversineKm(previous.lat, previous.lng, point.lat, point.lng);
+            double bound = options.detourFactor * straight + options.detourSlackKm;
+
+            for (size_t i = 0; i < previous.candidates.size(); i++)
+            {
+                if (previous.score[i] == -numeric_limits<double>::infinity())
+                {
+                    continue;
+                }
+
+                vector<double> route = routeDistances(previous.candidates[i], layer.candidates, bound);
+
+                for (size_t j = 0; j < n; j++)
+                {
+                    if (route[j] == numeric_limits<double>::infinity())
+                    {
+                        continue;
+                    }
+
+                    double score = previous.score[i] - fabs(route[j] - straight) / options.betaKm;
+
+                    if (score > layer.score[j])
+                    {
+                        layer.score[j] = score;
+                        layer.back[j] = i;
+                    }
+                }
+            }
+
+            bool connected = false;
+
+            for (double s : layer.score)
+            {
+                connected = connected || s != -numeric_limits<double>::infinity();
+            }
+
+            // No candidate reachable from the previous layer: start a new chain
+            if (!connected)
+            {
+                drain(decided);
+            }
+        }
+
+        for (size_t j = 0; j < n; j++)
+        {
+            if (window.empty())
+            {
+                layer.score[j] = 0;
+            }
+
+            if (layer.score[j] != -numeric_limits<double>::infinity())
+            {
+                layer.score[j] += emission(layer.candidates[j]);
+            }
+        }
+
+        // Keep scores near zero so long chains cannot underflow
+        double top = *max_element(layer.score.begin(), layer.score.end());
+
+        for (double& s : layer.score)
+        {
+            s -= top;
+        }
+
+        window.push_back(move(layer));
+
+        if ((int)window.size() > options.lag)
+        {
+            decided.push_back(decideOldest());
+            window.pop_front();
+        }
+
+        return decided;
+    }
+
+    // End of stream: decide every buffered point
+    vector<MatchedPoint> flush()
+    {
+        vector<MatchedPoint> decided;
+        drain(decided);
+        return decided;
+    }
+};
+
+#endif
@@ -0,0 +1,545 @@
+#ifndef NAMEFST_H
+#define NAMEFST_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+// Immutable name -> ID dictionary stored as a minimal acyclic finite-state
+// transducer.
+//
+// Names sharing a prefix share the states that spell it, and names sharing
+// a suffix share the states after it: build() adds the names in sorted
+// order and replaces every finished state by an identical one already
+// written, if there is one (Daciuk et al.). Each transition carries an
+// output; a name's ID is the sum of the outputs along its path plus the
+// final output of its last state. Outputs are pushed towards the root as
+// far as the names below agree, so shared states stay shareable.
+//
+// States are written leaves first into one flat file that is mmap()'d at
+// startup. Lookups walk the mapped bytes directly, so a process pays only
+// for the pages it touches, and processes mapping the same file share them
+// through the page cache.
+//
+// State layout: a byte holding the final flag and the transition count
+// (127 = count follows as a varint), the final output (varint) if final,
+// then per transition, in label order: label byte, output (varint) and the
+// distance back to the target state (varint).
+class NameFST
+{
+
+private:
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        uint64_t signature;
+        uint32_t keys;
+        uint32_t root;
+        uint64_t bytes;
+    };
+
+    static constexpr uint32_t FORMAT_VERSION = 1;
+
+    const char* data;
+    size_t length;
+    const Header* header;
+    const uint8_t* states;
+
+    static void putVarint(string& out, uint32_t v)
+    {
+        while (v >= 0x80)
+        {
+            out += (char)(v | 0x80);
+            v >>= 7;
+        }
+        out += (char)v;
+    }
+
+    static uint32_t getVarint(const uint8_t*& p)
+    {
+        uint32_t v = *p & 0x7f;
+
+        for (int shift = 7; *p++ & 0x80; shift += 7)
+        {
+            v |= (uint32_t)(*p & 0x7f) << shift;
+        }
+        return v;
+    }
+
+    // A state being read: its header decoded, transitions still to come
+    struct State
+    {
+        uint32_t address;
+        bool final;
+        uint32_t finalOutput;
+        uint32_t count;
+        const uint8_t* next;
+    };
+
+    struct Transition
+    {
+        uint8_t label;
+        uint32_t output;
+        uint32_t target;
+    };
+
+    State state(uint32_t address) const
+    {
+        const uint8_t* p = states + address;
+        State s;
+        s.address = address;
+        s.final = *p & 1;
+        s.count = *p++ >> 1;
+
+        if (s.count == 127)
+        {
+            s.count = getVarint(p);
+        }
+        s.finalOutput = s.final ? getVarint(p) : 0;
+        s.next = p;
+        return s;
+    }
+
+    static Transition nextTransition(State& s)
+    {
+        Transition t;
+        t.label = *s.next++;
+        t.output = getVarint(s.next);
+        t.target = s.address - getVarint(s.next);
+        return t;
+    }
+
+    // Follow key from the root; false if it leaves the automaton
+    bool walk(string_view key, uint32_t& address, uint32_t& output) const
+    {
+        address = header->root;
+        output = 0;
+
+        for (unsigned char c : key)
+        {
+            State s = state(address);
+            bool found = false;
+
+            for (uint32_t i = 0; i < s.count; i++)
+            {
+                Transition t = nextTransition(s);
+
+                if (t.label >= c)
+                {
+                    found = t.label == c;
+                    address = t.target;
+                    output += t.output;
+                    break;
+                }
+            }
+
+            if (!found)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Names below address in order, skipping those before `from` while
+    // `tight` (the path so far equals from's first depth bytes). Returns
+    // false once visit() asks to stop.
+    template<typename Visit>
+    bool visitFrom(uint32_t address, uint32_t output, string& key, string_view from, bool tight,
+                   const Visit& visit) const
+    {
+        State s = state(address);
+        size_t depth = key.size();
+        bool before = tight && depth < from.size();    // names ending here sort before from
+
+        if (s.final && !before && !visit(key, output + s.finalOutput))
+        {
+            return false;
+        }
+
+        for (uint32_t i = 0; i < s.count; i++)
+        {
+            Transition t = nextTransition(s);
+
+            if (before && t.label < (unsigned char)from[depth])
+            {
+                continue;
+            }
+
+            key.push_back((char)t.label);
+
+            if (!visitFrom(t.target, output + t.output, key, from, before && t.label == (unsigned char)from[depth], visit))
+            {
+                return false;
+            }
+            key.pop_back();
+        }
+        return true;
+    }
+
+public:
+    NameFST() : data(nullptr), length(0), header(nullptr), states(nullptr) {}
+
+    ~NameFST()
+    {
+        unload();
+    }
+
+    NameFST(const NameFST&) = delete;
+    NameFST& operator=(const NameFST&) = delete;
+
+    // Fingerprint of the (name, ID) pairs a file is built from, in the
+    // order given
+    static uint64_t signatureOf(const vector<pair<string, uint32_t>>& entries)
+    {
+        uint64_t h = 1469598103934665603ULL;
+
+        auto mix = [&](const void* p, size_t bytes)
+        {
+            for (size_t i = 0; i < bytes; i++)
+            {
+                h ^= ((const uint8_t*)p)[i];
+                h *= 1099511628211ULL;
+            }
+        };
+
+        for (const auto& [name, value] : entries)
+        {
+            uint32_t size = name.size();
+            mix(&size, 4);
+            mix(name.data(), name.size());
+            mix(&value, 4);
+        }
+        return h;
+    }
+
+    // Write the dictionary for entries to path. Empty names are skipped;
+    // for repeated names the last pair wins, as in BTree::bulkLoad().
+    static bool build(vector<pair<string, uint32_t>> entries, const string& path)
+    {
+        uint64_t signature = signatureOf(entries);
+
+        stable_sort(entries.begin(), entries.end(), [](const auto& a, const auto& b)
+        {
+            return a.first < b.first;
+        });
+
+        struct Arc
+        {
+            uint8_t label;
+            uint32_t output;
+            uint32_t target;
+        };
+
+        struct Pending
+        {
+            vector<Arc> arcs;
+            bool final = false;
+            uint32_t finalOutput = 0;
+        };
+
+        string bytes;
+        unordered_map<string, uint32_t> written;    // state contents -> address
+
+        // Write a finished state, or find the identical one written before
+        auto freeze = [&](const Pending& p)
+        {
+            string key;
+            key += (char)p.final;
+            putVarint(key, p.finalOutput);
+
+            for (const Arc& a : p.arcs)
+            {
+                key += (char)a.label;
+                putVarint(key, a.output);
+                putVarint(key, a.target);
+            }
+
+            auto it = written.find(key);
+
+            if (it != written.end())
+            {
+                return it->second;
+            }
+
+            uint32_t address = bytes.size();
+            bytes += (char)((min<size_t>(p.arcs.size(), 127) << 1) | p.final);
+
+            if (p.arcs.size() >= 127)
+            {
+                putVarint(bytes, p.arcs.size());
+            }
+            if (p.final)
+            {
+                putVarint(bytes, p.finalOutput);
+            }
+
+            for (const Arc& a : p.arcs)
+            {
+                bytes += (char)a.label;
+                putVarint(bytes, a.output);
+                putVarint(bytes, address - a.target);
+            }
+
+            written.emplace(move(key), address);
+            return address;
+        };
+
+        // States on the path of the last name added, root first
+        vector<Pending> unfinished(1);
+        string previous;
+        uint32_t keys = 0;
+
+        auto finishBelow = [&](size_t depth)
+        {
+            while (unfinished.size() > depth + 1)
+            {
+                uint32_t address = freeze(unfinished.back());
+                unfinished.pop_back();
+                unfinished.back().arcs.back().target = address;
+            }
+        };
+
+        for (size_t e = 0; e < entries.size(); e++)
+        {
+            const string& name = entries[e].first;
+
+            if (name.empty() || (e + 1 < entries.size() && entries[e + 1].first == name))
+            {
+                continue;
+            }
+
+            size_t common = 0;
+
+            while (common < previous.size() && common < name.size() && previous[common] == name[common])
+            {
+                common++;
+            }
+
+            finishBelow(common);
+
+            // Keep on the shared prefix only what this name agrees with;
+            // the rest moves down to the states after it
+            uint32_t output = entries[e].second;
+
+            for (size_t i = 0; i < common; i++)
+            {
+                Arc& arc = unfinished[i].arcs.back();
+                uint32_t shared = min(arc.output, output);
+                uint32_t rest = arc.output - shared;
+
+                arc.output = shared;
+                output -= shared;
+
+                if (rest)
+                {
+                    for (Arc& below : unfinished[i + 1].arcs)
+                    {
+                        below.output += rest;
+                    }
+                    if (unfinished[i + 1].final)
+                    {
+                        unfinished[i + 1].finalOutput += rest;
+                    }
+                }
+            }
+
+            for (size_t i = common; i < name.size(); i++)
+            {
+                unfinished.back().arcs.push_back({(uint8_t)name[i], i == common ? output : 0, 0});
+                unfinished.emplace_back();
+            }
+            unfinished.back().final = true;
+
+            previous = name;
+            keys++;
+        }
+
+        finishBelow(0);
+        uint32_t root = freeze(unfinished[0]);
+
+        Header h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, "FST1", 4);
+        h.version = FORMAT_VERSION;
+        h.signature = signature;
+        h.keys = keys;
+        h.root = root;
+        h.bytes = bytes.size();
+
+        // Written beside path and renamed over it: a process that has the old
+        // dictionary mapped keeps its pages, and a failed write leaves it whole
+        string temporary = path + ".tmp";
+        ofstream file(temporary, ios::binary | ios::trunc);
+
+        if (!file.is_open())
+        {
+            cout << "[FST] Could not write " << temporary << endl;
+            return false;
+        }
+
+        file.write((const char*)&h, sizeof(h));
+        file.write(bytes.data(), bytes.size());
+        file.close();
+
+        if (!file.good() || rename(temporary.c_str(), path.c_str()) != 0)
+        {
+            cout << "[FST] Could not write " << path << endl;
+            remove(temporary.c_str());
+            return false;
+        }
+
+        cout << "[FST] Built " << keys << " names into " << bytes.size() << " bytes ("
+             << written.size() << " states)" << endl;
+
+        return true;
+    }
+
+    // Map a file written by build(); fails if it was built from other
+    // entries (signature 0 accepts any)
+    bool load(const string& path, uint64_t signature = 0)
+    {
+        unload();
+
+        int fd = open(path.c_str(), O_RDONLY);
+
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        struct stat info;
+
+        if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(Header))
+        {
+            close(fd);
+            return false;
+        }
+
+        length = info.st_size;
+        void* p = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+
+        if (p == MAP_FAILED)
+        {
+            length = 0;
+            return false;
+        }
+
+        data = (const char*)p;
+        header = (const Header*)data;
+        states = (const uint8_t*)(data + sizeof(Header));
+
+        if (memcmp(header->magic, "FST1", 4) != 0 || header->version != FORMAT_VERSION ||
+            header->bytes != length - sizeof(Header) || header->root >= header->bytes ||
+            (signature && header->signature != signature))
+        {
+            unload();
+            return false;
+        }
+
+        cout << "[FST] Mapped " << path << " (" << header->keys << " names, " << length << " bytes)" << endl;
+        return true;
+    }
+
+    void unload()
+    {
+        if (data)
+        {
+            munmap((void*)data, length);
+        }
+
+        data = nullptr;
+        length = 0;
+        header = nullptr;
+        states = nullptr;
+    }
+
+    bool isLoaded() const
+    {
+        return header != nullptr;
+    }
+
+    // ID for exactly this name
+    bool find(string_view name, uint32_t& value) const
+    {
+        uint32_t address, output;
+
+        if (!header || !walk(name, address, output))
+        {
+            return false;
+        }
+
+        State s = state(address);
+        value = output + s.finalOutput;
+        return s.final;
+    }
+
+    // visit(name, id) for names starting with prefix and sorting after
+    // `after` (a cursor, or empty), in order, until it returns false
+    template<typename Visit>
+    void prefix(string_view prefix, string_view after, const Visit& visit) const
+    {
+        uint32_t address, output;
+
+        if (!header || !walk(prefix, address, output))
+        {
+            return;
+        }
+
+        string key(prefix);
+        bool tight = after.size() >= prefix.size() && after.compare(0, prefix.size(), prefix) == 0;
+
+        if (!tight && after > prefix)
+        {
+            return;    // the cursor is past every name with this prefix
+        }
+
+        visitFrom(address, output, key, after, tight, [&](const string& name, uint32_t value)
+        {
+            return name == after || visit(name, value);
+        });
+    }
+
+    // visit(name, id) for names in [low, high) in order, until it returns false
+    template<typename Visit>
+    void range(string_view low, string_view high, const Visit& visit) const
+    {
+        if (!header)
+        {
+            return;
+        }
+
+        string key;
+        visitFrom(header->root, 0, key, low, true, [&](const string& name, uint32_t value)
+        {
+            return name < high && visit(name, value);
+        });
+    }
+
+    int size() const
+    {
+        return header ? header->keys : 0;
+    }
+
+    size_t mappedBytes() const
+    {
+        return length;
+    }
+};
+
+#endif
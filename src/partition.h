@@ -0,0 +1,97 @@
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+#include "graph.h"
+using namespace std;
+
+// Splits the junctions into geographic regions by recursive coordinate
+// bisection: each cell is cut at the median of its wider axis until the
+// requested region count is reached. Returns the region of every node,
+// indexed by the graph's dense node index.
+class Partition
+{
+
+private:
+    vector<int> regionOf;
+    int regions;
+
+    void split(const Graph& graph, vector<int>& nodes, int begin, int end, int firstRegion, int count)
+    {
+        if (count <= 1 || end - begin <= 1)
+        {
+            for (int i = begin; i < end; i++)
+            {
+                regionOf[nodes[i]] = firstRegion;
+            }
+            regions = max(regions, firstRegion + 1);
+            return;
+        }
+
+        double minLat = 1e18, maxLat = -1e18, minLng = 1e18, maxLng = -1e18;
+
+        for (int i = begin; i < end; i++)
+        {
+            minLat = min(minLat, graph.latitude(nodes[i]));
+            maxLat = max(maxLat, graph.latitude(nodes[i]));
+            minLng = min(minLng, graph.longitude(nodes[i]));
+            maxLng = max(maxLng, graph.longitude(nodes[i]));
+        }
+
+        bool byLat = (maxLat - minLat) >= (maxLng - minLng);
+        int leftCount = count / 2;
+
+        // Cut proportionally to the number of regions on each side
+        int mid = begin + (int)((long long)(end - begin) * leftCount / count);
+
+        nth_element(nodes.begin() + begin, nodes.begin() + mid, nodes.begin() + end,
+            [&](int a, int b)
+            {
+                return byLat ? graph.latitude(a) < graph.latitude(b)
+                             : graph.longitude(a) < graph.longitude(b);
+            });
+
+        split(graph, nodes, begin, mid, firstRegion, leftCount);
+        split(graph, nodes, mid, end, firstRegion + leftCount, count - leftCount);
+    }
+
+public:
+    Partition() : regions(0) {}
+
+    void build(const Graph& graph, int regionCount)
+    {
+        vector<int> nodes(graph.nodeCount());
+        iota(nodes.begin(), nodes.end(), 0);
+
+        regionOf.assign(graph.nodeCount(), 0);
+        regions = 0;
+        split(graph, nodes, 0, nodes.size(), 0, max(1, regionCount));
+
+        // Small graphs leave some region numbers unused; renumber densely
+        vector<int> renumber(regions, -1);
+        regions = 0;
+
+        for (int& r : regionOf)
+        {
+            if (renumber[r] == -1)
+            {
+                renumber[r] = regions++;
+            }
+            r = renumber[r];
+        }
+    }
+
+    int region(int node) const
+    {
+        return regionOf[node];
+    }
+
+    int size() const
+    {
+        return regions;
+    }
+};
+
+#endif
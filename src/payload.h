@@ -0,0 +1,122 @@
+#ifndef PAYLOAD_H
+#define PAYLOAD_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include "compression.h"
+using namespace std;
+
+// A response body serialized once and kept ready to send: the bytes, their
+// compressed forms and a strong ETag per form. Serving it is a copy, with
+// no parsing, dumping or compressing on the request path. Immutable once
+// built; share it through a shared_ptr<const Payload> and build a new one
+// when the data changes.
+//
+// Compressed forms are made for the codings built in (see compression.h),
+// at the level meant for kept bodies, and only for bodies of at least
+// Compression::MIN_BYTES.
+class Payload
+{
+
+private:
+    string forms[3];    // by Encoding; empty if not made
+    string tags[3];
+
+    // FNV-1a, 64 bits: the same bytes get the same tag across restarts
+    static uint64_t hashOf(string_view s)
+    {
+        uint64_t h = 14695981039346656037ULL;
+
+        for (unsigned char c : s)
+        {
+            h = (h ^ c) * 1099511628211ULL;
+        }
+        return h;
+    }
+
+public:
+    explicit Payload(string body)
+    {
+        char hex[17];
+        snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)hashOf(body));
+
+        for (Encoding encoding : {Encoding::GZIP, Encoding::BROTLI})
+        {
+            if (body.size() >= Compression::MIN_BYTES && Compression::available(encoding))
+            {
+                forms[(int)encoding] = Compression::compress(body, encoding, true);
+            }
+            // Each form has bytes of its own, so a tag of its own
+            tags[(int)encoding] = "\"" + string(hex) + "-" + Compression::name(encoding) + "\"";
+        }
+        tags[(int)Encoding::IDENTITY] = "\"" + string(hex) + "\"";
+        forms[(int)Encoding::IDENTITY] = move(body);
+    }
+
+    const string& body(Encoding encoding = Encoding::IDENTITY) const
+    {
+        return forms[(int)encoding];
+    }
+
+    const string& etag(Encoding encoding = Encoding::IDENTITY) const
+    {
+        return tags[(int)encoding];
+    }
+
+    // The form to send for an Accept-Encoding header: the negotiated
+    // coding if that form was made, else identity
+    Encoding encodingFor(string_view acceptEncoding) const
+    {
+        Encoding encoding = Compression::negotiate(acceptEncoding);
+        return forms[(int)encoding].empty() ? Encoding::IDENTITY : encoding;
+    }
+
+    // True if any compressed form was made, so responses vary by Accept-Encoding
+    bool compressed() const
+    {
+        return !forms[(int)Encoding::GZIP].empty() || !forms[(int)Encoding::BROTLI].empty();
+    }
+
+    // True if an If-None-Match header value names tag (or is "*").
+    // Compared weakly, as RFC 9110 asks for If-None-Match.
+    static bool matches(string_view ifNoneMatch, string_view tag)
+    {
+        size_t pos = 0;
+
+        while (pos < ifNoneMatch.size())
+        {
+            size_t end = ifNoneMatch.find(',', pos);
+
+            if (end == string_view::npos)
+            {
+                end = ifNoneMatch.size();
+            }
+
+            string_view candidate = ifNoneMatch.substr(pos, end - pos);
+
+            while (!candidate.empty() && (candidate.front() == ' ' || candidate.front() == '\t'))
+            {
+                candidate.remove_prefix(1);
+            }
+            while (!candidate.empty() && (candidate.back() == ' ' || candidate.back() == '\t'))
+            {
+                candidate.remove_suffix(1);
+            }
+            if (candidate.substr(0, 2) == "W/")
+            {
+                candidate.remove_prefix(2);
+            }
+
+            if (candidate == "*" || candidate == tag)
+            {
+                return true;
+            }
+            pos = end + 1;
+        }
+        return false;
+    }
+};
+
+#endif
@@ -0,0 +1,299 @@
+#ifndef PERFECTHASH_H
+#define PERFECTHASH_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// Minimal perfect hash over a fixed set of junction IDs, built BBHash-style.
+//
+// Level 0 is a bit array of GAMMA * n bits; every key hashes to one bit and
+// keys that land alone keep it, colliding keys move on to the next (smaller)
+// level with a different seed. A key's slot is the rank of its bit over all
+// levels, so slots are exactly 0..n-1. The few keys still colliding after
+// MAX_LEVELS go to a small fallback map.
+//
+// lookup() of an ID outside the set returns an arbitrary slot (or -1), so
+// callers must check the slot's key. Ranks are sampled every 512 bits, which
+// with GAMMA = 2 comes to about 3.5 bits per key.
+class PerfectHash
+{
+
+private:
+    static const int GAMMA = 2;
+    static const int MAX_LEVELS = 24;
+    static const int FORMAT_VERSION = 1;
+
+    struct Level
+    {
+        size_t firstBit;     // position of this level in bits
+        size_t size;         // bits, a multiple of 64
+    };
+
+    vector<Level> levels;
+    vector<uint64_t> bits;           // all levels back to back
+    vector<uint32_t> blockRank;      // set bits before each 512-bit block
+    unordered_map<int, int> fallback;
+    int keyCount;
+
+    static uint64_t hash(int key, int level)
+    {
+        uint64_t x = (uint64_t)(uint32_t)key ^ ((uint64_t)(level + 1) * 0x9e3779b97f4a7c15ULL);
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    bool testBit(size_t p) const
+    {
+        return (bits[p >> 6] >> (p & 63)) & 1;
+    }
+
+    size_t rank(size_t p) const
+    {
+        size_t word = p >> 6;
+        size_t r = blockRank[word >> 3];
+
+        for (size_t w = word & ~(size_t)7; w < word; w++)
+        {
+            r += __builtin_popcountll(bits[w]);
+        }
+        return r + __builtin_popcountll(bits[word] & ((1ULL << (p & 63)) - 1));
+    }
+
+    void buildRanks()
+    {
+        blockRank.assign(bits.size() / 8 + 1, 0);
+        size_t total = 0;
+
+        for (size_t w = 0; w < bits.size(); w++)
+        {
+            if (w % 8 == 0)
+            {
+                blockRank[w / 8] = total;
+            }
+            total += __builtin_popcountll(bits[w]);
+        }
+    }
+
+public:
+    PerfectHash() : keyCount(0) {}
+
+    // Fingerprint of an ID list, stored with the hash so a stale file is rejected
+    static uint64_t signatureOf(const vector<int>& keys)
+    {
+        uint64_t h = 1469598103934665603ULL;
+
+        auto mix = [&](uint64_t value)
+        {
+            for (int i = 0; i < 8; i++)
+            {
+                h ^= (value >> (i * 8)) & 0xff;
+                h *= 1099511628211ULL;
+            }
+        };
+
+        mix(keys.size());
+
+        for (int key : keys)
+        {
+            mix((uint32_t)key);
+        }
+        return h;
+    }
+
+    // keys must be distinct
+    void build(const vector<int>& keys)
+    {
+        levels.clear();
+        bits.clear();
+        fallback.clear();
+        keyCount = keys.size();
+
+        vector<int> remaining = keys;
+
+        for (int level = 0; level < MAX_LEVELS && !remaining.empty(); level++)
+        {
+            size_t size = ((remaining.size() * GAMMA + 63) / 64) * 64;
+            size_t first = bits.size() * 64;
+            vector<uint64_t> seen(size / 64, 0);
+            vector<uint64_t> collided(size / 64, 0);
+
+            for (int key : remaining)
+            {
+                size_t p = hash(key, level) % size;
+                uint64_t mask = 1ULL << (p & 63);
+
+                if (seen[p >> 6] & mask)
+                {
+                    collided[p >> 6] |= mask;
+                }
+                seen[p >> 6] |= mask;
+            }
+
+            vector<int> next;
+
+            for (int key : remaining)
+            {
+                size_t p = hash(key, level) % size;
+
+                if ((collided[p >> 6] >> (p & 63)) & 1)
+                {
+                    next.push_back(key);
+                }
+            }
+
+            for (size_t w = 0; w < seen.size(); w++)
+            {
+                bits.push_back(seen[w] & ~collided[w]);
+            }
+
+            levels.push_back({first, size});
+            remaining.swap(next);
+        }
+
+        buildRanks();
+
+        int slot = keyCount - remaining.size();
+
+        for (int key : remaining)
+        {
+            fallback[key] = slot++;
+        }
+    }
+
+    // Slot in [0, size()) for keys of the set; arbitrary slot or -1 otherwise
+    int lookup(int key) const
+    {
+        for (const Level& level : levels)
+        {
+            size_t p = level.firstBit + hash(key, &level - levels.data()) % level.size;
+
+            if (testBit(p))
+            {
+                return rank(p);
+            }
+        }
+
+        auto it = fallback.find(key);
+        return it == fallback.end() ? -1 : it->second;
+    }
+
+    int size() const
+    {
+        return keyCount;
+    }
+
+    // Bits of hash data per key, excluding the fallback map
+    double bitsPerKey() const
+    {
+        return keyCount ? (bits.size() * 64.0 + blockRank.size() * 32.0) / keyCount : 0;
+    }
+
+    bool save(const string& path, uint64_t signature) const
+    {
+        ofstream file(path, ios::binary | ios::trunc);
+
+        if (!file.is_open())
+        {
+            cout << "[PerfectHash] Could not write " << path << endl;
+            return false;
+        }
+
+        auto put = [&](const void* p, size_t bytes)
+        {
+            file.write((const char*)p, bytes);
+        };
+
+        uint32_t header[5] = {0x3148504d /* "MPH1" */, FORMAT_VERSION, (uint32_t)keyCount,
+                              (uint32_t)levels.size(), (uint32_t)fallback.size()};
+        put(header, sizeof(header));
+        put(&signature, sizeof(signature));
+
+        for (const Level& level : levels)
+        {
+            uint64_t size = level.size;
+            put(&size, sizeof(size));
+        }
+
+        put(bits.data(), bits.size() * 8);
+
+        for (auto [key, slot] : fallback)
+        {
+            int32_t pair[2] = {key, slot};
+            put(pair, sizeof(pair));
+        }
+
+        return file.good();
+    }
+
+    // Read a file written by save(); fails if it was built for other keys
+    bool load(const string& path, uint64_t signature)
+    {
+        ifstream file(path, ios::binary);
+
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        auto get = [&](void* p, size_t bytes)
+        {
+            return (bool)file.read((char*)p, bytes);
+        };
+
+        uint32_t header[5];
+        uint64_t stored;
+
+        if (!get(header, sizeof(header)) || !get(&stored, sizeof(stored)) ||
+            header[0] != 0x3148504d || header[1] != FORMAT_VERSION || stored != signature)
+        {
+            return false;
+        }
+
+        keyCount = header[2];
+        levels.clear();
+        fallback.clear();
+        size_t words = 0;
+
+        for (uint32_t i = 0; i < header[3]; i++)
+        {
+            uint64_t size;
+
+            if (!get(&size, sizeof(size)) || size % 64 != 0)
+            {
+                return false;
+            }
+            levels.push_back({words * 64, (size_t)size});
+            words += size / 64;
+        }
+
+        bits.assign(words, 0);
+
+        if (!get(bits.data(), words * 8))
+        {
+            return false;
+        }
+
+        for (uint32_t i = 0; i < header[4]; i++)
+        {
+            int32_t pair[2];
+
+            if (!get(pair, sizeof(pair)))
+            {
+                return false;
+            }
+            fallback[pair[0]] = pair[1];
+        }
+
+        buildRanks();
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,294 @@
+#ifndef POPULARITYTRIE_H
+#define POPULARITYTRIE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// Top-k completion by popularity: a path-compressed trie over names where
+// every node also keeps the highest score below it.
+//
+// topK() does a best-first walk from the prefix's node: a queue ordered by
+// those subtree maxima, holding both nodes and places, pops places in score
+// order, so it stops after k places and a few nodes per level instead of
+// enumerating every name under the prefix.
+//
+// Scores only grow. bump() is an atomic add on the place's score and then
+// an atomic max up its parent chain, stopping where an ancestor is already
+// as high, so concurrent bumps and topK() calls need no lock. Each value
+// (place) has one name; insert() and remove() change the trie's shape and
+// must not run concurrently with anything else.
+class PopularityTrie
+{
+
+private:
+    struct Node;
+
+    struct Place
+    {
+        uint32_t value;
+        atomic<uint64_t> score{0};
+        Node* node = nullptr;
+    };
+
+    struct Node
+    {
+        string label;                       // bytes on the edge from the parent
+        Node* parent = nullptr;
+        vector<unique_ptr<Node>> children;  // sorted by first label byte
+        vector<Place*> places;              // names ending here
+        atomic<uint64_t> best{0};           // highest score in this subtree
+    };
+
+    Node root;
+    unordered_map<uint32_t, unique_ptr<Place>> places;
+
+    // Raise node and its ancestors to at least score
+    static void raise(Node* node, uint64_t score)
+    {
+        for (; node; node = node->parent)
+        {
+            uint64_t current = node->best.load(memory_order_relaxed);
+
+            do
+            {
+                if (current >= score)
+                {
+                    return;    // whoever raised it this far also raises the ancestors
+                }
+            } while (!node->best.compare_exchange_weak(current, score, memory_order_relaxed));
+        }
+    }
+
+    static Node* child(const Node* node, unsigned char first)
+    {
+        auto it = lower_bound(node->children.begin(), node->children.end(), first,
+            [](const unique_ptr<Node>& c, unsigned char b)
+            {
+                return (unsigned char)c->label[0] < b;
+            });
+
+        return it != node->children.end() && (unsigned char)(*it)->label[0] == first ? it->get() : nullptr;
+    }
+
+    // Node for name, created (splitting an edge if needed) when missing
+    Node* nodeFor(const string& name)
+    {
+        Node* node = &root;
+        size_t depth = 0;
+
+        while (depth < name.size())
+        {
+            Node* next = child(node, name[depth]);
+
+            if (!next)
+            {
+                auto leaf = make_unique<Node>();
+                leaf->label = name.substr(depth);
+                leaf->parent = node;
+                next = leaf.get();
+
+                auto at = lower_bound(node->children.begin(), node->children.end(), (unsigned char)name[depth],
+                    [](const unique_ptr<Node>& c, unsigned char b)
+                    {
+                        return (unsigned char)c->label[0] < b;
+                    });
+                node->children.insert(at, move(leaf));
+                return next;
+            }
+
+            size_t common = 0;
+
+            while (common < next->label.size() && depth + common < name.size() &&
+                   next->label[common] == name[depth + common])
+            {
+                common++;
+            }
+
+            if (common < next->label.size())
+            {
+                // Split the edge: a new middle node takes over the shared bytes
+                auto middle = make_unique<Node>();
+                middle->label = next->label.substr(0, common);
+                middle->parent = node;
+                middle->best.store(next->best.load(memory_order_relaxed), memory_order_relaxed);
+
+                auto slot = find_if(node->children.begin(), node->children.end(),
+                    [&](const unique_ptr<Node>& c) { return c.get() == next; });
+                unique_ptr<Node> lower = move(*slot);
+                lower->label.erase(0, common);
+                lower->parent = middle.get();
+                middle->children.push_back(move(lower));
+                *slot = move(middle);
+                next = slot->get();
+            }
+
+            node = next;
+            depth += common;
+        }
+
+        return node;
+    }
+
+    // Take a place off its node. Subtree maxima above it may stay higher
+    // than what is left below; they are only bounds, so results stay right.
+    static void detach(Place* place)
+    {
+        vector<Place*>& here = place->node->places;
+        here.erase(std::find(here.begin(), here.end(), place));
+        place->node = nullptr;
+    }
+
+    // Node whose subtree holds exactly the names starting with prefix, or null
+    const Node* prefixNode(const string& prefix) const
+    {
+        const Node* node = &root;
+        size_t depth = 0;
+
+        while (depth < prefix.size())
+        {
+            node = child(node, prefix[depth]);
+
+            if (!node)
+            {
+                return nullptr;
+            }
+
+            size_t n = min(node->label.size(), prefix.size() - depth);
+
+            if (node->label.compare(0, n, prefix, depth, n) != 0)
+            {
+                return nullptr;
+            }
+            depth += n;
+        }
+
+        return node;
+    }
+
+public:
+
+    // Bind value to name; a value that had another name moves and keeps
+    // its score
+    void insert(const string& name, uint32_t value)
+    {
+        unique_ptr<Place>& place = places[value];
+
+        if (!place)
+        {
+            place = make_unique<Place>();
+            place->value = value;
+        }
+        else
+        {
+            detach(place.get());
+        }
+
+        Node* node = nodeFor(name);
+        place->node = node;
+        node->places.push_back(place.get());
+        raise(node, place->score.load(memory_order_relaxed));
+    }
+
+    // Forget value and its score
+    bool remove(uint32_t value)
+    {
+        auto it = places.find(value);
+
+        if (it == places.end())
+        {
+            return false;
+        }
+
+        detach(it->second.get());
+        places.erase(it);
+        return true;
+    }
+
+    // Add to value's score; safe alongside other bump() and topK() calls
+    void bump(uint32_t value, uint64_t by = 1)
+    {
+        auto it = places.find(value);
+
+        if (it == places.end())
+        {
+            return;
+        }
+
+        Place* place = it->second.get();
+        uint64_t score = place->score.fetch_add(by, memory_order_relaxed) + by;
+        raise(place->node, score);
+    }
+
+    uint64_t score(uint32_t value) const
+    {
+        auto it = places.find(value);
+        return it == places.end() ? 0 : it->second->score.load(memory_order_relaxed);
+    }
+
+    // Up to k (value, score) pairs for names starting with prefix, highest
+    // score first
+    vector<pair<uint32_t, uint64_t>> topK(const string& prefix, size_t k) const
+    {
+        vector<pair<uint32_t, uint64_t>> result;
+        const Node* start = prefixNode(prefix);
+
+        if (!start || k == 0)
+        {
+            return result;
+        }
+
+        // A queue item is either a subtree (keyed by its maximum) or a place
+        struct Item
+        {
+            uint64_t key;
+            const Node* node;
+            uint32_t value;
+
+            bool operator<(const Item& other) const
+            {
+                return key < other.key;
+            }
+        };
+
+        priority_queue<Item> queue;
+        queue.push({start->best.load(memory_order_relaxed), start, 0});
+
+        while (!queue.empty() && result.size() < k)
+        {
+            Item item = queue.top();
+            queue.pop();
+
+            if (!item.node)
+            {
+                result.push_back({item.value, item.key});
+                continue;
+            }
+
+            for (const Place* place : item.node->places)
+            {
+                queue.push({place->score.load(memory_order_relaxed), nullptr, place->value});
+            }
+
+            for (const auto& c : item.node->children)
+            {
+                queue.push({c->best.load(memory_order_relaxed), c.get(), 0});
+            }
+        }
+
+        return result;
+    }
+
+    int size() const
+    {
+        return places.size();
+    }
+};
+
+#endif
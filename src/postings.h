@@ -0,0 +1,62 @@
+#ifndef POSTINGS_H
+#define POSTINGS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+using namespace std;
+
+// Helpers for posting lists kept as blocks of ascending doc IDs with the
+// last doc of every block aside (FuzzyIndex, TokenIndex).
+
+// First position in docs[from..count) holding a value >= doc
+inline int lowerBound(const uint32_t* docs, int from, int count, uint32_t doc)
+{
+#ifdef __SSE2__
+    // Doc IDs stay below 2^31, so a signed compare is fine
+    __m128i key = _mm_set1_epi32((int)doc);
+
+    while (from + 4 <= count)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(docs + from));
+        int less = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(v, key)));
+
+        if (less != 0xf)
+        {
+            return from + __builtin_ctz(~less);
+        }
+        from += 4;
+    }
+#endif
+    while (from < count && docs[from] < doc)
+    {
+        from++;
+    }
+    return from;
+}
+
+// First block from `current` on whose last doc is >= doc (lastDoc.size()
+// if none): doubling steps over the block ends, then a binary search
+// inside the last step
+inline size_t gallop(const vector<uint32_t>& lastDoc, size_t current, uint32_t doc)
+{
+    if (current >= lastDoc.size() || lastDoc[current] >= doc)
+    {
+        return current;
+    }
+
+    size_t step = 1;
+
+    while (current + step < lastDoc.size() && lastDoc[current + step] < doc)
+    {
+        step *= 2;
+    }
+
+    return lower_bound(lastDoc.begin() + current + step / 2,
+                       lastDoc.begin() + min(current + step, lastDoc.size()), doc) - lastDoc.begin();
+}
+
+#endif
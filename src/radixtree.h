@@ -0,0 +1,895 @@
+#ifndef RADIXTREE_H
+#define RADIXTREE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+using namespace std;
+
+// Adaptive radix tree (Leis et al.) from names to lists of 32-bit values,
+// for type-ahead.
+//
+// Inner nodes branch on one byte and come in four sizes (4, 16, 48 and 256
+// children), growing as children are added. Each inner node stores the
+// bytes all keys below it share (path compression) and may hold a
+// "terminal" leaf for the key that ends exactly there. Single keys hang off
+// as leaves without any chain of one-child nodes (lazy expansion). A prefix
+// query walks at most one node per prefix byte and then enumerates the
+// subtree in byte order, i.e. in the same order as std::string comparison.
+class AdaptiveRadixTree
+{
+
+private:
+    enum NodeType : uint8_t { NODE4, NODE16, NODE48, NODE256 };
+
+    struct Leaf
+    {
+        string key;
+        vector<uint32_t> values;
+    };
+
+    struct Node
+    {
+        NodeType type;
+        uint16_t count = 0;
+        string prefix;               // bytes shared by every key below
+        Leaf* terminal = nullptr;    // key ending right after prefix
+
+        explicit Node(NodeType t) : type(t) {}
+    };
+
+    // A child is a Node* or a Leaf*, told apart by the low pointer bit
+    typedef uintptr_t Ref;
+
+    struct Node4 : Node
+    {
+        uint8_t keys[4];
+        Ref children[4];
+        Node4() : Node(NODE4) {}
+    };
+
+    struct Node16 : Node
+    {
+        uint8_t keys[16];
+        Ref children[16];
+        Node16() : Node(NODE16) {}
+    };
+
+    struct Node48 : Node
+    {
+        uint8_t index[256];          // byte -> slot + 1, 0 when absent
+        Ref children[48];
+        Node48() : Node(NODE48) { memset(index, 0, sizeof(index)); }
+    };
+
+    struct Node256 : Node
+    {
+        Ref children[256];
+        Node256() : Node(NODE256) { memset(children, 0, sizeof(children)); }
+    };
+
+    Ref root = 0;
+    int keyCount = 0;
+
+    static bool isLeaf(Ref r)
+    {
+        return r & 1;
+    }
+
+    static Leaf* asLeaf(Ref r)
+    {
+        return (Leaf*)(r & ~(uintptr_t)1);
+    }
+
+    static Node* asNode(Ref r)
+    {
+        return (Node*)r;
+    }
+
+    static Ref leafRef(Leaf* leaf)
+    {
+        return (uintptr_t)leaf | 1;
+    }
+
+    Ref newLeaf(string_view key, uint32_t value)
+    {
+        keyCount++;
+        return leafRef(new Leaf{string(key), {value}});
+    }
+
+    static Ref* findChild(Node* node, uint8_t byte)
+    {
+        switch (node->type)
+        {
+            case NODE4:
+            {
+                Node4* n = (Node4*)node;
+
+                for (int i = 0; i < n->count; i++)
+                {
+                    if (n->keys[i] == byte)
+                    {
+                        return &n->children[i];
+                    }
+                }
+                return nullptr;
+            }
+
+            case NODE16:
+            {
+                Node16* n = (Node16*)node;
+#ifdef __SSE2__
+                __m128i keys = _mm_loadu_si128((const __m128i*)n->keys);
+                int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(keys, _mm_set1_epi8((char)byte)));
+                mask &= (1 << n->count) - 1;
+                return mask ? &n->children[__builtin_ctz(mask)] : nullptr;
+#else
+                for (int i = 0; i < n->count; i++)
+                {
+                    if (n->keys[i] == byte)
+                    {
+                        return &n->children[i];
+                    }
+                }
+                return nullptr;
+#endif
+            }
+
+            case NODE48:
+            {
+                Node48* n = (Node48*)node;
+                return n->index[byte] ? &n->children[n->index[byte] - 1] : nullptr;
+            }
+
+            default:
+            {
+                Node256* n = (Node256*)node;
+                return n->children[byte] ? &n->children[byte] : nullptr;
+            }
+        }
+    }
+
+    template <typename Small>
+    static void insertSorted(Small* n, uint8_t byte, Ref child)
+    {
+        int i = 0;
+
+        while (i < n->count && n->keys[i] < byte)
+        {
+            i++;
+        }
+
+        memmove(n->keys + i + 1, n->keys + i, n->count - i);
+        memmove(n->children + i + 1, n->children + i, (n->count - i) * sizeof(Ref));
+        n->keys[i] = byte;
+        n->children[i] = child;
+        n->count++;
+    }
+
+    static void copyHeader(Node* to, Node* from)
+    {
+        to->count = from->count;
+        to->prefix = move(from->prefix);
+        to->terminal = from->terminal;
+    }
+
+    // Add a child, replacing the node by the next size up when it is full
+    static void addChild(Ref& ref, uint8_t byte, Ref child)
+    {
+        Node* node = asNode(ref);
+
+        switch (node->type)
+        {
+            case NODE4:
+            {
+                Node4* n = (Node4*)node;
+
+                if (n->count < 4)
+                {
+                    insertSorted(n, byte, child);
+                    return;
+                }
+
+                Node16* bigger = new Node16();
+                copyHeader(bigger, n);
+                memcpy(bigger->keys, n->keys, 4);
+                memcpy(bigger->children, n->children, 4 * sizeof(Ref));
+                delete n;
+                ref = (Ref)bigger;
+                insertSorted(bigger, byte, child);
+                return;
+            }
+
+            case NODE16:
+            {
+                Node16* n = (Node16*)node;
+
+                if (n->count < 16)
+                {
+                    insertSorted(n, byte, child);
+                    return;
+                }
+
+                Node48* bigger = new Node48();
+                copyHeader(bigger, n);
+
+                for (int i = 0; i < 16; i++)
+                {
+                    bigger->index[n->keys[i]] = i + 1;
+                    bigger->children[i] = n->children[i];
+                }
+                delete n;
+                ref = (Ref)bigger;
+                addChild(ref, byte, child);
+                return;
+            }
+
+            case NODE48:
+            {
+                Node48* n = (Node48*)node;
+
+                if (n->count < 48)
+                {
+                    n->children[n->count] = child;
+                    n->index[byte] = ++n->count;
+                    return;
+                }
+
+                Node256* bigger = new Node256();
+                copyHeader(bigger, n);
+
+                for (int b = 0; b < 256; b++)
+                {
+                    if (n->index[b])
+                    {
+                        bigger->children[b] = n->children[n->index[b] - 1];
+                    }
+                }
+                delete n;
+                ref = (Ref)bigger;
+                addChild(ref, byte, child);
+                return;
+            }
+
+            default:
+            {
+                Node256* n = (Node256*)node;
+                n->children[byte] = child;
+                n->count++;
+                return;
+            }
+        }
+    }
+
+    // Call visit(byte, child) for every child in byte order
+    template <typename Visit>
+    static void forEachChild(const Node* node, const Visit& visit)
+    {
+        switch (node->type)
+        {
+            case NODE4:
+            {
+                const Node4* n = (const Node4*)node;
+                for (int i = 0; i < n->count; i++)
+                {
+                    if (!visit(n->keys[i], n->children[i])) return;
+                }
+                return;
+            }
+
+            case NODE16:
+            {
+                const Node16* n = (const Node16*)node;
+                for (int i = 0; i < n->count; i++)
+                {
+                    if (!visit(n->keys[i], n->children[i])) return;
+                }
+                return;
+            }
+
+            case NODE48:
+            {
+                const Node48* n = (const Node48*)node;
+                for (int b = 0; b < 256; b++)
+                {
+                    if (n->index[b] && !visit((uint8_t)b, n->children[n->index[b] - 1])) return;
+                }
+                return;
+            }
+
+            default:
+            {
+                const Node256* n = (const Node256*)node;
+                for (int b = 0; b < 256; b++)
+                {
+                    if (n->children[b] && !visit((uint8_t)b, n->children[b])) return;
+                }
+                return;
+            }
+        }
+    }
+
+    // Place a leaf under node at byte position `at` of its key
+    static void placeLeaf(Ref& nodeRef, Ref leaf, size_t at)
+    {
+        const string& key = asLeaf(leaf)->key;
+
+        if (key.size() == at)
+        {
+            asNode(nodeRef)->terminal = asLeaf(leaf);
+        }
+        else
+        {
+            addChild(nodeRef, (uint8_t)key[at], leaf);
+        }
+    }
+
+    void insertAt(Ref& ref, string_view key, size_t depth, uint32_t value)
+    {
+        if (!ref)
+        {
+            ref = newLeaf(key, value);
+            return;
+        }
+
+        if (isLeaf(ref))
+        {
+            Leaf* leaf = asLeaf(ref);
+
+            if (leaf->key == key)
+            {
+                addValue(leaf, value);
+                return;
+            }
+
+            // Two keys in one slot: a new node for the bytes they share
+            size_t common = 0;
+
+            while (depth + common < key.size() && depth + common < leaf->key.size() &&
+                   key[depth + common] == leaf->key[depth + common])
+            {
+                common++;
+            }
+
+            Ref node = (Ref)new Node4();
+            asNode(node)->prefix = string(key.substr(depth, common));
+            placeLeaf(node, ref, depth + common);
+            placeLeaf(node, newLeaf(key, value), depth + common);
+            ref = node;
+            return;
+        }
+
+        Node* node = asNode(ref);
+        size_t matched = 0;
+
+        while (matched < node->prefix.size() && depth + matched < key.size() &&
+               node->prefix[matched] == key[depth + matched])
+        {
+            matched++;
+        }
+
+        if (matched < node->prefix.size())
+        {
+            // Key leaves the compressed path: split it
+            Ref parent = (Ref)new Node4();
+            asNode(parent)->prefix = node->prefix.substr(0, matched);
+            uint8_t byte = node->prefix[matched];
+            node->prefix.erase(0, matched + 1);
+            addChild(parent, byte, ref);
+            placeLeaf(parent, newLeaf(key, value), depth + matched);
+            ref = parent;
+            return;
+        }
+
+        depth += matched;
+
+        if (depth == key.size())
+        {
+            if (node->terminal)
+            {
+                addValue(node->terminal, value);
+            }
+            else
+            {
+                node->terminal = asLeaf(newLeaf(key, value));
+            }
+            return;
+        }
+
+        Ref* child = findChild(node, (uint8_t)key[depth]);
+
+        if (child)
+        {
+            insertAt(*child, key, depth + 1, value);
+        }
+        else
+        {
+            addChild(ref, (uint8_t)key[depth], newLeaf(key, value));
+        }
+    }
+
+    static void addValue(Leaf* leaf, uint32_t value)
+    {
+        if (std::find(leaf->values.begin(), leaf->values.end(), value) == leaf->values.end())
+        {
+            leaf->values.push_back(value);
+        }
+    }
+
+    // In-order walk below ref, skipping keys <= after while `bounded` (the
+    // path so far equals after's first `depth` bytes). visit returns false to stop.
+    template <typename Visit>
+    static bool walk(Ref ref, size_t depth, const string& after, bool bounded, const Visit& visit)
+    {
+        if (isLeaf(ref))
+        {
+            const Leaf* leaf = asLeaf(ref);
+
+            if (bounded && leaf->key <= after)
+            {
+                return true;
+            }
+            return visit(leaf->key, leaf->values);
+        }
+
+        const Node* node = asNode(ref);
+
+        if (bounded)
+        {
+            int c = string_view(node->prefix).compare(string_view(after).substr(min(depth, after.size()), node->prefix.size()));
+
+            if (c < 0)
+            {
+                return true;     // whole subtree sorts before the cursor
+            }
+            bounded = c == 0;
+        }
+
+        depth += node->prefix.size();
+
+        if (node->terminal && !(bounded && node->terminal->key <= after))
+        {
+            if (!visit(node->terminal->key, node->terminal->values))
+            {
+                return false;
+            }
+        }
+
+        bool keepGoing = true;
+
+        forEachChild(node, [&](uint8_t byte, Ref child)
+        {
+            bool childBounded = false;
+
+            // Past the end of the cursor every longer key sorts after it
+            if (bounded && depth < after.size())
+            {
+                if (byte < (uint8_t)after[depth])
+                {
+                    return true;
+                }
+                childBounded = byte == (uint8_t)after[depth];
+            }
+
+            keepGoing = walk(child, depth + 1, after, childBounded, visit);
+            return keepGoing;
+        });
+
+        return keepGoing;
+    }
+
+    template <typename Small>
+    static void removeSorted(Small* n, uint8_t byte)
+    {
+        int i = 0;
+
+        while (n->keys[i] != byte)
+        {
+            i++;
+        }
+
+        memmove(n->keys + i, n->keys + i + 1, n->count - i - 1);
+        memmove(n->children + i, n->children + i + 1, (n->count - i - 1) * sizeof(Ref));
+        n->count--;
+    }
+
+    static void deleteNode(Node* node)
+    {
+        switch (node->type)
+        {
+            case NODE4: delete (Node4*)node; break;
+            case NODE16: delete (Node16*)node; break;
+            case NODE48: delete (Node48*)node; break;
+            default: delete (Node256*)node; break;
+        }
+    }
+
+    // Drop a child, replacing the node by the next size down once it is
+    // well under that size's capacity (so it does not flip back and forth)
+    static void removeChild(Ref& ref, uint8_t byte)
+    {
+        Node* node = asNode(ref);
+
+        switch (node->type)
+        {
+            case NODE4:
+                removeSorted((Node4*)node, byte);
+                return;
+
+            case NODE16:
+            {
+                Node16* n = (Node16*)node;
+                removeSorted(n, byte);
+
+                if (n->count <= 3)
+                {
+                    Node4* smaller = new Node4();
+                    copyHeader(smaller, n);
+                    memcpy(smaller->keys, n->keys, n->count);
+                    memcpy(smaller->children, n->children, n->count * sizeof(Ref));
+                    delete n;
+                    ref = (Ref)smaller;
+                }
+                return;
+            }
+
+            case NODE48:
+            {
+                Node48* n = (Node48*)node;
+                int slot = n->index[byte] - 1;
+                int last = n->count - 1;
+
+                // Move the last slot into the hole so slots stay packed
+                if (slot != last)
+                {
+                    for (int b = 0; b < 256; b++)
+                    {
+                        if (n->index[b] == last + 1)
+                        {
+                            n->index[b] = slot + 1;
+                            break;
+                        }
+                    }
+                    n->children[slot] = n->children[last];
+                }
+                n->index[byte] = 0;
+                n->count--;
+
+                if (n->count <= 12)
+                {
+                    Node16* smaller = new Node16();
+                    copyHeader(smaller, n);
+                    smaller->count = 0;
+
+                    for (int b = 0; b < 256; b++)
+                    {
+                        if (n->index[b])
+                        {
+                            smaller->keys[smaller->count] = (uint8_t)b;
+                            smaller->children[smaller->count++] = n->children[n->index[b] - 1];
+                        }
+                    }
+                    delete n;
+                    ref = (Ref)smaller;
+                }
+                return;
+            }
+
+            default:
+            {
+                Node256* n = (Node256*)node;
+                n->children[byte] = 0;
+                n->count--;
+
+                if (n->count <= 36)
+                {
+                    Node48* smaller = new Node48();
+                    copyHeader(smaller, n);
+                    smaller->count = 0;
+
+                    for (int b = 0; b < 256; b++)
+                    {
+                        if (n->children[b])
+                        {
+                            smaller->children[smaller->count] = n->children[b];
+                            smaller->index[b] = ++smaller->count;
+                        }
+                    }
+                    delete n;
+                    ref = (Ref)smaller;
+                }
+                return;
+            }
+        }
+    }
+
+    // A node left with one key below it is replaced by that key: a lone
+    // terminal becomes a plain leaf, a lone child node takes over the
+    // node's prefix and branch byte
+    static void collapse(Ref& ref)
+    {
+        Node* node = asNode(ref);
+
+        if (node->count == 0)
+        {
+            ref = node->terminal ? leafRef(node->terminal) : 0;
+            deleteNode(node);
+            return;
+        }
+
+        if (node->count == 1 && !node->terminal)
+        {
+            uint8_t byte = 0;
+            Ref child = 0;
+
+            forEachChild(node, [&](uint8_t b, Ref c)
+            {
+                byte = b;
+                child = c;
+                return false;
+            });
+
+            if (!isLeaf(child))
+            {
+                asNode(child)->prefix = node->prefix + (char)byte + asNode(child)->prefix;
+            }
+            ref = child;
+            deleteNode(node);
+        }
+    }
+
+    // Take value off key's list below ref; a key left without values is
+    // deleted and the nodes above it pruned or shrunk
+    bool removeAt(Ref& ref, string_view key, size_t depth, uint32_t value)
+    {
+        if (!ref)
+        {
+            return false;
+        }
+
+        if (isLeaf(ref))
+        {
+            Leaf* leaf = asLeaf(ref);
+
+            if (leaf->key != key || !takeValue(leaf, value))
+            {
+                return false;
+            }
+            if (leaf->values.empty())
+            {
+                delete leaf;
+                keyCount--;
+                ref = 0;
+            }
+            return true;
+        }
+
+        Node* node = asNode(ref);
+
+        if (key.substr(depth, node->prefix.size()) != node->prefix)
+        {
+            return false;
+        }
+
+        depth += node->prefix.size();
+
+        if (depth == key.size())
+        {
+            if (!node->terminal || !takeValue(node->terminal, value))
+            {
+                return false;
+            }
+            if (node->terminal->values.empty())
+            {
+                delete node->terminal;
+                node->terminal = nullptr;
+                keyCount--;
+                collapse(ref);
+            }
+            return true;
+        }
+
+        uint8_t byte = (uint8_t)key[depth];
+        Ref* child = findChild(node, byte);
+
+        if (!child || !removeAt(*child, key, depth + 1, value))
+        {
+            return false;
+        }
+        if (!*child)
+        {
+            removeChild(ref, byte);
+            collapse(ref);
+        }
+        return true;
+    }
+
+    static bool takeValue(Leaf* leaf, uint32_t value)
+    {
+        auto it = std::find(leaf->values.begin(), leaf->values.end(), value);
+
+        if (it == leaf->values.end())
+        {
+            return false;
+        }
+        leaf->values.erase(it);
+        return true;
+    }
+
+    static void destroy(Ref ref)
+    {
+        if (!ref)
+        {
+            return;
+        }
+
+        if (isLeaf(ref))
+        {
+            delete asLeaf(ref);
+            return;
+        }
+
+        Node* node = asNode(ref);
+        delete node->terminal;
+
+        forEachChild(node, [](uint8_t, Ref child)
+        {
+            destroy(child);
+            return true;
+        });
+
+        deleteNode(node);
+    }
+
+    static size_t footprint(Ref ref)
+    {
+        if (isLeaf(ref))
+        {
+            const Leaf* leaf = asLeaf(ref);
+            return sizeof(Leaf) + (leaf->key.size() > 15 ? leaf->key.capacity() + 1 : 0) +
+                   leaf->values.capacity() * sizeof(uint32_t);
+        }
+
+        const Node* node = asNode(ref);
+        static const size_t sizes[] = {sizeof(Node4), sizeof(Node16), sizeof(Node48), sizeof(Node256)};
+        size_t bytes = sizes[node->type] + (node->prefix.size() > 15 ? node->prefix.capacity() + 1 : 0);
+
+        if (node->terminal)
+        {
+            bytes += footprint(leafRef(node->terminal));
+        }
+
+        forEachChild(node, [&](uint8_t, Ref child)
+        {
+            bytes += footprint(child);
+            return true;
+        });
+        return bytes;
+    }
+
+    Leaf* findLeaf(string_view key) const
+    {
+        Ref ref = root;
+        size_t depth = 0;
+
+        while (ref)
+        {
+            if (isLeaf(ref))
+            {
+                return asLeaf(ref)->key == key ? asLeaf(ref) : nullptr;
+            }
+
+            Node* node = asNode(ref);
+
+            if (key.substr(depth, node->prefix.size()) != node->prefix)
+            {
+                return nullptr;
+            }
+
+            depth += node->prefix.size();
+
+            if (depth == key.size())
+            {
+                return node->terminal;
+            }
+
+            Ref* child = findChild(node, (uint8_t)key[depth]);
+            ref = child ? *child : 0;
+            depth++;
+        }
+        return nullptr;
+    }
+
+public:
+    AdaptiveRadixTree() = default;
+    AdaptiveRadixTree(const AdaptiveRadixTree&) = delete;
+    AdaptiveRadixTree& operator=(const AdaptiveRadixTree&) = delete;
+
+    ~AdaptiveRadixTree()
+    {
+        destroy(root);
+    }
+
+    // Add value to the key's list (once)
+    void insert(string_view key, uint32_t value)
+    {
+        insertAt(root, key, 0, value);
+    }
+
+    // Take value off the key's list; a key left without values is deleted
+    bool remove(string_view key, uint32_t value)
+    {
+        return removeAt(root, key, 0, value);
+    }
+
+    const vector<uint32_t>* find(string_view key) const
+    {
+        Leaf* leaf = findLeaf(key);
+        return leaf ? &leaf->values : nullptr;
+    }
+
+    // Keys starting with prefix and sorting after `after` (empty: from the
+    // start), in order; visit(key, values) returns false to stop
+    template <typename Visit>
+    void complete(string_view prefix, const string& after, const Visit& visit) const
+    {
+        Ref ref = root;
+        size_t depth = 0;
+
+        // Descend along the prefix
+        while (ref && !isLeaf(ref))
+        {
+            Node* node = asNode(ref);
+            size_t remaining = prefix.size() - depth;
+            size_t n = min(remaining, node->prefix.size());
+
+            if (prefix.substr(depth, n) != string_view(node->prefix).substr(0, n))
+            {
+                return;
+            }
+
+            if (remaining <= node->prefix.size())
+            {
+                break;     // prefix ends inside this node: all of it matches
+            }
+
+            depth += node->prefix.size();
+            Ref* child = findChild(node, (uint8_t)prefix[depth]);
+            ref = child ? *child : 0;
+            depth++;
+        }
+
+        if (!ref || (isLeaf(ref) && asLeaf(ref)->key.compare(0, prefix.size(), prefix) != 0))
+        {
+            return;
+        }
+
+        // Bounded walk only matters while the cursor shares the path so far
+        bool bounded = !after.empty() && after.compare(0, depth, prefix.substr(0, depth)) == 0;
+
+        if (!after.empty() && !bounded && after.compare(0, depth, prefix.substr(0, depth)) > 0)
+        {
+            return;        // cursor is past every key under this prefix
+        }
+
+        walk(ref, depth, after, bounded, visit);
+    }
+
+    int size() const
+    {
+        return keyCount;
+    }
+
+    size_t memoryBytes() const
+    {
+        return root ? footprint(root) : 0;
+    }
+};
+
+#endif
@@ -0,0 +1,355 @@
+#ifndef SEGMENTINDEX_H
+#define SEGMENTINDEX_H
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <vector>
+#include "geo.h"
+#include "graph.h"
+using namespace std;
+
+// A point on a road, as found by SegmentIndex
+struct SnapPoint
+{
+    int from;            // dense node indices of the road's endpoints
+    int to;
+    double fraction;     // position along the road, 0 at from, 1 at to
+    double lat;          // snapped position
+    double lng;
+    double distanceKm;   // from the query point
+};
+
+// Packed R-tree over road segments (straight lines between the endpoint
+// junctions), bulk-loaded with Sort-Tile-Recursive. Level 0 holds one box
+// per segment; every higher level groups NODE_SIZE consecutive boxes of the
+// level below, so children are found by index arithmetic alone.
+class SegmentIndex
+{
+
+private:
+    struct Box
+    {
+        float minX, minY, maxX, maxY;
+    };
+
+    struct Segment
+    {
+        int from;
+        int to;
+        float x1, y1, x2, y2;
+    };
+
+    static const int NODE_SIZE = 16;
+
+    LocalProjection projection;
+    vector<Segment> segments;       // STR order, parallel to levels[0]
+    vector<vector<Box>> levels;     // levels.back() is the root level
+
+    static float boxDistance2(const Box& b, float x, float y)
+    {
+        float dx = max(max(b.minX - x, 0.0f), x - b.maxX);
+        float dy = max(max(b.minY - y, 0.0f), y - b.maxY);
+        return dx * dx + dy * dy;
+    }
+
+    // Squared distance to the segment; t receives the closest position on it
+    static float segmentDistance2(const Segment& s, float x, float y, float& t)
+    {
+        float vx = s.x2 - s.x1;
+        float vy = s.y2 - s.y1;
+        float length2 = vx * vx + vy * vy;
+
+        t = length2 > 0 ? ((x - s.x1) * vx + (y - s.y1) * vy) / length2 : 0;
+        t = min(1.0f, max(0.0f, t));
+
+        float dx = s.x1 + t * vx - x;
+        float dy = s.y1 + t * vy - y;
+        return dx * dx + dy * dy;
+    }
+
+    SnapPoint makeSnap(int index, float t, float distance2) const
+    {
+        const Segment& s = segments[index];
+        float x = s.x1 + t * (s.x2 - s.x1);
+        float y = s.y1 + t * (s.y2 - s.y1);
+
+        return {s.from, s.to, t, y / projection.kmPerDegLat, x / projection.kmPerDegLng, sqrt((double)distance2)};
+    }
+
+    template <typename Visit>
+    void visitBox(int level, int index, const Box& query, const Visit& visit) const
+    {
+        const Box& b = levels[level][index];
+
+        if (b.maxX < query.minX || b.minX > query.maxX || b.maxY < query.minY || b.minY > query.maxY)
+        {
+            return;
+        }
+
+        if (level == 0)
+        {
+            visit(index);
+            return;
+        }
+
+        int end = min((int)levels[level - 1].size(), (index + 1) * NODE_SIZE);
+
+        for (int child = index * NODE_SIZE; child < end; child++)
+        {
+            visitBox(level - 1, child, query, visit);
+        }
+    }
+
+public:
+
+    // One segment per road (the u < v direction of each edge pair)
+    void build(const Graph& graph)
+    {
+        double latSum = 0;
+
+        for (int v = 0; v < graph.nodeCount(); v++)
+        {
+            latSum += graph.latitude(v);
+        }
+
+        projection = LocalProjection(graph.nodeCount() ? latSum / graph.nodeCount() : 0);
+        segments.clear();
+        levels.clear();
+
+        for (int u = 0; u < graph.nodeCount(); u++)
+        {
+            for (const auto& edge : graph.edges(u))
+            {
+                if (u < edge.to)
+                {
+                    segments.push_back({u, edge.to,
+                        (float)projection.x(graph.longitude(u)), (float)projection.y(graph.latitude(u)),
+                        (float)projection.x(graph.longitude(edge.to)), (float)projection.y(graph.latitude(edge.to))});
+                }
+            }
+        }
+
+        // STR: vertical slices by centre x, each slice sorted by centre y
+        size_t n = segments.size();
+        size_t leaves = (n + NODE_SIZE - 1) / NODE_SIZE;
+        size_t slices = (size_t)ceil(sqrt((double)leaves));
+        size_t sliceSize = slices * NODE_SIZE;
+
+        sort(segments.begin(), segments.end(), [](const Segment& a, const Segment& b)
+        {
+            return a.x1 + a.x2 < b.x1 + b.x2;
+        });
+
+        for (size_t begin = 0; begin < n; begin += sliceSize)
+        {
+            sort(segments.begin() + begin, segments.begin() + min(n, begin + sliceSize),
+                [](const Segment& a, const Segment& b)
+                {
+                    return a.y1 + a.y2 < b.y1 + b.y2;
+                });
+        }
+
+        levels.emplace_back();
+
+        for (const auto& s : segments)
+        {
+            levels[0].push_back({min(s.x1, s.x2), min(s.y1, s.y2), max(s.x1, s.x2), max(s.y1, s.y2)});
+        }
+
+        while (levels.back().size() > 1)
+        {
+            const vector<Box> below = levels.back();
+            vector<Box> above;
+
+            for (size_t begin = 0; begin < below.size(); begin += NODE_SIZE)
+            {
+                Box b = below[begin];
+
+                for (size_t i = begin + 1; i < min(below.size(), begin + NODE_SIZE); i++)
+                {
+                    b.minX = min(b.minX, below[i].minX);
+                    b.minY = min(b.minY, below[i].minY);
+                    b.maxX = max(b.maxX, below[i].maxX);
+                    b.maxY = max(b.maxY, below[i].maxY);
+                }
+                above.push_back(b);
+            }
+            levels.push_back(above);
+        }
+    }
+
+    // Closest point on any road within maxKm. Best-first over the tree: the
+    // first segment popped from the queue is the nearest one.
+    bool nearest(double lat, double lng, double maxKm, SnapPoint& out) const
+    {
+        if (segments.empty())
+        {
+            return false;
+        }
+
+        float x = projection.x(lng);
+        float y = projection.y(lat);
+        float limit = maxKm * maxKm;
+
+        // (squared distance, level, index); level -1 is an exact segment distance
+        struct Entry
+        {
+            float distance2;
+            int level;
+            int index;
+            float t;
+
+            bool operator>(const Entry& other) const
+            {
+                return distance2 > other.distance2;
+            }
+        };
+
+        priority_queue<Entry, vector<Entry>, greater<Entry>> queue;
+        int top = levels.size() - 1;
+        queue.push({boxDistance2(levels[top][0], x, y), top, 0, 0});
+
+        while (!queue.empty())
+        {
+            Entry e = queue.top();
+            queue.pop();
+
+            if (e.distance2 > limit)
+            {
+                return false;
+            }
+
+            if (e.level == -1)
+            {
+                out = makeSnap(e.index, e.t, e.distance2);
+                return true;
+            }
+
+            if (e.level == 0)
+            {
+                float t;
+                float d = segmentDistance2(segments[e.index], x, y, t);
+                queue.push({d, -1, e.index, t});
+                continue;
+            }
+
+            int end = min((int)levels[e.level - 1].size(), (e.index + 1) * NODE_SIZE);
+
+            for (int child = e.index * NODE_SIZE; child < end; child++)
+            {
+                float d = boxDistance2(levels[e.level - 1][child], x, y);
+
+                if (d <= limit)
+                {
+                    queue.push({d, e.level - 1, child, 0});
+                }
+            }
+        }
+
+        return false;
+    }
+
+    // Closest point on every road within radiusKm, nearest first
+    vector<SnapPoint> withinRadius(double lat, double lng, double radiusKm) const
+    {
+        vector<SnapPoint> hits;
+
+        if (segments.empty())
+        {
+            return hits;
+        }
+
+        float x = projection.x(lng);
+        float y = projection.y(lat);
+        float r = radiusKm;
+        float limit = r * r;
+
+        visitBox(levels.size() - 1, 0, {x - r, y - r, x + r, y + r}, [&](int index)
+        {
+            float t;
+            float d = segmentDistance2(segments[index], x, y, t);
+
+            if (d <= limit)
+            {
+                hits.push_back(makeSnap(index, t, d));
+            }
+        });
+
+        sort(hits.begin(), hits.end(), [](const SnapPoint& a, const SnapPoint& b)
+        {
+            return a.distanceKm < b.distanceKm;
+        });
+        return hits;
+    }
+
+    // Roads whose bounding box meets a lat/lng box, as (from, to) dense indices
+    vector<pair<int, int>> inBox(double minLat, double minLng, double maxLat, double maxLng) const
+    {
+        vector<pair<int, int>> found;
+
+        if (segments.empty())
+        {
+            return found;
+        }
+
+        Box query = {(float)projection.x(minLng), (float)projection.y(minLat),
+                     (float)projection.x(maxLng), (float)projection.y(maxLat)};
+
+        visitBox(levels.size() - 1, 0, query, [&](int index)
+        {
+            found.push_back({segments[index].from, segments[index].to});
+        });
+        return found;
+    }
+
+    int size() const
+    {
+        return segments.size();
+    }
+};
+
+// Share of a road's travel time; a zero share costs nothing even if closed
+inline double proRated(double share, double time)
+{
+    return share <= 0 ? 0 : share * time;
+}
+
+// Seeds for routing out of / into a snapped point: the two road ends with
+// the pro-rated share of the road's current travel time in each direction.
+inline vector<pair<int, double>> departureSeeds(const Graph& graph, const SnapPoint& p)
+{
+    return {{p.to, proRated(1 - p.fraction, graph.edgeTime(p.from, p.to))},
+            {p.from, proRated(p.fraction, graph.edgeTime(p.to, p.from))}};
+}
+
+inline vector<pair<int, double>> arrivalSeeds(const Graph& graph, const SnapPoint& p)
+{
+    return {{p.from, proRated(p.fraction, graph.edgeTime(p.from, p.to))},
+            {p.to, proRated(1 - p.fraction, graph.edgeTime(p.to, p.from))}};
+}
+
+// Travel time straight along the road when both points lie on the same one;
+// infinity when they do not or the needed direction is closed.
+inline double sameRoadTime(const Graph& graph, const SnapPoint& a, const SnapPoint& b)
+{
+    double g;
+
+    if (a.from == b.from && a.to == b.to)
+    {
+        g = b.fraction;
+    }
+    else if (a.from == b.to && a.to == b.from)
+    {
+        g = 1 - b.fraction;
+    }
+    else
+    {
+        return numeric_limits<double>::infinity();
+    }
+
+    return g >= a.fraction ? proRated(g - a.fraction, graph.edgeTime(a.from, a.to))
+                           : proRated(a.fraction - g, graph.edgeTime(a.to, a.from));
+}
+
+#endif
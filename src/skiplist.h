@@ -0,0 +1,304 @@
+#ifndef SKIPLIST_H
+#define SKIPLIST_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string_view>
+#include "stringpool.h"
+using namespace std;
+
+// Name -> junction ID index for names that change while the server is
+// serving: a lock-free skip list (Herlihy, Lev, Luchangco & Shavit).
+//
+// Nodes are only ever linked in, never unlinked, so a reader just follows
+// atomic next pointers: find() and scans take no lock and never wait for
+// a writer. insert() links the new node at the bottom level with one CAS,
+// which is the moment it becomes visible, then links the levels above
+// (each a CAS, retried against whatever moved in meanwhile). A name's ID
+// is an atomic as well; erase() only sets it to NONE, and inserting the
+// name again reuses the node. Nodes live until the list is destroyed.
+//
+// Keys are views into a StringPool shared with the other holders of the
+// same names. Interning a new key takes the pool's lock; lookups, scans
+// and updates of a key already in the list do not.
+class ConcurrentSkipList
+{
+
+private:
+    static const int MAX_LEVEL = 24;
+
+    struct Node
+    {
+        string_view key;          // in pool
+        atomic<int> value;
+        int height;
+        atomic<Node*> next[1];    // `height` of them, allocated with the node
+    };
+
+    StringPool& pool;
+    Node* head;
+    atomic<int> liveCount{0};
+
+    static Node* makeNode(string_view key, int value, int height)
+    {
+        size_t bytes = sizeof(Node) + (height - 1) * sizeof(atomic<Node*>);
+        Node* node = (Node*)::operator new(bytes);
+
+        new (&node->key) string_view(key);
+        new (&node->value) atomic<int>(value);
+        node->height = height;
+
+        for (int i = 0; i < height; i++)
+        {
+            new (&node->next[i]) atomic<Node*>(nullptr);
+        }
+        return node;
+    }
+
+    static void freeNode(Node* node)
+    {
+        ::operator delete(node);
+    }
+
+    // Geometric heights, p = 1/4, from a per-thread xorshift
+    static int randomHeight()
+    {
+        thread_local uint64_t state = 0x9e3779b97f4a7c15ULL ^ (uint64_t)(uintptr_t)&state;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        int height = 1;
+        uint64_t bits = state;
+
+        while (height < MAX_LEVEL && (bits & 3) == 0)
+        {
+            height++;
+            bits >>= 2;
+        }
+        return height;
+    }
+
+    // Last node before key and the first at or after it, on every level
+    Node* locate(string_view key, Node** before, Node** after) const
+    {
+        Node* node = head;
+
+        for (int level = MAX_LEVEL - 1; level >= 0; level--)
+        {
+            Node* next = node->next[level].load(memory_order_acquire);
+
+            while (next && next->key < key)
+            {
+                node = next;
+                next = node->next[level].load(memory_order_acquire);
+            }
+
+            if (before)
+            {
+                before[level] = node;
+                after[level] = next;
+            }
+        }
+
+        Node* found = node->next[0].load(memory_order_acquire);
+        return found && found->key == key ? found : nullptr;
+    }
+
+    // First node with a key >= key
+    Node* lowerBound(string_view key) const
+    {
+        Node* node = head;
+
+        for (int level = MAX_LEVEL - 1; level >= 0; level--)
+        {
+            Node* next = node->next[level].load(memory_order_acquire);
+
+            while (next && next->key < key)
+            {
+                node = next;
+                next = node->next[level].load(memory_order_acquire);
+            }
+        }
+        return node->next[0].load(memory_order_acquire);
+    }
+
+    // Bind a live value to key; `replace` decides what happens to a live one
+    bool bind(string_view key, int value, bool replace)
+    {
+        Node* before[MAX_LEVEL];
+        Node* after[MAX_LEVEL];
+        Node* node = nullptr;
+
+        while (true)
+        {
+            Node* found = locate(key, before, after);
+
+            if (found)
+            {
+                if (node)
+                {
+                    freeNode(node);    // made for an attempt that lost to this key
+                }
+
+                int old = found->value.load(memory_order_acquire);
+
+                do
+                {
+                    if (old != NONE && !replace)
+                    {
+                        return false;
+                    }
+                } while (!found->value.compare_exchange_weak(old, value, memory_order_acq_rel));
+
+                if (old == NONE)
+                {
+                    liveCount.fetch_add(1, memory_order_relaxed);
+                }
+                return true;
+            }
+
+            if (!node)
+            {
+                node = makeNode(pool.view(pool.intern(key)), value, randomHeight());
+            }
+
+            node->next[0].store(after[0], memory_order_relaxed);
+
+            if (before[0]->next[0].compare_exchange_strong(after[0], node, memory_order_release))
+            {
+                break;    // visible from here on
+            }
+            // Someone linked a node next to ours first: look again, it may be key
+        }
+
+        liveCount.fetch_add(1, memory_order_relaxed);
+
+        for (int level = 1; level < node->height; level++)
+        {
+            while (true)
+            {
+                node->next[level].store(after[level], memory_order_relaxed);
+
+                if (before[level]->next[level].compare_exchange_strong(after[level], node, memory_order_release))
+                {
+                    break;
+                }
+                locate(key, before, after);
+            }
+        }
+        return true;
+    }
+
+public:
+    static const int NONE = -1;
+
+    explicit ConcurrentSkipList(StringPool& names) : pool(names), head(makeNode("", NONE, MAX_LEVEL)) {}
+
+    ~ConcurrentSkipList()
+    {
+        Node* node = head;
+
+        while (node)
+        {
+            Node* next = node->next[0].load(memory_order_relaxed);
+            freeNode(node);
+            node = next;
+        }
+    }
+
+    ConcurrentSkipList(const ConcurrentSkipList&) = delete;
+    ConcurrentSkipList& operator=(const ConcurrentSkipList&) = delete;
+
+    // Add key -> value unless key is already bound; false if it was.
+    // Of two racing inserts of the same key exactly one succeeds.
+    bool insert(string_view key, int value)
+    {
+        return bind(key, value, false);
+    }
+
+    // Bind key to value, replacing what was there
+    void assign(string_view key, int value)
+    {
+        bind(key, value, true);
+    }
+
+    // Unbind key if it is bound to value (any value if NONE)
+    bool erase(string_view key, int value = NONE)
+    {
+        Node* node = locate(key, nullptr, nullptr);
+
+        if (!node)
+        {
+            return false;
+        }
+
+        int old = node->value.load(memory_order_acquire);
+
+        do
+        {
+            if (old == NONE || (value != NONE && old != value))
+            {
+                return false;
+            }
+        } while (!node->value.compare_exchange_weak(old, NONE, memory_order_acq_rel));
+
+        liveCount.fetch_sub(1, memory_order_relaxed);
+        return true;
+    }
+
+    // Value bound to key, or NONE
+    int find(string_view key) const
+    {
+        Node* node = locate(key, nullptr, nullptr);
+        return node ? node->value.load(memory_order_acquire) : NONE;
+    }
+
+    // visit(key, value) for bound keys starting with prefix and sorting
+    // after `after` (a cursor, or empty), in order, until it returns false
+    template<typename Visit>
+    void scan(string_view prefix, string_view after, const Visit& visit) const
+    {
+        Node* node = lowerBound(after > prefix ? after : prefix);
+
+        for (; node; node = node->next[0].load(memory_order_acquire))
+        {
+            if (node->key.substr(0, prefix.size()) != prefix)
+            {
+                return;
+            }
+
+            int value = node->value.load(memory_order_acquire);
+
+            if (value != NONE && node->key != after && !visit(node->key, value))
+            {
+                return;
+            }
+        }
+    }
+
+    // visit(key, value) for bound keys in [low, high), in order, until it
+    // returns false
+    template<typename Visit>
+    void range(string_view low, string_view high, const Visit& visit) const
+    {
+        for (Node* node = lowerBound(low); node && node->key < high; node = node->next[0].load(memory_order_acquire))
+        {
+            int value = node->value.load(memory_order_acquire);
+
+            if (value != NONE && !visit(node->key, value))
+            {
+                return;
+            }
+        }
+    }
+
+    int size() const
+    {
+        return liveCount.load(memory_order_relaxed);
+    }
+};
+
+#endif
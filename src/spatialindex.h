@@ -0,0 +1,335 @@
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <vector>
+#include "geo.h"
+using namespace std;
+
+struct SpatialHit
+{
+    int id;
+    double distanceKm;
+};
+
+// Static k-d tree over junction coordinates, packed into one array.
+//
+// Points are projected to local km (see LocalProjection) and stored so that
+// every subtree is a contiguous range whose middle element is the splitting
+// point; no child pointers are needed. Small ranges are scanned linearly.
+//
+// Inserts land in a short linear tail. When the tail fills up it is merged
+// into a second, smaller tree, and that one is folded into the main tree
+// once it reaches a sixteenth of its size, so each rebuild stays cheap
+// relative to the number of inserts it absorbs.
+class SpatialIndex
+{
+
+private:
+    struct Point
+    {
+        float x;
+        float y;
+        int id;
+    };
+
+    static const int LEAF_SIZE = 8;
+    static const int TAIL_SIZE = 64;
+
+    LocalProjection projection;
+    vector<Point> points;     // main tree, k-d ordered
+    vector<Point> recent;     // smaller tree of recent inserts, k-d ordered
+    vector<Point> tail;       // newest inserts, unordered
+
+    static void buildRange(vector<Point>& points, int lo, int hi, int depth)
+    {
+        if (hi - lo <= LEAF_SIZE)
+        {
+            return;
+        }
+
+        int mid = (lo + hi) / 2;
+        bool byX = depth % 2 == 0;
+
+        nth_element(points.begin() + lo, points.begin() + mid, points.begin() + hi,
+            [byX](const Point& a, const Point& b)
+            {
+                return byX ? a.x < b.x : a.y < b.y;
+            });
+
+        buildRange(points, lo, mid, depth + 1);
+        buildRange(points, mid + 1, hi, depth + 1);
+    }
+
+    static float squaredDistance(const Point& p, float x, float y)
+    {
+        float dx = p.x - x;
+        float dy = p.y - y;
+        return dx * dx + dy * dy;
+    }
+
+    // Walk the tree calling consider() on every point that may lie within
+    // bound (squared km). consider() may shrink bound as it finds closer points.
+    template <typename Visit>
+    static void visit(const vector<Point>& points, int lo, int hi, int depth,
+                      float x, float y, const float& bound, const Visit& consider)
+    {
+        if (hi - lo <= LEAF_SIZE)
+        {
+            for (int i = lo; i < hi; i++)
+            {
+                consider(points[i]);
+            }
+            return;
+        }
+
+        int mid = (lo + hi) / 2;
+        const Point& split = points[mid];
+        float delta = depth % 2 == 0 ? x - split.x : y - split.y;
+
+        consider(split);
+
+        // Near side first, far side only if the splitting line is within bound
+        if (delta < 0)
+        {
+            visit(points, lo, mid, depth + 1, x, y, bound, consider);
+
+            if (delta * delta <= bound)
+            {
+                visit(points, mid + 1, hi, depth + 1, x, y, bound, consider);
+            }
+        }
+        else
+        {
+            visit(points, mid + 1, hi, depth + 1, x, y, bound, consider);
+
+            if (delta * delta <= bound)
+            {
+                visit(points, lo, mid, depth + 1, x, y, bound, consider);
+            }
+        }
+    }
+
+    // Report every point inside the rectangle [minX, maxX] x [minY, maxY]
+    template <typename Visit>
+    static void visitRect(const vector<Point>& points, int lo, int hi, int depth,
+                          float minX, float minY, float maxX, float maxY, const Visit& report)
+    {
+        auto inside = [&](const Point& p)
+        {
+            return p.x >= minX && p.x <= maxX && p.y >= minY && p.y <= maxY;
+        };
+
+        if (hi - lo <= LEAF_SIZE)
+        {
+            for (int i = lo; i < hi; i++)
+            {
+                if (inside(points[i]))
+                {
+                    report(points[i].id);
+                }
+            }
+            return;
+        }
+
+        int mid = (lo + hi) / 2;
+        const Point& split = points[mid];
+        float key = depth % 2 == 0 ? split.x : split.y;
+
+        if (inside(split))
+        {
+            report(split.id);
+        }
+
+        if ((depth % 2 == 0 ? minX : minY) <= key)
+        {
+            visitRect(points, lo, mid, depth + 1, minX, minY, maxX, maxY, report);
+        }
+
+        if ((depth % 2 == 0 ? maxX : maxY) >= key)
+        {
+            visitRect(points, mid + 1, hi, depth + 1, minX, minY, maxX, maxY, report);
+        }
+    }
+
+public:
+
+    // Rebuild from scratch; ids, lats and lngs are parallel arrays
+    void build(const vector<int>& ids, const vector<double>& lats, const vector<double>& lngs)
+    {
+        double latSum = 0;
+
+        for (double lat : lats)
+        {
+            latSum += lat;
+        }
+
+        projection = LocalProjection(lats.empty() ? 0 : latSum / lats.size());
+        points.resize(ids.size());
+
+        for (size_t i = 0; i < ids.size(); i++)
+        {
+            points[i] = {(float)projection.x(lngs[i]), (float)projection.y(lats[i]), ids[i]};
+        }
+
+        recent.clear();
+        tail.clear();
+        buildRange(points, 0, points.size(), 0);
+    }
+
+    void insert(int id, double lat, double lng)
+    {
+        tail.push_back({(float)projection.x(lng), (float)projection.y(lat), id});
+
+        if (tail.size() < TAIL_SIZE)
+        {
+            return;
+        }
+
+        recent.insert(recent.end(), tail.begin(), tail.end());
+        tail.clear();
+
+        if (recent.size() * 16 > points.size())
+        {
+            points.insert(points.end(), recent.begin(), recent.end());
+            recent.clear();
+            buildRange(points, 0, points.size(), 0);
+        }
+        else
+        {
+            buildRange(recent, 0, recent.size(), 0);
+        }
+    }
+
+    // k closest junctions, nearest first; only those within radiusKm if given
+    vector<SpatialHit> nearest(double lat, double lng, int k,
+                               double radiusKm = numeric_limits<double>::infinity()) const
+    {
+        vector<pair<float, int>> best;   // max-heap on distance
+
+        if (k <= 0)
+        {
+            return {};
+        }
+
+        float x = projection.x(lng);
+        float y = projection.y(lat);
+        float radius = radiusKm * radiusKm;
+        float bound = radius;
+
+        auto consider = [&](const Point& p)
+        {
+            float d = squaredDistance(p, x, y);
+
+            if (d > radius)
+            {
+                return;
+            }
+
+            if ((int)best.size() < k)
+            {
+                best.push_back({d, p.id});
+                push_heap(best.begin(), best.end());
+            }
+            else if (d < best.front().first)
+            {
+                pop_heap(best.begin(), best.end());
+                best.back() = {d, p.id};
+                push_heap(best.begin(), best.end());
+            }
+
+            if ((int)best.size() == k)
+            {
+                bound = best.front().first;
+            }
+        };
+
+        visit(points, 0, points.size(), 0, x, y, bound, consider);
+        visit(recent, 0, recent.size(), 0, x, y, bound, consider);
+
+        for (const auto& p : tail)
+        {
+            consider(p);
+        }
+
+        sort_heap(best.begin(), best.end());
+
+        vector<SpatialHit> hits;
+
+        for (auto [d, id] : best)
+        {
+            hits.push_back({id, sqrt((double)d)});
+        }
+        return hits;
+    }
+
+    // All junctions within radiusKm, nearest first
+    vector<SpatialHit> withinRadius(double lat, double lng, double radiusKm) const
+    {
+        vector<pair<float, int>> found;
+        float x = projection.x(lng);
+        float y = projection.y(lat);
+        float bound = radiusKm * radiusKm;
+
+        auto consider = [&](const Point& p)
+        {
+            float d = squaredDistance(p, x, y);
+
+            if (d <= bound)
+            {
+                found.push_back({d, p.id});
+            }
+        };
+
+        visit(points, 0, points.size(), 0, x, y, bound, consider);
+        visit(recent, 0, recent.size(), 0, x, y, bound, consider);
+
+        for (const auto& p : tail)
+        {
+            consider(p);
+        }
+
+        sort(found.begin(), found.end());
+
+        vector<SpatialHit> hits;
+
+        for (auto [d, id] : found)
+        {
+            hits.push_back({id, sqrt((double)d)});
+        }
+        return hits;
+    }
+
+    // IDs of all junctions inside a lat/lng bounding box
+    vector<int> inBox(double minLat, double minLng, double maxLat, double maxLng) const
+    {
+        vector<int> ids;
+        float minX = projection.x(minLng), maxX = projection.x(maxLng);
+        float minY = projection.y(minLat), maxY = projection.y(maxLat);
+        auto report = [&](int id)
+        {
+            ids.push_back(id);
+        };
+
+        visitRect(points, 0, points.size(), 0, minX, minY, maxX, maxY, report);
+        visitRect(recent, 0, recent.size(), 0, minX, minY, maxX, maxY, report);
+
+        for (const auto& p : tail)
+        {
+            if (p.x >= minX && p.x <= maxX && p.y >= minY && p.y <= maxY)
+            {
+                ids.push_back(p.id);
+            }
+        }
+        return ids;
+    }
+
+    int size() const
+    {
+        return points.size() + recent.size() + tail.size();
+    }
+};
+
+#endif
@@ -0,0 +1,225 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+using namespace std;
+
+// Interned strings: every distinct string is stored once and named by a
+// 32-bit handle, so records can hold four bytes (or a view) instead of a
+// std::string and repeated names (a road split into many segments, a
+// junction known to several indexes) cost nothing extra.
+//
+// Bytes go into 64 KiB chunks that never move, so a view() stays valid for
+// the pool's lifetime; a string longer than a chunk gets one of its own.
+// Entries sit in blocks of doubling size that never move either, so view()
+// takes no lock and may run while intern() adds strings; intern() calls
+// are serialized by the pool's mutex. Strings are never removed: a renamed
+// name stays in the pool.
+class StringPool
+{
+
+private:
+    static const size_t CHUNK = 64 * 1024;
+    static const int FIRST_BLOCK_BITS = 10;   // block k holds 2^(k + 10) entries
+    static const int BLOCKS = 32 - FIRST_BLOCK_BITS + 1;
+
+    struct Entry
+    {
+        const char* data;
+        uint32_t length;
+        uint32_t hash;
+    };
+
+    mutable mutex writer;
+    vector<unique_ptr<char[]>> chunks;
+    size_t used = 0;                          // bytes taken in chunks.back()
+    vector<unique_ptr<char[]>> large;         // strings longer than a chunk
+    size_t largeBytes = 0;
+    atomic<Entry*> blocks[BLOCKS] = {};
+    atomic<uint32_t> count{0};
+    atomic<size_t> storedBytes{0};
+    vector<uint32_t> slots;                   // handle + 1, 0 = empty
+    size_t mask = 0;
+
+    static uint32_t hashOf(string_view s)
+    {
+        uint32_t h = 2166136261u;
+
+        for (unsigned char c : s)
+        {
+            h = (h ^ c) * 16777619u;
+        }
+        return h;
+    }
+
+    // Block and offset of a handle
+    static void locate(uint32_t handle, int& block, size_t& offset)
+    {
+        uint64_t n = (uint64_t)handle + (1u << FIRST_BLOCK_BITS);
+        int bit = 63 - __builtin_clzll(n);
+        block = bit - FIRST_BLOCK_BITS;
+        offset = n - ((uint64_t)1 << bit);
+    }
+
+    const Entry& entry(uint32_t handle) const
+    {
+        int block;
+        size_t offset;
+        locate(handle, block, offset);
+        return blocks[block].load(memory_order_acquire)[offset];
+    }
+
+    const char* store(string_view s)
+    {
+        if (s.empty())
+        {
+            return "";
+        }
+
+        if (s.size() > CHUNK)
+        {
+            large.push_back(make_unique<char[]>(s.size()));
+            memcpy(large.back().get(), s.data(), s.size());
+            largeBytes += s.size();
+            return large.back().get();
+        }
+
+        if (chunks.empty() || used + s.size() > CHUNK)
+        {
+            chunks.push_back(make_unique<char[]>(CHUNK));
+            used = 0;
+        }
+
+        char* p = chunks.back().get() + used;
+        memcpy(p, s.data(), s.size());
+        used += s.size();
+        return p;
+    }
+
+    // Caller holds writer
+    void grow()
+    {
+        size_t size = slots.empty() ? 1024 : slots.size() * 2;
+        slots.assign(size, 0);
+        mask = size - 1;
+
+        uint32_t n = count.load(memory_order_relaxed);
+
+        for (uint32_t handle = 0; handle < n; handle++)
+        {
+            size_t i = entry(handle).hash & mask;
+
+            while (slots[i])
+            {
+                i = (i + 1) & mask;
+            }
+            slots[i] = handle + 1;
+        }
+    }
+
+public:
+    StringPool() = default;
+
+    ~StringPool()
+    {
+        for (auto& block : blocks)
+        {
+            delete[] block.load();
+        }
+    }
+
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    // Handle of s, storing it if it is new
+    uint32_t intern(string_view s)
+    {
+        lock_guard<mutex> guard(writer);
+        uint32_t n = count.load(memory_order_relaxed);
+
+        if ((n + 1) * 2 > slots.size())
+        {
+            grow();
+        }
+
+        uint32_t h = hashOf(s);
+        size_t i = h & mask;
+
+        while (slots[i])
+        {
+            const Entry& e = entry(slots[i] - 1);
+
+            if (e.hash == h && e.length == s.size() && memcmp(e.data, s.data(), s.size()) == 0)
+            {
+                return slots[i] - 1;
+            }
+            i = (i + 1) & mask;
+        }
+
+        int block;
+        size_t offset;
+        locate(n, block, offset);
+
+        if (offset == 0)
+        {
+            blocks[block].store(new Entry[(size_t)1 << (block + FIRST_BLOCK_BITS)], memory_order_release);
+        }
+
+        blocks[block].load(memory_order_relaxed)[offset] = {store(s), (uint32_t)s.size(), h};
+        storedBytes.fetch_add(s.size(), memory_order_relaxed);
+        count.store(n + 1, memory_order_release);
+        slots[i] = n + 1;
+        return n;
+    }
+
+    string_view view(uint32_t handle) const
+    {
+        const Entry& e = entry(handle);
+        return string_view(e.data, e.length);
+    }
+
+    void reserve(size_t strings)
+    {
+        lock_guard<mutex> guard(writer);
+
+        while (strings * 2 > slots.size())
+        {
+            grow();
+        }
+    }
+
+    // Distinct strings
+    size_t size() const
+    {
+        return count.load(memory_order_acquire);
+    }
+
+    // Characters stored, each distinct string once
+    size_t bytes() const
+    {
+        return storedBytes.load(memory_order_relaxed);
+    }
+
+    size_t memoryBytes() const
+    {
+        lock_guard<mutex> guard(writer);
+        size_t entries = 0;
+
+        for (int block = 0; block < BLOCKS; block++)
+        {
+            if (blocks[block].load(memory_order_relaxed))
+            {
+                entries += (size_t)1 << (block + FIRST_BLOCK_BITS);
+            }
+        }
+        return chunks.size() * CHUNK + largeBytes + entries * sizeof(Entry) + slots.capacity() * 4;
+    }
+};
+
+#endif
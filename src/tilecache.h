@@ -0,0 +1,383 @@
+#ifndef TILECACHE_H
+#define TILECACHE_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "geo.h"
+#include "graph.h"
+#include "payload.h"
+#include "segmentindex.h"
+using namespace std;
+
+// Live congestion map as z/x/y vector tiles (Mapbox Vector Tile encoding:
+// protobuf, one "roads" layer of LineString features in Web Mercator tile
+// space). Each feature carries its junction IDs and the current traffic
+// multiplier per direction.
+//
+// Encoded tiles are cached, compressed once as they are encoded (Payload).
+// The Graph's traffic listener calls invalidate() for each changed edge,
+// which only marks the cached tiles the road's box touches as dirty; a
+// dirty tile is re-encoded on its next request.
+//
+// Callers serialize tile() against graph writes (shared vs exclusive lock);
+// the cache itself has its own mutex so concurrent readers are safe.
+class TileCache
+{
+
+private:
+    static const int EXTENT = 4096;     // tile coordinate range
+    static const int BUFFER = 64;       // extra margin so lines continue across tile edges
+    static const size_t MAX_TILES = 4096;
+
+    struct Entry
+    {
+        shared_ptr<const Payload> data;
+        bool dirty;
+    };
+
+    const Graph& graph;
+    const SegmentIndex& roads;
+    int maxZoom;
+
+    mutable mutex lock;
+    unordered_map<uint64_t, Entry> cache;
+    map<int, int> zoomCount;            // cached tiles per zoom level
+
+    static uint64_t key(int z, int x, int y)
+    {
+        return ((uint64_t)z << 58) | ((uint64_t)x << 29) | (uint64_t)y;
+    }
+
+    // Web Mercator position in tiles at zoom z (fractional)
+    static double tileX(double lng, int z)
+    {
+        return (lng + 180.0) / 360.0 * (double)(1 << z);
+    }
+
+    static double tileY(double lat, int z)
+    {
+        double r = lat * DEG_TO_RAD;
+        return (1.0 - log(tan(r) + 1.0 / cos(r)) / M_PI) / 2.0 * (double)(1 << z);
+    }
+
+    static double tileLng(double x, int z)
+    {
+        return x / (double)(1 << z) * 360.0 - 180.0;
+    }
+
+    static double tileLat(double y, int z)
+    {
+        double n = M_PI - 2.0 * M_PI * y / (double)(1 << z);
+        return atan(sinh(n)) / DEG_TO_RAD;
+    }
+
+    // --- protobuf writing ---
+
+    static void writeVarint(string& out, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back((char)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((char)value);
+    }
+
+    static void writeTag(string& out, int field, int wireType)
+    {
+        writeVarint(out, ((uint64_t)field << 3) | wireType);
+    }
+
+    static void writeBytes(string& out, int field, const string& bytes)
+    {
+        writeTag(out, field, 2);
+        writeVarint(out, bytes.size());
+        out += bytes;
+    }
+
+    static uint32_t zigzag(int value)
+    {
+        return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    }
+
+    static string intValue(long long v)
+    {
+        string value;
+        writeTag(value, 6, 0);    // sint_value
+        writeVarint(value, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+        return value;
+    }
+
+    static string doubleValue(double v)
+    {
+        string value;
+        uint64_t bits;
+        memcpy(&bits, &v, sizeof(bits));
+        writeTag(value, 3, 1);    // double_value, fixed64
+        for (int i = 0; i < 8; i++)
+        {
+            value.push_back((char)(bits >> (8 * i)));
+        }
+        return value;
+    }
+
+    static string boolValue(bool v)
+    {
+        string value;
+        writeTag(value, 7, 0);    // bool_value
+        writeVarint(value, v);
+        return value;
+    }
+
+    // Current over base time for u -> v; negative when closed or missing
+    double multiplier(int u, int v) const
+    {
+        for (const auto& edge : graph.edges(u))
+        {
+            if (edge.to == v && edge.baseTime > 0 && edge.currentTime != numeric_limits<double>::infinity())
+            {
+                return edge.currentTime / edge.baseTime;
+            }
+        }
+        return -1;
+    }
+
+    string encode(int z, int x, int y) const
+    {
+        enum { FROM, TO, FORWARD, BACKWARD, CLOSED };
+        static const char* keys[] = {"from", "to", "forward", "backward", "closed"};
+
+        // Values are shared between features, so deduplicate them
+        vector<string> values;
+        unordered_map<string, int> valueIndex;
+
+        auto valueId = [&](const string& encoded)
+        {
+            auto it = valueIndex.find(encoded);
+            if (it != valueIndex.end())
+            {
+                return it->second;
+            }
+            valueIndex[encoded] = values.size();
+            values.push_back(encoded);
+            return (int)values.size() - 1;
+        };
+
+        double margin = (double)BUFFER / EXTENT;
+        double north = tileLat(y - margin, z), south = tileLat(y + 1 + margin, z);
+        double west = tileLng(x - margin, z), east = tileLng(x + 1 + margin, z);
+
+        string layer;
+        writeTag(layer, 15, 0);    // version
+        writeVarint(layer, 2);
+        writeBytes(layer, 1, "roads");
+
+        int featureCount = 0;
+
+        for (auto [u, v] : roads.inBox(south, west, north, east))
+        {
+            double forward = multiplier(u, v);
+            double backward = multiplier(v, u);
+
+            string tags;
+            auto tag = [&](int k, const string& encoded)
+            {
+                writeVarint(tags, k);
+                writeVarint(tags, valueId(encoded));
+            };
+
+            tag(FROM, intValue(graph.junctionId(u)));
+            tag(TO, intValue(graph.junctionId(v)));
+
+            if (forward >= 0)
+            {
+                tag(FORWARD, doubleValue(forward));
+            }
+            if (backward >= 0)
+            {
+                tag(BACKWARD, doubleValue(backward));
+            }
+            if (forward < 0 || backward < 0)
+            {
+                tag(CLOSED, boolValue(true));
+            }
+
+            // MoveTo(1) start, LineTo(1) end; coordinates are zigzag deltas
+            int x1 = (int)lround((tileX(graph.longitude(u), z) - x) * EXTENT);
+            int y1 = (int)lround((tileY(graph.latitude(u), z) - y) * EXTENT);
+            int x2 = (int)lround((tileX(graph.longitude(v), z) - x) * EXTENT);
+            int y2 = (int)lround((tileY(graph.latitude(v), z) - y) * EXTENT);
+
+            string geometry;
+            writeVarint(geometry, (1 << 3) | 1);
+            writeVarint(geometry, zigzag(x1));
+            writeVarint(geometry, zigzag(y1));
+            writeVarint(geometry, (1 << 3) | 2);
+            writeVarint(geometry, zigzag(x2 - x1));
+            writeVarint(geometry, zigzag(y2 - y1));
+
+            string feature;
+            writeTag(feature, 1, 0);    // id
+            writeVarint(feature, featureCount + 1);
+            writeBytes(feature, 2, tags);
+            writeTag(feature, 3, 0);    // type = LINESTRING
+            writeVarint(feature, 2);
+            writeBytes(feature, 4, geometry);
+
+            writeBytes(layer, 2, feature);
+            featureCount++;
+        }
+
+        for (const char* k : keys)
+        {
+            writeBytes(layer, 3, k);
+        }
+
+        for (const auto& value : values)
+        {
+            writeBytes(layer, 4, value);
+        }
+
+        writeTag(layer, 5, 0);    // extent
+        writeVarint(layer, EXTENT);
+
+        string tile;
+
+        if (featureCount > 0)
+        {
+            writeBytes(tile, 3, layer);
+        }
+        return tile;
+    }
+
+    void markRange(int z, double minLat, double minLng, double maxLat, double maxLng)
+    {
+        double margin = (double)BUFFER / EXTENT;
+        int n = 1 << z;
+        int x0 = max(0, (int)floor(tileX(minLng, z) - margin));
+        int x1 = min(n - 1, (int)floor(tileX(maxLng, z) + margin));
+        int y0 = max(0, (int)floor(tileY(maxLat, z) - margin));
+        int y1 = min(n - 1, (int)floor(tileY(minLat, z) + margin));
+
+        // Long roads at high zoom span many tiles; then scanning the cache is cheaper
+        if ((long long)(x1 - x0 + 1) * (y1 - y0 + 1) > (long long)cache.size())
+        {
+            for (auto& [k, entry] : cache)
+            {
+                int tz = k >> 58;
+                int tx = (k >> 29) & ((1 << 29) - 1);
+                int ty = k & ((1 << 29) - 1);
+
+                if (tz == z && tx >= x0 && tx <= x1 && ty >= y0 && ty <= y1)
+                {
+                    entry.dirty = true;
+                }
+            }
+            return;
+        }
+
+        for (int tx = x0; tx <= x1; tx++)
+        {
+            for (int ty = y0; ty <= y1; ty++)
+            {
+                auto it = cache.find(key(z, tx, ty));
+
+                if (it != cache.end())
+                {
+                    it->second.dirty = true;
+                }
+            }
+        }
+    }
+
+public:
+    TileCache(const Graph& g, const SegmentIndex& r, int maximumZoom = 20)
+        : graph(g), roads(r), maxZoom(maximumZoom) {}
+
+    bool isValidTile(int z, int x, int y) const
+    {
+        return z >= 0 && z <= maxZoom && x >= 0 && y >= 0 && x < (1 << z) && y < (1 << z);
+    }
+
+    // Encoded tile, from cache unless missing or dirty. Empty when no road
+    // crosses it. Caller holds the graph lock (shared is enough).
+    shared_ptr<const Payload> tile(int z, int x, int y)
+    {
+        {
+            lock_guard<mutex> guard(lock);
+            auto it = cache.find(key(z, x, y));
+
+            if (it != cache.end() && !it->second.dirty)
+            {
+                return it->second.data;
+            }
+        }
+
+        auto data = make_shared<const Payload>(encode(z, x, y));
+
+        lock_guard<mutex> guard(lock);
+
+        // Crude bound on memory: start over when the cache is full
+        if (cache.size() >= MAX_TILES && !cache.count(key(z, x, y)))
+        {
+            cache.clear();
+            zoomCount.clear();
+        }
+
+        auto [it, inserted] = cache.insert({key(z, x, y), Entry{data, false}});
+
+        if (inserted)
+        {
+            zoomCount[z]++;
+        }
+        else
+        {
+            it->second = Entry{data, false};
+        }
+        return data;
+    }
+
+    // Graph traffic listener: u -> v (dense indices) changed, or everything
+    // when u is -1. Marks only the cached tiles touched by that road.
+    void invalidate(int u, int v)
+    {
+        lock_guard<mutex> guard(lock);
+
+        if (u < 0 || v < 0)
+        {
+            for (auto& [k, entry] : cache)
+            {
+                entry.dirty = true;
+            }
+            return;
+        }
+
+        double minLat = min(graph.latitude(u), graph.latitude(v));
+        double maxLat = max(graph.latitude(u), graph.latitude(v));
+        double minLng = min(graph.longitude(u), graph.longitude(v));
+        double maxLng = max(graph.longitude(u), graph.longitude(v));
+
+        for (auto [z, count] : zoomCount)
+        {
+            if (count > 0)
+            {
+                markRange(z, minLat, minLng, maxLat, maxLng);
+            }
+        }
+    }
+
+    int size() const
+    {
+        lock_guard<mutex> guard(lock);
+        return cache.size();
+    }
+};
+
+#endif
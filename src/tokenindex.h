@@ -0,0 +1,484 @@
+#ifndef TOKENINDEX_H
+#define TOKENINDEX_H
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "postings.h"
+using namespace std;
+
+// Word search: names that contain every word of the query, in any order.
+//
+// Names are folded before they are cut into words: ASCII is lowercased,
+// Latin letters with accents (U+00C0 - U+017F) lose them, combining marks
+// are dropped and any other punctuation separates words. Other UTF-8 text
+// is kept byte for byte.
+//
+// Each word has a posting list of ascending doc IDs, delta coded as
+// variable-length bytes (7 bits per byte), with the last doc and byte
+// offset of every 128 docs kept aside. A query joins its lists by
+// leapfrogging: each list gallops over those block ends to the next doc
+// the others could agree on, decodes only the blocks it lands in and
+// scans them four docs at a time with SSE2. Matches come out in doc order,
+// so a search stops as soon as it has `limit` of them, however common
+// its words are.
+//
+// add() appends to the lists, so names can be added at any time; removal
+// is a tombstone. build() indexes a whole batch on several threads.
+class TokenIndex
+{
+
+private:
+    static const int BLOCK = 128;
+    static const uint32_t END = UINT32_MAX;
+
+    struct Postings
+    {
+        vector<uint8_t> bytes;
+        vector<uint32_t> lastDoc;        // per block, for skipping
+        vector<uint32_t> offset;         // per block, into bytes
+        uint32_t count = 0;
+    };
+
+    unordered_map<string, Postings> words;
+    vector<uint32_t> values;
+    vector<bool> removed;
+    int liveCount = 0;
+
+    // Docs are appended in ascending order
+    static void append(Postings& list, uint32_t doc)
+    {
+        uint32_t delta = doc - (list.lastDoc.empty() ? 0 : list.lastDoc.back());
+
+        if (list.count % BLOCK == 0)
+        {
+            list.offset.push_back(list.bytes.size());
+            list.lastDoc.push_back(doc);
+        }
+        else
+        {
+            list.lastDoc.back() = doc;
+        }
+
+        while (delta >= 0x80)
+        {
+            list.bytes.push_back((uint8_t)(delta | 0x80));
+            delta >>= 7;
+        }
+        list.bytes.push_back((uint8_t)delta);
+        list.count++;
+    }
+
+    // Doc IDs of block `block` into out; returns how many
+    static int decodeBlock(const Postings& list, size_t block, uint32_t* out)
+    {
+        const uint8_t* in = list.bytes.data() + list.offset[block];
+        int n = min<uint32_t>(BLOCK, list.count - block * BLOCK);
+        uint32_t doc = block ? list.lastDoc[block - 1] : 0;
+
+        for (int j = 0; j < n; j++)
+        {
+            uint32_t delta = *in & 0x7f;
+
+            for (int shift = 7; *in++ & 0x80; shift += 7)
+            {
+                delta |= (uint32_t)(*in & 0x7f) << shift;
+            }
+            doc += delta;
+            out[j] = doc;
+        }
+        return n;
+    }
+
+    // Walks one posting list forward. seek() gallops over the block ends
+    // to the block that can hold the target, decodes it once and scans on
+    // from where the last seek stopped.
+    struct Cursor
+    {
+        const Postings* list;
+        size_t current = 0;
+        size_t decoded = SIZE_MAX;
+        int n = 0, pos = 0;
+        uint32_t block[BLOCK];
+
+        // Smallest doc >= target, or END
+        uint32_t seek(uint32_t target)
+        {
+            current = gallop(list->lastDoc, current, target);
+
+            if (current == list->lastDoc.size())
+            {
+                return END;
+            }
+
+            if (decoded != current)
+            {
+                n = decodeBlock(*list, current, block);
+                decoded = current;
+                pos = 0;
+            }
+            pos = lowerBound(block, pos, n, target);
+            return block[pos];    // lastDoc[current] >= target, so pos < n
+        }
+    };
+
+    // Latin-1 letters U+00C0 - U+00FF and Latin Extended-A U+0100 - U+017F
+    // without their accents; '*' marks letters written as two
+    static char baseLetter(uint32_t code)
+    {
+        static const string latin1 = "aaaaaa*ceeeeiiiidnooooo ouuuuy**aaaaaa*ceeeeiiiidnooooo ouuuuy*y";
+        static const string extendedA =
+            string(6, 'a') + string(8, 'c') + string(4, 'd') + string(10, 'e') + string(8, 'g') +
+            string(4, 'h') + string(10, 'i') + string(2, '*') + string(2, 'j') + string(3, 'k') +
+            string(10, 'l') + string(9, 'n') + string(6, 'o') + string(2, '*') + string(6, 'r') +
+            string(8, 's') + string(6, 't') + string(12, 'u') + string(2, 'w') + string(3, 'y') +
+            string(6, 'z') + string(1, 's');
+
+        return code < 0x100 ? latin1[code - 0xc0] : extendedA[code - 0x100];
+    }
+
+    static const char* ligature(uint32_t code)
+    {
+        switch (code)
+        {
+            case 0xc6: case 0xe6: return "ae";
+            case 0xde: case 0xfe: return "th";
+            case 0xdf: return "ss";
+            case 0x132: case 0x133: return "ij";
+            default: return "oe";      // U+0152, U+0153
+        }
+    }
+
+    static vector<string> split(const string& folded)
+    {
+        vector<string> tokens;
+        size_t start = 0;
+
+        while (start < folded.size())
+        {
+            size_t end = folded.find(' ', start);
+
+            if (end == string::npos)
+            {
+                end = folded.size();
+            }
+            tokens.push_back(folded.substr(start, end - start));
+            start = end + 1;
+        }
+        return tokens;
+    }
+
+    // Call visit(doc) for every doc holding all the tokens, ascending,
+    // until it returns false. Leapfrog join: the shortest list proposes a
+    // doc, each other list seeks to it, and the first that overshoots
+    // proposes the next one, so every list skips what the others rule out.
+    template<typename Visit>
+    void matching(vector<string> tokens, const Visit& visit) const
+    {
+        sort(tokens.begin(), tokens.end());
+        tokens.erase(unique(tokens.begin(), tokens.end()), tokens.end());
+
+        vector<Cursor> cursors(tokens.size());
+
+        for (size_t i = 0; i < tokens.size(); i++)
+        {
+            auto it = words.find(tokens[i]);
+
+            if (it == words.end())
+            {
+                return;
+            }
+            cursors[i].list = &it->second;
+        }
+
+        if (cursors.empty())
+        {
+            return;
+        }
+
+        sort(cursors.begin(), cursors.end(), [](const Cursor& a, const Cursor& b)
+        {
+            return a.list->count < b.list->count;
+        });
+
+        uint32_t doc = cursors[0].seek(0);
+
+        while (doc != END)
+        {
+            size_t agreed = 1;
+
+            while (agreed < cursors.size())
+            {
+                uint32_t next = cursors[agreed].seek(doc);
+
+                if (next == doc)
+                {
+                    agreed++;
+                    continue;
+                }
+
+                doc = next == END ? END : cursors[0].seek(next);
+                agreed = doc == END ? cursors.size() : 1;
+            }
+
+            if (doc == END || !visit(doc))
+            {
+                return;
+            }
+            doc = cursors[0].seek(doc + 1);
+        }
+    }
+
+public:
+
+    // Lowercase ASCII, strip Latin accents and combining marks; words are
+    // separated by single spaces. Other UTF-8 is kept as it is.
+    static string fold(const string& name)
+    {
+        string out;
+        size_t i = 0;
+
+        auto separate = [&]
+        {
+            if (!out.empty() && out.back() != ' ')
+            {
+                out += ' ';
+            }
+        };
+
+        while (i < name.size())
+        {
+            unsigned char c = name[i];
+            bool continued = i + 1 < name.size() && ((unsigned char)name[i + 1] & 0xc0) == 0x80;
+
+            if (c < 0x80)
+            {
+                if (isalnum(c))
+                {
+                    out += (char)tolower(c);
+                }
+                else
+                {
+                    separate();
+                }
+                i++;
+                continue;
+            }
+
+            if (!continued || c < 0xc2)
+            {
+                out += (char)c;    // stray byte: keep it
+                i++;
+                continue;
+            }
+
+            // Code point of a 2-byte sequence; longer ones are not decoded
+            uint32_t code = c < 0xe0 ? (uint32_t)(c & 0x1f) << 6 | ((unsigned char)name[i + 1] & 0x3f) : 0;
+
+            if (c >= 0xc3 && c <= 0xc5 && code != 0xd7 && code != 0xf7)
+            {
+                char base = baseLetter(code);
+                out += base == '*' ? ligature(code) : string(1, base);
+                i += 2;
+            }
+            else if (c == 0xc2 || code == 0xd7 || code == 0xf7)
+            {
+                separate();        // Latin-1 punctuation, no-break space, × and ÷
+                i += 2;
+            }
+            else if (c == 0xcc || (c == 0xcd && code < 0x370))
+            {
+                i += 2;            // combining accent, U+0300 - U+036F
+            }
+            else if (c == 0xe2 && ((unsigned char)name[i + 1] & 0xfe) == 0x80)
+            {
+                separate();        // General Punctuation: dashes, quotes, spaces
+                i += 3;
+            }
+            else
+            {
+                size_t length = c >= 0xf0 ? 4 : c >= 0xe0 ? 3 : 2;
+                out.append(name, i, length);
+                i += length;
+            }
+        }
+
+        if (!out.empty() && out.back() == ' ')
+        {
+            out.pop_back();
+        }
+        return out;
+    }
+
+    static vector<string> tokensOf(const string& name)
+    {
+        return split(fold(name));
+    }
+
+    void add(const string& name, uint32_t value)
+    {
+        uint32_t doc = values.size();
+        values.push_back(value);
+        removed.push_back(false);
+        liveCount++;
+
+        vector<string> tokens = tokensOf(name);
+        sort(tokens.begin(), tokens.end());
+        tokens.erase(unique(tokens.begin(), tokens.end()), tokens.end());
+
+        for (const string& token : tokens)
+        {
+            append(words[token], doc);
+        }
+    }
+
+    // Index a batch of (name, value) pairs, replacing what was there.
+    // Threads fold and split slices of the batch into their own word
+    // lists, then each encodes the words that hash to it, taking the
+    // slices in order so every list stays ascending.
+    void build(const vector<pair<string, uint32_t>>& names, size_t threads)
+    {
+        threads = max<size_t>(1, min(threads, names.size() / 1024 + 1));
+
+        words.clear();
+        values.clear();
+        removed.assign(names.size(), false);
+        liveCount = names.size();
+
+        for (const auto& entry : names)
+        {
+            values.push_back(entry.second);
+        }
+
+        size_t slice = (names.size() + threads - 1) / threads;
+        vector<unordered_map<string, vector<uint32_t>>> found(threads);
+        vector<unordered_map<string, Postings>> encoded(threads);
+
+        auto run = [threads](const function<void(size_t)>& worker)
+        {
+            vector<thread> pool;
+
+            for (size_t i = 1; i < threads; i++)
+            {
+                pool.emplace_back(worker, i);
+            }
+
+            worker(0);
+
+            for (auto& t : pool)
+            {
+                t.join();
+            }
+        };
+
+        run([&](size_t self)
+        {
+            size_t end = min(names.size(), (self + 1) * slice);
+
+            for (size_t doc = self * slice; doc < end; doc++)
+            {
+                vector<string> tokens = tokensOf(names[doc].first);
+                sort(tokens.begin(), tokens.end());
+                tokens.erase(unique(tokens.begin(), tokens.end()), tokens.end());
+
+                for (string& token : tokens)
+                {
+                    found[self][move(token)].push_back(doc);
+                }
+            }
+        });
+
+        run([&](size_t self)
+        {
+            hash<string> hasher;
+
+            for (const auto& part : found)
+            {
+                for (const auto& [token, docs] : part)
+                {
+                    if (hasher(token) % threads == self)
+                    {
+                        Postings& list = encoded[self][token];
+
+                        for (uint32_t doc : docs)
+                        {
+                            append(list, doc);
+                        }
+                    }
+                }
+            }
+        });
+
+        for (auto& part : encoded)
+        {
+            for (auto& [token, list] : part)
+            {
+                words.emplace(token, move(list));
+            }
+        }
+    }
+
+    // Drop `value` under `name`; false if it was not there
+    bool remove(const string& name, uint32_t value)
+    {
+        bool found = false;
+
+        matching(tokensOf(name), [&](uint32_t doc)
+        {
+            if (!removed[doc] && values[doc] == value)
+            {
+                removed[doc] = true;
+                liveCount--;
+                found = true;
+            }
+            return true;
+        });
+        return found;
+    }
+
+    // Values of names holding every word of the query, in insertion order
+    vector<uint32_t> search(const string& query, size_t limit) const
+    {
+        vector<uint32_t> result;
+
+        if (limit == 0)
+        {
+            return result;
+        }
+
+        matching(tokensOf(query), [&](uint32_t doc)
+        {
+            if (!removed[doc])
+            {
+                result.push_back(values[doc]);
+            }
+            return result.size() < limit;
+        });
+        return result;
+    }
+
+    int size() const
+    {
+        return liveCount;
+    }
+
+    size_t memoryBytes() const
+    {
+        size_t bytes = values.capacity() * 4 + removed.capacity() / 8 + words.bucket_count() * sizeof(void*);
+
+        for (auto& [token, list] : words)
+        {
+            bytes += sizeof(token) + token.capacity() + sizeof(list) + 2 * sizeof(void*) +
+                     list.bytes.capacity() + list.lastDoc.capacity() * 4 + list.offset.capacity() * 4;
+        }
+        return bytes;
+    }
+};
+
+#endif
@@ -0,0 +1,1054 @@
+#ifndef TRANSITNODES_H
+#define TRANSITNODES_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "graph.h"
+#include "partition.h"
+using namespace std;
+
+// Transit-node routing for long queries.
+//
+// Junctions are grouped into cells. A cell's transit nodes are the junctions
+// where shortest paths from the cell to anywhere beyond its neighbouring
+// cells first leave it, and where shortest paths from beyond them last enter
+// it: usually a few arterial crossings, not every junction on the border.
+// Every junction keeps a few access nodes: the first transit nodes met when
+// leaving it (or arriving at it) inside its own cell, with the distance to
+// each. A table holds base-time distances between all transit nodes, so a
+// query between far-apart cells is
+//
+//     min over access a of s, access b of t:  d(s,a) + table[a][b] + d(b,t)
+//
+// Queries between the same or neighbouring cells are left to the local
+// engine (locality filter).
+//
+// Live traffic: while no edge is faster than its base time, the table still
+// gives exact answers for routes it does not touch. Every slower edge marks
+// the table pairs it may lie on a base-optimal route between, and the
+// junctions whose routes to or from their access nodes it may lie on. A
+// query is answered from the table when neither end is marked and its best
+// pair is unmarked; that route costs the base optimum, which no route can
+// beat. Anything else goes to the local engine.
+//
+// Marking takes a few searches per changed edge, so trafficChanged() (run
+// under the graph's write lock) only queues it for a background thread; the
+// table answers nothing until the queue is drained.
+//
+// The preprocessed data lives in one flat file that is mmap()'d at startup,
+// so a restart only pays for reading the pages it touches.
+class TransitNodeRouting
+{
+
+private:
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        uint64_t signature;
+        uint32_t nodes;
+        uint32_t transit;
+        uint32_t cells;
+        uint32_t forwardEntries;
+        uint32_t backwardEntries;
+        uint32_t reserved;
+    };
+
+    static constexpr uint32_t FORMAT_VERSION = 2;
+
+    const char* data;
+    size_t length;
+    bool mapped;
+    unsigned long loadedStructure;
+
+    const Header* header;
+    const int32_t* cellOf;
+    const uint32_t* transitNode;      // transit index -> dense node index
+    const uint32_t* forwardOffset;
+    const uint32_t* forwardTransit;
+    const float* forwardDist;
+    const uint32_t* backwardOffset;
+    const uint32_t* backwardTransit;
+    const float* backwardDist;
+    const float* table;
+    const uint8_t* cellNear;
+
+    // Live traffic, kept by trafficChanged() (not in the file)
+    vector<int> edgeOffset;           // node -> global index of its first edge
+    vector<int8_t> edgeState;         // by edge: -1 faster, 0 at base time, 1 slower
+    vector<vector<pair<int, double>>> forward;    // base-time edges out of each node, as in the graph
+    vector<vector<pair<int, double>>> reverse;    // base-time edges into each node
+    vector<int> slowerFrom;           // by node: slower edges maybe on its forward access routes
+    vector<int> slowerTo;             // by node: ... on its backward access routes
+    vector<int> slowerOnPair;         // by transit pair: slower edges maybe on its route
+    int fasterEdges;
+    double longestRoute;              // largest finite table entry
+
+    // Edges that turned slower (delta 1) or stopped being slower (-1), marked
+    // by the marker thread. The table is not trusted while any is pending.
+    struct Change
+    {
+        int u;
+        int k;
+        int delta;
+        unsigned generation;
+    };
+
+    mutex queueLock;
+    condition_variable queued;
+    deque<Change> changes;
+    unsigned generation;              // bumped when the counters restart from zero
+    atomic<int> pending;              // changes queued or being marked
+    bool stopping;
+    mutex countersLock;               // marker vs. trafficChanged() writing the counters
+    thread marker;
+
+    void stopMarker()
+    {
+        if (marker.joinable())
+        {
+            {
+                lock_guard<mutex> guard(queueLock);
+                stopping = true;
+            }
+            queued.notify_one();
+            marker.join();
+        }
+
+        changes.clear();
+        pending = 0;
+        stopping = false;
+    }
+
+    void unload()
+    {
+        stopMarker();
+
+        if (mapped && data)
+        {
+            munmap((void*)data, length);
+        }
+
+        data = nullptr;
+        length = 0;
+        mapped = false;
+        header = nullptr;
+    }
+
+    // Point the array views into the loaded bytes, checking the sizes add up
+    bool attach()
+    {
+        if (length < sizeof(Header))
+        {
+            return false;
+        }
+
+        header = (const Header*)data;
+
+        if (memcmp(header->magic, "TNR1", 4) != 0 || header->version != FORMAT_VERSION)
+        {
+            return false;
+        }
+
+        size_t n = header->nodes;
+        size_t t = header->transit;
+        size_t c = header->cells;
+        size_t offset = sizeof(Header);
+
+        auto take = [&](size_t bytes)
+        {
+            const char* p = data + offset;
+            offset += bytes;
+            return p;
+        };
+
+        cellOf = (const int32_t*)take(n * 4);
+        transitNode = (const uint32_t*)take(t * 4);
+        forwardOffset = (const uint32_t*)take((n + 1) * 4);
+        forwardTransit = (const uint32_t*)take(header->forwardEntries * 4);
+        forwardDist = (const float*)take(header->forwardEntries * 4);
+        backwardOffset = (const uint32_t*)take((n + 1) * 4);
+        backwardTransit = (const uint32_t*)take(header->backwardEntries * 4);
+        backwardDist = (const float*)take(header->backwardEntries * 4);
+        table = (const float*)take(t * t * 4);
+        cellNear = (const uint8_t*)take(c * c);
+
+        return offset == length;
+    }
+
+    // Fingerprint of the node order and base-time edges the data was built for
+    static uint64_t signatureOf(const Graph& graph)
+    {
+        uint64_t h = 1469598103934665603ULL;
+
+        auto mix = [&](uint64_t value)
+        {
+            for (int i = 0; i < 8; i++)
+            {
+                h ^= (value >> (i * 8)) & 0xff;
+                h *= 1099511628211ULL;
+            }
+        };
+
+        mix(graph.nodeCount());
+
+        for (int u = 0; u < graph.nodeCount(); u++)
+        {
+            mix(graph.junctionId(u));
+
+            for (const auto& edge : graph.edges(u))
+            {
+                uint64_t bits;
+                memcpy(&bits, &edge.baseTime, sizeof(bits));
+                mix(edge.to);
+                mix(bits);
+            }
+        }
+
+        return h;
+    }
+
+    // Search from node inside its own cell (forward or on reversed edges),
+    // stopping at transit nodes; the transit nodes settled are its access nodes.
+    static void accessSearch(const Graph& graph, const Partition& cells, const vector<int>& transitIndex,
+                             const vector<vector<pair<int, double>>>& reverse, bool forward, int start,
+                             vector<double>& dist, vector<int>& reached, vector<pair<uint32_t, float>>& out)
+    {
+        auto later = greater<pair<double, int>>();
+        vector<pair<double, int>> heap{{0, start}};
+        int cell = cells.region(start);
+
+        dist[start] = 0;
+        reached.push_back(start);
+
+        while (!heap.empty())
+        {
+            pop_heap(heap.begin(), heap.end(), later);
+            auto [d, u] = heap.back();
+            heap.pop_back();
+
+            if (d > dist[u])
+            {
+                continue;
+            }
+
+            if (transitIndex[u] != -1)
+            {
+                out.push_back({(uint32_t)transitIndex[u], (float)d});
+                continue;
+            }
+
+            auto relax = [&](int v, double w)
+            {
+                if (cells.region(v) == cell && d + w < dist[v])
+                {
+                    if (dist[v] == numeric_limits<double>::infinity())
+                    {
+                        reached.push_back(v);
+                    }
+                    dist[v] = d + w;
+                    heap.push_back({dist[v], v});
+                    push_heap(heap.begin(), heap.end(), later);
+                }
+            };
+
+            if (forward)
+            {
+                for (const auto& edge : graph.edges(u))
+                {
+                    relax(edge.to, edge.baseTime);
+                }
+            }
+            else
+            {
+                for (const auto& [v, w] : reverse[u])
+                {
+                    relax(v, w);
+                }
+            }
+        }
+
+        for (int v : reached)
+        {
+            dist[v] = numeric_limits<double>::infinity();
+        }
+        reached.clear();
+    }
+
+    // One search of transit selection, from `start` just beyond the cell's
+    // neighbouring cells: on reversed edges when `leaving` (shortest paths
+    // from the cell out to start), else forwards (from start into the cell).
+    // Marks the junction where each of the cell's junctions' path crosses
+    // the cell border: the last one inside when leaving, the first when not.
+    static void markCrossings(const Graph& graph, const Partition& cells, const vector<vector<pair<int, double>>>& reverse,
+                              int cell, size_t cellSize, int start, bool leaving, vector<double>& dist,
+                              vector<int>& hop, vector<int>& crossing, vector<int>& order, vector<int>& reached,
+                              vector<uint8_t>& marks)
+    {
+        auto later = greater<pair<double, int>>();
+        vector<pair<double, int>> heap{{0, start}};
+        size_t inCell = 0;
+
+        dist[start] = 0;
+        hop[start] = -1;
+        reached.push_back(start);
+
+        while (!heap.empty() && inCell < cellSize)
+        {
+            pop_heap(heap.begin(), heap.end(), later);
+            auto [d, u] = heap.back();
+            heap.pop_back();
+
+            if (d > dist[u])
+            {
+                continue;
+            }
+
+            order.push_back(u);
+            inCell += cells.region(u) == cell;
+
+            auto relax = [&](int v, double w)
+            {
+                if (d + w < dist[v])
+                {
+                    if (dist[v] == numeric_limits<double>::infinity())
+                    {
+                        reached.push_back(v);
+                    }
+                    dist[v] = d + w;
+                    hop[v] = u;
+                    heap.push_back({dist[v], v});
+                    push_heap(heap.begin(), heap.end(), later);
+                }
+            };
+
+            if (leaving)
+            {
+                for (const auto& [v, w] : reverse[u])
+                {
+                    relax(v, w);
+                }
+            }
+            else
+            {
+                for (const auto& edge : graph.edges(u))
+                {
+                    relax(edge.to, edge.baseTime);
+                }
+            }
+        }
+
+        // hop[x] is settled before x, so its crossing is already known
+        for (int x : order)
+        {
+            if (cells.region(x) == cell)
+            {
+                int h = hop[x];
+                crossing[x] = h == -1 || cells.region(h) != cell ? x : crossing[h];
+                marks[crossing[x]] = 1;
+            }
+        }
+
+        for (int v : reached)
+        {
+            dist[v] = numeric_limits<double>::infinity();
+        }
+        reached.clear();
+        order.clear();
+    }
+
+    // Base-time distances from node to every junction, or to node from every
+    // junction when backward, up to limit; only through junctions of cell
+    // unless it is -1
+    vector<double> baseDistances(int node, bool backward, int cell, double limit) const
+    {
+        auto later = greater<pair<double, int>>();
+        vector<double> dist(forward.size(), numeric_limits<double>::infinity());
+        vector<pair<double, int>> heap{{0, node}};
+        dist[node] = 0;
+
+        while (!heap.empty())
+        {
+            pop_heap(heap.begin(), heap.end(), later);
+            auto [d, u] = heap.back();
+            heap.pop_back();
+
+            if (d > dist[u])
+            {
+                continue;
+            }
+
+            auto relax = [&](int v, double w)
+            {
+                if ((cell == -1 || cellOf[v] == cell) && d + w < dist[v] && d + w <= limit)
+                {
+                    dist[v] = d + w;
+                    heap.push_back({dist[v], v});
+                    push_heap(heap.begin(), heap.end(), later);
+                }
+            };
+
+            for (const auto& [v, w] : backward ? reverse[u] : forward[u])
+            {
+                relax(v, w);
+            }
+        }
+        return dist;
+    }
+
+    static int8_t stateOf(const Graph::Edge& edge)
+    {
+        return edge.currentTime < edge.baseTime ? -1 : edge.currentTime > edge.baseTime;
+    }
+
+    // Edge k of u is now faster, at or slower than its base time. Runs under
+    // the graph's write lock, so it only queues the marking.
+    void setState(int u, int k, int8_t state)
+    {
+        int e = edgeOffset[u] + k;
+        int8_t old = edgeState[e];
+
+        if (old == state)
+        {
+            return;
+        }
+
+        fasterEdges += (state == -1) - (old == -1);
+
+        if ((old == 1) != (state == 1))
+        {
+            {
+                lock_guard<mutex> guard(queueLock);
+                changes.push_back({u, k, state == 1 ? 1 : -1, generation});
+                pending++;
+            }
+            queued.notify_one();
+        }
+        edgeState[e] = state;
+    }
+
+    // Add delta to the counters of everything a base-optimal route over edge
+    // k of u may belong to. Reads only this object's copy of the base-time
+    // graph and the mapped file, so it needs no graph lock.
+    void mark(int u, int k, int delta, unsigned changeGeneration)
+    {
+        auto [v, w] = forward[u][k];
+        vector<int> from, to;
+        vector<size_t> pairs;
+
+        // Access routes stay inside their junction's cell
+        if (cellOf[u] == cellOf[v])
+        {
+            int cell = cellOf[u];
+            vector<double> toU = baseDistances(u, true, cell, numeric_limits<double>::infinity());
+            vector<double> fromV = baseDistances(v, false, cell, numeric_limits<double>::infinity());
+
+            for (int x = 0; x < (int)header->nodes; x++)
+            {
+                if (cellOf[x] != cell)
+                {
+                    continue;
+                }
+
+                for (uint32_t i = forwardOffset[x]; i < forwardOffset[x + 1]; i++)
+                {
+                    if (toU[x] + w + fromV[transitNode[forwardTransit[i]]] <= forwardDist[i] * (1 + 1e-5))
+                    {
+                        from.push_back(x);
+                        break;
+                    }
+                }
+
+                for (uint32_t j = backwardOffset[x]; j < backwardOffset[x + 1]; j++)
+                {
+                    if (toU[transitNode[backwardTransit[j]]] + w + fromV[x] <= backwardDist[j] * (1 + 1e-5))
+                    {
+                        to.push_back(x);
+                        break;
+                    }
+                }
+            }
+        }
+
+        // Pairs with a base-optimal route that may run over u -> v (the
+        // slack covers the table's float rounding; marking too many only
+        // costs table answers). No such route is longer than the table's
+        // longest entry, which bounds both searches.
+        double limit = longestRoute * (1 + 1e-5);
+        vector<double> toU = baseDistances(u, true, -1, limit);
+        vector<double> fromV = baseDistances(v, false, -1, limit);
+        size_t t = header->transit;
+
+        for (size_t a = 0; a < t; a++)
+        {
+            double head = toU[transitNode[a]] + w;
+
+            for (size_t b = 0; head <= limit && b < t; b++)
+            {
+                if (head + fromV[transitNode[b]] <= table[a * t + b] * (1 + 1e-5))
+                {
+                    pairs.push_back(a * t + b);
+                }
+            }
+        }
+
+        lock_guard<mutex> guard(countersLock);
+
+        // Counters restarted since the change was queued: it is counted anew
+        if (changeGeneration != generation)
+        {
+            return;
+        }
+
+        for (int x : from)
+        {
+            slowerFrom[x] += delta;
+        }
+        for (int x : to)
+        {
+            slowerTo[x] += delta;
+        }
+        for (size_t pair : pairs)
+        {
+            slowerOnPair[pair] += delta;
+        }
+    }
+
+    void markChanges()
+    {
+        unique_lock<mutex> guard(queueLock);
+
+        while (true)
+        {
+            queued.wait(guard, [&] { return stopping || !changes.empty(); });
+
+            if (stopping)
+            {
+                return;
+            }
+
+            Change change = changes.front();
+            changes.pop_front();
+            guard.unlock();
+
+            mark(change.u, change.k, change.delta, change.generation);
+
+            // Published after the counters, for query()'s acquire load
+            pending.fetch_sub(1, memory_order_release);
+            guard.lock();
+        }
+    }
+
+public:
+    TransitNodeRouting()
+        : data(nullptr), length(0), mapped(false), loadedStructure(0), header(nullptr), fasterEdges(0),
+          longestRoute(0), generation(0), pending(0), stopping(false) {}
+
+    TransitNodeRouting(const TransitNodeRouting&) = delete;
+    TransitNodeRouting& operator=(const TransitNodeRouting&) = delete;
+
+    ~TransitNodeRouting()
+    {
+        unload();
+    }
+
+    // Preprocess graph (base times) and write the result to path
+    static bool build(const Graph& graph, int cellCount, size_t threads, const string& path)
+    {
+        int n = graph.nodeCount();
+        Partition cells;
+        cells.build(graph, cellCount);
+
+        int c = cells.size();
+        vector<int> transitIndex(n, -1);
+        vector<int> transitNodes;
+        vector<uint8_t> near((size_t)c * c, 0);
+        vector<vector<pair<int, double>>> reverse(n);
+        vector<size_t> cellSize(c, 0);
+
+        for (int u = 0; u < n; u++)
+        {
+            near[(size_t)cells.region(u) * c + cells.region(u)] = 1;
+            cellSize[cells.region(u)]++;
+
+            for (const auto& edge : graph.edges(u))
+            {
+                int v = edge.to;
+                reverse[v].push_back({u, edge.baseTime});
+
+                if (cells.region(u) != cells.region(v))
+                {
+                    near[(size_t)cells.region(u) * c + cells.region(v)] = 1;
+                    near[(size_t)cells.region(v) * c + cells.region(u)] = 1;
+                }
+            }
+        }
+
+        if (threads == 0)
+        {
+            threads = 1;
+        }
+
+        // Transit selection: a shortest path from cell C to a junction beyond
+        // its neighbours steps out of them over an edge y -> x (y near C, x
+        // not), so searches from every such x (and into C from every such
+        // edge's far end) see one shortest path per junction of C
+        vector<tuple<int, int, bool>> searches;    // cell, start, leaving
+        vector<int> outSeen(n, -1), inSeen(n, -1);
+
+        for (int cell = 0; cell < c; cell++)
+        {
+            const uint8_t* nearCell = &near[(size_t)cell * c];
+
+            for (int u = 0; u < n; u++)
+            {
+                for (const auto& edge : graph.edges(u))
+                {
+                    int v = edge.to;
+
+                    if (nearCell[cells.region(u)] && !nearCell[cells.region(v)] && outSeen[v] != cell)
+                    {
+                        outSeen[v] = cell;
+                        searches.emplace_back(cell, v, true);
+                    }
+                    if (!nearCell[cells.region(u)] && nearCell[cells.region(v)] && inSeen[u] != cell)
+                    {
+                        inSeen[u] = cell;
+                        searches.emplace_back(cell, u, false);
+                    }
+                }
+            }
+        }
+
+        vector<vector<uint8_t>> marks(threads, vector<uint8_t>(n, 0));
+        atomic<size_t> nextSearch(0);
+
+        auto selector = [&](size_t self)
+        {
+            vector<double> dist(n, numeric_limits<double>::infinity());
+            vector<int> hop(n), crossing(n), order, reached;
+
+            for (size_t task = nextSearch++; task < searches.size(); task = nextSearch++)
+            {
+                auto [cell, start, leaving] = searches[task];
+                markCrossings(graph, cells, reverse, cell, cellSize[cell], start, leaving, dist, hop, crossing, order,
+                              reached, marks[self]);
+            }
+        };
+
+        vector<thread> selectors;
+
+        for (size_t i = 1; i < threads; i++)
+        {
+            selectors.emplace_back(selector, i);
+        }
+
+        selector(0);
+
+        for (auto& th : selectors)
+        {
+            th.join();
+        }
+
+        for (int u = 0; u < n; u++)
+        {
+            for (size_t i = 0; i < threads && transitIndex[u] == -1; i++)
+            {
+                if (marks[i][u])
+                {
+                    transitIndex[u] = transitNodes.size();
+                    transitNodes.push_back(u);
+                }
+            }
+        }
+
+        size_t t = transitNodes.size();
+        vector<vector<pair<uint32_t, float>>> forwardAccess(n), backwardAccess(n);
+        vector<float> distances(t * t, numeric_limits<float>::infinity());
+
+        // Phase 1: access nodes of every junction; phase 2: one full search per transit node
+        atomic<size_t> next(0);
+
+        auto worker = [&]()
+        {
+            vector<double> dist(n, numeric_limits<double>::infinity());
+            vector<int> reached;
+
+            for (size_t task = next++; task < (size_t)n + t; task = next++)
+            {
+                if (task < (size_t)n)
+                {
+                    accessSearch(graph, cells, transitIndex, reverse, true, task, dist, reached, forwardAccess[task]);
+                    accessSearch(graph, cells, transitIndex, reverse, false, task, dist, reached, backwardAccess[task]);
+                    continue;
+                }
+
+                size_t a = task - n;
+                auto later = greater<pair<double, int>>();
+                vector<pair<double, int>> heap{{0, transitNodes[a]}};
+
+                dist[transitNodes[a]] = 0;
+                reached.push_back(transitNodes[a]);
+
+                while (!heap.empty())
+                {
+                    pop_heap(heap.begin(), heap.end(), later);
+                    auto [d, u] = heap.back();
+                    heap.pop_back();
+
+                    if (d > dist[u])
+                    {
+                        continue;
+                    }
+
+                    if (transitIndex[u] != -1)
+                    {
+                        distances[a * t + transitIndex[u]] = d;
+                    }
+
+                    for (const auto& edge : graph.edges(u))
+                    {
+                        if (d + edge.baseTime < dist[edge.to])
+                        {
+                            if (dist[edge.to] == numeric_limits<double>::infinity())
+                            {
+                                reached.push_back(edge.to);
+                            }
+                            dist[edge.to] = d + edge.baseTime;
+                            heap.push_back({dist[edge.to], edge.to});
+                            push_heap(heap.begin(), heap.end(), later);
+                        }
+                    }
+                }
+
+                for (int v : reached)
+                {
+                    dist[v] = numeric_limits<double>::infinity();
+                }
+                reached.clear();
+            }
+        };
+
+        vector<thread> pool;
+
+        for (size_t i = 1; i < threads; i++)
+        {
+            pool.emplace_back(worker);
+        }
+
+        worker();
+
+        for (auto& th : pool)
+        {
+            th.join();
+        }
+
+        // Flatten into the on-disk layout
+        vector<int32_t> cellArray(n);
+        vector<uint32_t> transitArray(transitNodes.begin(), transitNodes.end());
+        vector<uint32_t> fOffset(n + 1, 0), bOffset(n + 1, 0);
+        vector<uint32_t> fTransit, bTransit;
+        vector<float> fDist, bDist;
+
+        for (int u = 0; u < n; u++)
+        {
+            cellArray[u] = cells.region(u);
+
+            for (auto [a, d] : forwardAccess[u])
+            {
+                fTransit.push_back(a);
+                fDist.push_back(d);
+            }
+
+            for (auto [b, d] : backwardAccess[u])
+            {
+                bTransit.push_back(b);
+                bDist.push_back(d);
+            }
+
+            fOffset[u + 1] = fTransit.size();
+            bOffset[u + 1] = bTransit.size();
+        }
+
+        Header h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.magic, "TNR1", 4);
+        h.version = FORMAT_VERSION;
+        h.signature = signatureOf(graph);
+        h.nodes = n;
+        h.transit = t;
+        h.cells = c;
+        h.forwardEntries = fTransit.size();
+        h.backwardEntries = bTransit.size();
+
+        // Written beside path and renamed over it: a process that has the old
+        // file mapped keeps its pages, and a failed write leaves it whole
+        string temporary = path + ".tmp";
+        ofstream file(temporary, ios::binary | ios::trunc);
+
+        if (!file.is_open())
+        {
+            cout << "[Transit] Could not write " << temporary << endl;
+            return false;
+        }
+
+        auto put = [&](const void* p, size_t bytes)
+        {
+            file.write((const char*)p, bytes);
+        };
+
+        put(&h, sizeof(h));
+        put(cellArray.data(), cellArray.size() * 4);
+        put(transitArray.data(), transitArray.size() * 4);
+        put(fOffset.data(), fOffset.size() * 4);
+        put(fTransit.data(), fTransit.size() * 4);
+        put(fDist.data(), fDist.size() * 4);
+        put(bOffset.data(), bOffset.size() * 4);
+        put(bTransit.data(), bTransit.size() * 4);
+        put(bDist.data(), bDist.size() * 4);
+        put(distances.data(), distances.size() * 4);
+        put(near.data(), near.size());
+        file.close();
+
+        if (!file.good() || rename(temporary.c_str(), path.c_str()) != 0)
+        {
+            cout << "[Transit] Could not write " << path << endl;
+            remove(temporary.c_str());
+            return false;
+        }
+
+        cout << "[Transit] Built " << t << " transit nodes over " << c
+             << " cells, " << (fTransit.size() + bTransit.size()) / max(1, 2 * n)
+             << " access nodes per junction" << endl;
+
+        return true;
+    }
+
+    // Map a previously built file; fails if it does not match graph
+    bool load(const string& path, const Graph& graph)
+    {
+        unload();
+
+        int fd = open(path.c_str(), O_RDONLY);
+
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        struct stat info;
+
+        if (fstat(fd, &info) != 0 || info.st_size == 0)
+        {
+            close(fd);
+            return false;
+        }
+
+        length = info.st_size;
+        void* p = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+
+        if (p == MAP_FAILED)
+        {
+            length = 0;
+            return false;
+        }
+
+        data = (const char*)p;
+        mapped = true;
+
+        if (!attach() || header->signature != signatureOf(graph) || (int)header->nodes != graph.nodeCount())
+        {
+            unload();
+            return false;
+        }
+
+        loadedStructure = graph.getStructureVersion();
+
+        // Start from no traffic, then take in what is already live
+        int n = graph.nodeCount();
+        edgeOffset.assign(n + 1, 0);
+        forward.assign(n, {});
+        reverse.assign(n, {});
+
+        for (int u = 0; u < n; u++)
+        {
+            edgeOffset[u + 1] = edgeOffset[u] + graph.edges(u).size();
+
+            for (const auto& edge : graph.edges(u))
+            {
+                forward[u].push_back({edge.to, edge.baseTime});
+                reverse[edge.to].push_back({u, edge.baseTime});
+            }
+        }
+
+        longestRoute = 0;
+
+        for (size_t i = 0; i < (size_t)header->transit * header->transit; i++)
+        {
+            if (table[i] != numeric_limits<float>::infinity())
+            {
+                longestRoute = max(longestRoute, (double)table[i]);
+            }
+        }
+
+        edgeState.assign(edgeOffset[n], 0);
+        slowerFrom.assign(n, 0);
+        slowerTo.assign(n, 0);
+        slowerOnPair.assign((size_t)header->transit * header->transit, 0);
+        fasterEdges = 0;
+        marker = thread(&TransitNodeRouting::markChanges, this);
+        trafficChanged(graph, -1, -1);
+
+        cout << "[Transit] Mapped " << path << " (" << length << " bytes)" << endl;
+        return true;
+    }
+
+    bool isReady(const Graph& graph) const
+    {
+        return header && loadedStructure == graph.getStructureVersion();
+    }
+
+    // Keep the traffic counters current after edge u -> v changed (u == -1:
+    // any edge). Call with the graph's write lock held, after the change.
+    void trafficChanged(const Graph& graph, int u, int v)
+    {
+        if (!isReady(graph))
+        {
+            return;
+        }
+
+        // Any edge: recount from scratch, so a reset costs nothing per edge
+        if (u == -1)
+        {
+            lock_guard<mutex> queueGuard(queueLock);
+            lock_guard<mutex> countersGuard(countersLock);
+            pending -= changes.size();
+            changes.clear();
+            generation++;
+
+            fill(edgeState.begin(), edgeState.end(), 0);
+            fill(slowerFrom.begin(), slowerFrom.end(), 0);
+            fill(slowerTo.begin(), slowerTo.end(), 0);
+            fill(slowerOnPair.begin(), slowerOnPair.end(), 0);
+            fasterEdges = 0;
+        }
+
+        for (int from = u == -1 ? 0 : u; from < (u == -1 ? graph.nodeCount() : u + 1); from++)
+        {
+            const auto& out = graph.edges(from);
+
+            for (int k = 0; k < (int)out.size(); k++)
+            {
+                if (u == -1 || out[k].to == v)
+                {
+                    setState(from, k, stateOf(out[k]));
+                }
+            }
+        }
+    }
+
+    // Locality filter: true when the pair is left to the local engine
+    bool isLocal(const Graph& graph, int source, int dest) const
+    {
+        int s = graph.findIndex(source);
+        int t = graph.findIndex(dest);
+
+        if (s == -1 || t == -1)
+        {
+            return true;
+        }
+
+        return cellNear[(size_t)cellOf[s] * header->cells + cellOf[t]] != 0;
+    }
+
+    // Table-lookup travel time. Returns false when the query should go to the
+    // local engine instead; time is -1 when no path exists.
+    bool query(const Graph& graph, int source, int dest, double& time) const
+    {
+        if (!isReady(graph) || isLocal(graph, source, dest))
+        {
+            return false;
+        }
+
+        int s = graph.findIndex(source);
+        int t = graph.findIndex(dest);
+
+        if (pending.load(memory_order_acquire) > 0 || fasterEdges > 0 || slowerFrom[s] > 0 || slowerTo[t] > 0)
+        {
+            return false;
+        }
+
+        size_t transit = header->transit;
+        double best = numeric_limits<double>::infinity();
+        double clean = numeric_limits<double>::infinity();    // over pairs no slower edge touches
+
+        for (uint32_t i = forwardOffset[s]; i < forwardOffset[s + 1]; i++)
+        {
+            size_t row = (size_t)forwardTransit[i] * transit;
+
+            for (uint32_t j = backwardOffset[t]; j < backwardOffset[t + 1]; j++)
+            {
+                double d = (double)forwardDist[i] + table[row + backwardTransit[j]] + backwardDist[j];
+                best = min(best, d);
+
+                if (slowerOnPair[row + backwardTransit[j]] == 0)
+                {
+                    clean = min(clean, d);
+                }
+            }
+        }
+
+        // Every base-optimal route may be slower now
+        if (clean > best)
+        {
+            return false;
+        }
+
+        time = best == numeric_limits<double>::infinity() ? -1 : best;
+        return true;
+    }
+
+    int transitCount() const
+    {
+        return header ? header->transit : 0;
+    }
+
+    // Traffic changes still being marked; the table answers nothing until 0
+    int pendingChanges() const
+    {
+        return pending.load(memory_order_acquire);
+    }
+
+    // Bytes of the transit-to-transit distance table
+    size_t tableBytes() const
+    {
+        return header ? (size_t)header->transit * header->transit * sizeof(float) : 0;
+    }
+
+    // Access nodes of a junction (dense index), leaving it or arriving at it
+    int accessCount(int index, bool forward) const
+    {
+        const uint32_t* offset = forward ? forwardOffset : backwardOffset;
+        return header ? offset[index + 1] - offset[index] : 0;
+    }
+};
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// Fixed-size pool of worker threads. Each task receives the index of the
+// worker running it, so callers can keep per-worker state (for example a
+// Graph::SearchWorkspace) in a plain vector without any locking.
+class WorkerPool
+{
+
+private:
+    vector<thread> workers;
+    queue<function<void(size_t)>> tasks;
+    mutex lock;
+    condition_variable ready;
+    bool stopping;
+
+    void run(size_t worker)
+    {
+        while (true)
+        {
+            function<void(size_t)> task;
+            {
+                unique_lock<mutex> guard(lock);
+                ready.wait(guard, [this] { return stopping || !tasks.empty(); });
+
+                if (stopping && tasks.empty())
+                {
+                    return;
+                }
+
+                task = move(tasks.front());
+                tasks.pop();
+            }
+
+            task(worker);
+        }
+    }
+
+public:
+    explicit WorkerPool(size_t count) : stopping(false)
+    {
+        if (count == 0)
+        {
+            count = 1;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            workers.emplace_back(&WorkerPool::run, this, i);
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    ~WorkerPool()
+    {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        ready.notify_all();
+
+        for (auto& w : workers)
+        {
+            w.join();
+        }
+    }
+
+    void submit(function<void(size_t)> task)
+    {
+        {
+            lock_guard<mutex> guard(lock);
+            tasks.push(move(task));
+        }
+        ready.notify_one();
+    }
+
+    size_t size() const
+    {
+        return workers.size();
+    }
+};
+
+#endif
@@ -0,0 +1,53 @@
+// Offline build of the junction name dictionary the server maps at
+// startup (see src/namefst.h). Run it whenever data/junctions.json
+// changes; the server rebuilds the file itself if it finds it stale.
+//
+// Build: g++ -std=c++17 -O2 -o build_names tools/build_names.cpp
+// Run:   ./build_names [data/junctions.json] [data/names.fst]
+
+#include <fstream>
+#include <iostream>
+#include "../include/json.hpp"
+#include "../src/namefst.h"
+
+using namespace std;
+using json = nlohmann::json;
+
+int main(int argc, char** argv)
+{
+    string input = argc > 1 ? argv[1] : "data/junctions.json";
+    string output = argc > 2 ? argv[2] : "data/names.fst";
+
+    ifstream file(input);
+
+    if (!file.is_open())
+    {
+        cout << "[ERROR] Could not open " << input << endl;
+        return 1;
+    }
+
+    json data;
+    file >> data;
+
+    // Same pairs, in file order, as the server collects when loading
+    vector<pair<string, uint32_t>> entries;
+
+    for (auto& j : data["junctions"])
+    {
+        entries.push_back({j["name"].get<string>(), j["id"].get<uint32_t>()});
+    }
+
+    if (!NameFST::build(entries, output))
+    {
+        return 1;
+    }
+
+    NameFST check;
+
+    if (!check.load(output, NameFST::signatureOf(entries)))
+    {
+        cout << "[ERROR] " << output << " does not read back" << endl;
+        return 1;
+    }
+    return 0;
+}